@@ -29,6 +29,38 @@
 #ifndef FPGA_CTRL_PERFIDS_H
 #define FPGA_CTRL_PERFIDS_H
 
-#define FPGA_CTRL_PERF_ID 92
+#define FPGA_CTRL_PERF_ID 92 // Main task, out while it pends on the pipes
+
+/*
+** Phases, each bracketed by an entry and exit marker. IDs 92-111 belong to FPGA Ctrl,
+** tools/fpga_ctrl_perf.py knows them by these names.
+*/
+
+/* Main task */
+#define FPGA_CTRL_CMD_PERF_ID    93 // Dispatching one ground command, handler included
+#define FPGA_CTRL_HK_PERF_ID     94 // Housekeeping request
+#define FPGA_CTRL_WAKEUP_PERF_ID 95 // Scheduler wakeup, the rate groups that came due
+#define FPGA_CTRL_JOBS_PERF_ID   96 // One slice of the long running jobs
+
+/* AES core, driven from an encryption job */
+#define FPGA_CTRL_AES_LOAD_PERF_ID 97 // Writing the key and plaintext and starting the core
+#define FPGA_CTRL_AES_WAIT_PERF_ID 98 // From AP_START until AP_DONE is seen or the job gives up
+
+/* Interrupt child task */
+#define FPGA_CTRL_IRQ_TASK_PERF_ID    99  // Interrupt task, out while it blocks for an interrupt or is paused
+#define FPGA_CTRL_IRQ_SERVICE_PERF_ID 100 // From poll() returning until the interrupt is handled
+#define FPGA_CTRL_IRQ_POLL_PERF_ID    101 // One busy-poll pass in poll mode
+
+/* Reprogram child task */
+#define FPGA_CTRL_REPROGRAM_PERF_ID 102 // The whole reload
+#define FPGA_CTRL_STAGE_PERF_ID     103 // Copying or decompressing the bitstream into the firmware directory
+#define FPGA_CTRL_VERIFY_PERF_ID    104 // CRC-32C of the staged image
+#define FPGA_CTRL_PROGRAM_PERF_ID   105 // FPGA manager or overlay writing the fabric
+#define FPGA_CTRL_REMAP_PERF_ID     106 // Registering the cores and reopening the interrupt device
+
+/* Sampling and timed command child tasks */
+#define FPGA_CTRL_SAMPLE_PERF_ID       107 // Taking one sample
+#define FPGA_CTRL_SAMPLE_WRITE_PERF_ID 108 // Writer emitting the full blocks
+#define FPGA_CTRL_TIMED_PERF_ID        109 // Releasing the time tagged commands that came due
 
 #endif /* FPGA_CTRL_PERFIDS_H */
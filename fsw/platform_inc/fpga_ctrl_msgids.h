@@ -32,11 +32,22 @@
 #define FPGA_CTRL_MSGIDS_H
 
 /* V1 Command Message IDs must be 0x18xx */
-#define FPGA_CTRL_CMD_MID     0x1892
-#define FPGA_CTRL_SEND_HK_MID 0x1893
+#define FPGA_CTRL_CMD_MID          0x1892
+#define FPGA_CTRL_SEND_HK_MID      0x1893
+#define FPGA_CTRL_PRIORITY_CMD_MID 0x1894 // Control commands, served ahead of FPGA_CTRL_CMD_MID
+#define FPGA_CTRL_WAKEUP_MID       0x1895 // From the scheduler, runs the rate groups
 
 /* V1 Telemetry Message IDs must be 0x08xx */
-#define FPGA_CTRL_HK_TLM_MID  0x0893
-#define FPGA_CTRL_INT_TLM_MID 0x0894 // Message ID for when the FPGA sends a hardware interrupt
+#define FPGA_CTRL_HK_TLM_MID        0x0893
+#define FPGA_CTRL_INT_TLM_MID       0x0894 // Message ID for when the FPGA sends a hardware interrupt
+#define FPGA_CTRL_SAMPLE_TLM_MID    0x0895 // Run-length encoded GPIO sample blocks
+#define FPGA_CTRL_LOADGEN_TLM_MID   0x0896 // Interrupt load generator statistics
+#define FPGA_CTRL_REPROGRAM_TLM_MID 0x0897 // Bitstream reload state and progress
+#define FPGA_CTRL_REGION_TLM_MID    0x0898 // Partial reconfiguration region occupancy and overhead
+#define FPGA_CTRL_CMD_STATS_TLM_MID 0x0899 // Per command code counts, errors and handler time
+#define FPGA_CTRL_BATCH_TLM_MID     0x089A // Aggregate status and per-item results of a batch command
+#define FPGA_CTRL_RATE_TLM_MID      0x089B // Rate group run counts, overruns and timing
+#define FPGA_CTRL_TIMED_TLM_MID     0x089C // Time-tagged command queue size and release jitter
+#define FPGA_CTRL_PROFILE_TLM_MID   0x089D // Per command code calls, wall and CPU time
 
 #endif /* FPGA_CTRL_MSGIDS_H */
@@ -29,6 +29,75 @@
 #ifndef FPGA_CTRL_TABLE_H
 #define FPGA_CTRL_TABLE_H
 
+/*
+** Real-time scheduling profile for the main and interrupt child tasks. Zero leaves a setting at its default.
+*/
+typedef struct
+{
+    uint16 MainPriority;       // OSAL priority for the main task
+    uint16 IrqTaskPriority;    // OSAL priority for the interrupt child task
+    uint32 IrqTaskStackSize;   // Stack size for the interrupt child task
+    uint32 MainCpuMask;        // Cores the main task may run on, bit n = CPU n
+    uint32 IrqTaskCpuMask;     // Cores the interrupt child task may run on
+    uint16 UioIrqNumber;       // Linux IRQ behind /dev/uio0, steered to IrqTaskCpuMask
+    uint8  LockMemory;         // boolean, mlockall() the whole process
+    uint8  PrefaultStack;      // boolean, touch StackPrefaultBytes of each task's stack at startup
+    uint32 StackPrefaultBytes;
+} FPGA_CTRL_SchedProfile_t;
+
+/*
+** Cores a bitstream provides, one descriptor per register window. After a load the app maps all of them and finds
+** them by type, so a type appears at most once per bitstream.
+*/
+#define FPGA_CTRL_MAX_ACCELS 6
+
+#define FPGA_CTRL_ACCEL_NONE     0 // Unused descriptor
+#define FPGA_CTRL_ACCEL_AES_CTRL 1 // AES core control register
+#define FPGA_CTRL_ACCEL_AES_IN   2 // AES key and plaintext
+#define FPGA_CTRL_ACCEL_AES_OUT  3 // AES cyphertext
+#define FPGA_CTRL_ACCEL_GPIO_BTN 4 // AXI GPIO for the buttons, raises the interrupt
+#define FPGA_CTRL_ACCEL_GPIO_SW  5 // AXI GPIO for the switches
+#define FPGA_CTRL_ACCEL_TYPES    6
+
+#define FPGA_CTRL_ACCEL_NO_UIO 0xFF
+
+typedef struct
+{
+    uint8  Type;     // FPGA_CTRL_ACCEL_*
+    uint8  UioIndex; // Interrupt delivered through /dev/uioN, FPGA_CTRL_ACCEL_NO_UIO if none
+    uint8  Padding[2];
+    uint32 Base;     // Physical address of the register window
+    uint32 Range;    // Bytes to map
+} FPGA_CTRL_AccelDesc_t;
+
+/*
+** Bitstreams known by name. Preloaded ones are mapped into the bitstream cache at startup, the rest on first use.
+** This is also the manifest bitstreams are checked against before programming, loads by path use the entry with
+** the same Path.
+**
+** Partial bitstreams (Region != 0) are reconfigurable modules for one region of the full design. They're loaded by
+** applying their device tree overlay, which names the partial bitstream as its firmware, and only their own cores
+** go down while it's applied.
+*/
+#define FPGA_CTRL_MAX_REGIONS        2
+#define FPGA_CTRL_MAX_BITSTREAMS     8
+#define FPGA_CTRL_BITSTREAM_NAME_LEN 16
+#define FPGA_CTRL_BITSTREAM_PATH_LEN 64
+#define FPGA_CTRL_METRICS_PATH_LEN   64
+
+typedef struct
+{
+    char   Name[FPGA_CTRL_BITSTREAM_NAME_LEN]; // Empty marks an unused entry
+    char   Path[FPGA_CTRL_BITSTREAM_PATH_LEN];
+    uint8  Preload;                            // boolean
+    uint8  Region;                             // 0 = full bitstream, n = module for reconfigurable region n
+    uint8  Padding[2];
+    uint32 Crc32c;                             // CRC-32C of the decompressed image, 0 skips the check
+
+    char                  Overlay[FPGA_CTRL_BITSTREAM_PATH_LEN]; // Partial bitstreams only, overlay that loads it
+    FPGA_CTRL_AccelDesc_t Accels[FPGA_CTRL_MAX_ACCELS];
+} FPGA_CTRL_BitstreamEntry_t;
+
 /*
 ** Table structure
 */
@@ -37,6 +106,29 @@ typedef struct
     uint16 Int1;
     uint16 Int2;
 
+    /*
+    ** Adaptive interrupt/polling mode for the interrupt child task (NAPI-style)
+    */
+    uint32 IrqPollEnterRate;  // Interrupts per second above which IER is masked and the GPIO is polled, 0 = never
+    uint16 IrqPollBudget;     // Maximum GPIO data register reads per busy-poll pass
+    uint16 IrqPollIdleExitMs; // Go back to interrupts after this many ms without a GPIO change
+
+    FPGA_CTRL_SchedProfile_t Sched;
+
+    uint32                     BitstreamCacheLimit; // Bytes of bitstreams kept in memory, least recently used go first
+    uint8                      RequireBitstreamCrc; // boolean, refuse bitstreams without a Crc32c in the table
+    uint8                      Padding[3];
+    char                       BootBitstream[FPGA_CTRL_BITSTREAM_NAME_LEN]; // Loaded at boot, empty = built-in layout
+    uint16                     RegionMinBatch;  // Queued jobs a module needs before its region is reconfigured
+    uint16                     RegionMaxWaitMs; // A job waiting this long gets its module loaded whatever the batch
+    uint16                     DrainMaxMsgs;    // Messages handled per wakeup before pending again, 0 = one at a time
+    uint16                     DrainBudgetUs;   // Time budget per wakeup, 0 = only the message count limits it
+    uint16                     RateBudgetUs;    // Time the rate groups get per scheduler wakeup, 0 = unlimited
+    uint16                     JobSliceUs;      // Time long commands get between pipe reads, 0 = one step each
+    uint32                     MetricsPeriodMs; // Time between metrics exports, 0 = every scheduler wakeup
+    char                       MetricsPath[FPGA_CTRL_METRICS_PATH_LEN]; // Prometheus text file, empty = no export
+    FPGA_CTRL_BitstreamEntry_t Bitstreams[FPGA_CTRL_MAX_BITSTREAMS];
+
 } FPGA_CTRL_Table_t;
 
 #endif /* FPGA_CTRL_TABLE_H */
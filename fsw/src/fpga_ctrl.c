@@ -28,6 +28,7 @@
 /*
 ** Include Files:
 */
+#include <stddef.h>
 #include <string.h>
 
 // Platform specific includes
@@ -42,30 +43,94 @@
 #include "fpga_ctrl_table.h"
 #include "fpga_ctrl_version.h"
 
+#include "fpga_ctrl_stats.h"
+#include "fpga_ctrl_trace.h"
+#include "fpga_ctrl_sched.h"
+#include "fpga_ctrl_pipes.h"
+#include "fpga_ctrl_accel.h"
+#include "fpga_ctrl_irq_source.h"
+#include "fpga_ctrl_metrics.h"
 #include "fpga_ctrl_interrupts.h"
+#include "fpga_ctrl_irq_loadgen.h"
+#include "fpga_ctrl_job.h"
 #include "fpga_ctrl_aes.h"
+#include "fpga_ctrl_sampling.h"
+#include "fpga_ctrl_crc32c.h"
+#include "fpga_ctrl_bitstream_cache.h"
+#include "fpga_ctrl_lz4.h"
 #include "fpga_ctrl_load_bitstream.h"
+#include "fpga_ctrl_region.h"
+#include "fpga_ctrl_rate.h"
+#include "fpga_ctrl_timed.h"
+#include "fpga_ctrl_profile.h"
 #include "mmio_lib.h"
 
 /* The sample_lib module provides the SAMPLE_LIB_Function() prototype */
 // #include "sample_lib.h"
 
 static int32 FPGA_CTRL_Init(void);
+static int32 FPGA_CTRL_ReceiveNext(CFE_SB_Buffer_t **SBBufPtr, int32 TimeOut);
+static int32 FPGA_CTRL_ReceivePolled(CFE_SB_Buffer_t **SBBufPtr);
+static void  FPGA_CTRL_DrainPipes(int64 WakeNs);
+static void  FPGA_CTRL_LoadDrainBudget(void);
+static int32 FPGA_CTRL_AggregateStats(void);
+static int32 FPGA_CTRL_ExportMetrics(void);
 static void  FPGA_CTRL_ProcessCommandPacket(CFE_SB_Buffer_t *SBBufPtr);
-static void  FPGA_CTRL_ProcessGroundCommand(CFE_SB_Buffer_t *SBBufPtr);
+static void  FPGA_CTRL_ProcessGroundCommand(CFE_SB_Buffer_t *SBBufPtr, bool Priority);
+static int32 FPGA_CTRL_RunCommand(CFE_SB_Buffer_t *SBBufPtr, CFE_MSG_FcnCode_t CommandCode, bool Priority);
+static int32 FPGA_CTRL_Batch(CFE_SB_Buffer_t const *SBBufPtr);
 static int32 FPGA_CTRL_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg);
 static int32 FPGA_CTRL_ResetCounters(const FPGA_CTRL_ResetCountersCmd_t *Msg);
 static int32 FPGA_CTRL_Process(const FPGA_CTRL_ProcessCmd_t *Msg);
 static int32 FPGA_CTRL_Noop(const FPGA_CTRL_NoopCmd_t *Msg);
 static void  FPGA_CTRL_GetCrc(const char *TableName);
 static int32 FPGA_CTRL_TblValidationFunc(void *TblData);
-static bool  FPGA_CTRL_VerifyCmdLength(CFE_MSG_Message_t *MsgPtr, size_t ExpectedLength);
+static bool  FPGA_CTRL_VerifyCmdLength(CFE_MSG_Message_t *MsgPtr, size_t MinLength, size_t MaxLength);
 
 /*
 ** global data
 */
 FPGA_CTRL_Data_t globalState;
 
+/*
+** Dispatch statistics by command code, only touched by the main task
+*/
+static FPGA_CTRL_CmdStatsTlm_t cmdStatsTlm;
+
+/*
+** Ground commands by command code, defined with the handlers further down
+*/
+static FPGA_CTRL_CmdDesc_t const FPGA_CTRL_CmdTable[FPGA_CTRL_CC_COUNT];
+
+/*
+** How much the main task handles per wakeup, from the table, and where its time goes
+*/
+static struct
+{
+    uint16 MaxMsgs;
+    uint16 BudgetUs;
+    uint64 WaitNs;
+    uint64 HandlingNs;
+    uint64 LastWaitNs; // Totals when the stats were last aggregated
+    uint64 LastHandlingNs;
+} drainState;
+
+/*
+** Which pipe each message ID is read from. Messages off the priority pipe are handled before any queued command, so
+** housekeeping requests, wakeups and control commands wait behind at most the one command being handled.
+*/
+static struct
+{
+    CFE_SB_MsgId_Atom_t MsgId;
+    bool                Priority;
+    char const         *Name;
+} const FPGA_CTRL_PipePolicy[] = {
+    {FPGA_CTRL_SEND_HK_MID, true, "HK request"},
+    {FPGA_CTRL_PRIORITY_CMD_MID, true, "priority command"},
+    {FPGA_CTRL_WAKEUP_MID, true, "wakeup"},
+    {FPGA_CTRL_CMD_MID, false, "command"},
+};
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *  * *  * * * * **/
 /* FPGA_CTRL_Main() -- Application entry point and main process loop         */
 /*                                                                            */
@@ -101,8 +166,12 @@ void FPGA_CTRL_Main(void)
         */
         CFE_ES_PerfLogExit(FPGA_CTRL_PERF_ID);
 
-        /* Pend on receipt of command packet */
-        status = CFE_SB_ReceiveBuffer(&SBBufPtr, globalState.CommandPipe, CFE_SB_PEND_FOREVER);
+        /* Pend on receipt of command packet, only briefly while long commands have work left */
+        int64 const waitStartNs = FPGA_CTRL_MonotonicNs();
+        status                  = FPGA_CTRL_ReceiveNext(&SBBufPtr, FPGA_CTRL_JobsPending() ? FPGA_CTRL_JOB_PEND_MS
+                                                                                   : CFE_SB_PEND_FOREVER);
+        int64 const wakeNs      = FPGA_CTRL_MonotonicNs();
+        drainState.WaitNs += wakeNs - waitStartNs;
 
         /*
         ** Performance Log Entry Stamp
@@ -112,14 +181,26 @@ void FPGA_CTRL_Main(void)
         if (status == CFE_SUCCESS)
         {
             FPGA_CTRL_ProcessCommandPacket(SBBufPtr);
+            FPGA_CTRL_DrainPipes(wakeNs);
         }
-        else
+        else if (status != CFE_SB_TIME_OUT)
         {
             CFE_EVS_SendEvent(FPGA_CTRL_PIPE_ERR_EID, CFE_EVS_EventType_ERROR,
                               "FPGA CTRL: SB Pipe Read Error, App Will Exit");
 
             globalState.RunStatus = CFE_ES_RunStatus_APP_ERROR;
         }
+
+        /* Then the next slice of any long commands */
+        if (FPGA_CTRL_JobsPending())
+        {
+            FPGA_CTRL_ProfileMark_t mark;
+            CFE_ES_PerfLogEntry(FPGA_CTRL_JOBS_PERF_ID);
+            FPGA_CTRL_ProfileStart(&mark);
+            FPGA_CTRL_RunJobs();
+            drainState.HandlingNs += (uint64)FPGA_CTRL_ProfileStop(FPGA_CTRL_PROFILE_JOBS, "JOBS", &mark) * 1000;
+            CFE_ES_PerfLogExit(FPGA_CTRL_JOBS_PERF_ID);
+        }
     }
 
     /*
@@ -127,6 +208,10 @@ void FPGA_CTRL_Main(void)
     */
     CFE_ES_PerfLogExit(FPGA_CTRL_PERF_ID);
 
+    FPGA_CTRL_CleanupTimedQueue();
+    FPGA_CTRL_CleanupInterrupts();
+    FPGA_CTRL_ClearAccelRegistry();
+
     CFE_ES_ExitApp(globalState.RunStatus);
 
 } /* End of FPGA_CTRL_Main() */
@@ -145,11 +230,19 @@ static int32 FPGA_CTRL_Init(void)
     /*
     ** Initialize app command execution counters
     */
-    globalState.CmdCounter          = 0;
-    globalState.ErrCounter          = 0;
-    globalState.childTaskRunning    = false;
-    globalState.childTaskShouldExit = true;
-    globalState.childTaskId         = CFE_ES_TASKID_UNDEFINED;
+    globalState.CmdCounter  = 0;
+    globalState.ErrCounter  = 0;
+    globalState.fabricState = FPGA_CTRL_FABRIC_READY;
+    globalState.fabricUp    = true; // Whatever was loaded at boot
+
+    /* No child tasks yet, the blocks can be set directly */
+    memset(&globalState.IrqStats, 0, sizeof(globalState.IrqStats));
+    memset(&globalState.SampleStats, 0, sizeof(globalState.SampleStats));
+    memset(&globalState.SampleWriterStats, 0, sizeof(globalState.SampleWriterStats));
+    memset(&globalState.BitstreamStats, 0, sizeof(globalState.BitstreamStats));
+    globalState.IrqStats.mode = FPGA_CTRL_IRQ_MODE_INTERRUPT;
+
+    FPGA_CTRL_ResetProfile();
     snprintf(globalState.cyphertextHexString, 16 * 2 + 1, "Nothing_encrypted");
 
     /*
@@ -160,6 +253,11 @@ static int32 FPGA_CTRL_Init(void)
     strncpy(globalState.PipeName, "FPGA_CTRL_CMD_PIPE", sizeof(globalState.PipeName));
     globalState.PipeName[sizeof(globalState.PipeName) - 1] = 0;
 
+    globalState.PriorityPipeDepth = FPGA_CTRL_PRIORITY_PIPE_DEPTH;
+
+    strncpy(globalState.PriorityPipeName, "FPGA_CTRL_PRIO_PIPE", sizeof(globalState.PriorityPipeName));
+    globalState.PriorityPipeName[sizeof(globalState.PriorityPipeName) - 1] = 0;
+
     /*
     ** Initialize event filter table...
     */
@@ -195,7 +293,7 @@ static int32 FPGA_CTRL_Init(void)
                  sizeof(globalState.HkTlm));
 
     /*
-    ** Create Software Bus message pipe.
+    ** Create Software Bus message pipes.
     */
     status = CFE_SB_CreatePipe(&globalState.CommandPipe, globalState.PipeDepth, globalState.PipeName);
     if (status != CFE_SUCCESS)
@@ -204,25 +302,28 @@ static int32 FPGA_CTRL_Init(void)
         return (status);
     }
 
-    /*
-    ** Subscribe to Housekeeping request commands
-    */
-    status = CFE_SB_Subscribe(CFE_SB_ValueToMsgId(FPGA_CTRL_SEND_HK_MID), globalState.CommandPipe);
+    status =
+        CFE_SB_CreatePipe(&globalState.PriorityPipe, globalState.PriorityPipeDepth, globalState.PriorityPipeName);
     if (status != CFE_SUCCESS)
     {
-        CFE_ES_WriteToSysLog("FPGA Ctrl: Error Subscribing to HK request, RC = 0x%08lX\n", (unsigned long)status);
+        CFE_ES_WriteToSysLog("FPGA Ctrl: Error creating priority pipe, RC = 0x%08lX\n", (unsigned long)status);
         return (status);
     }
 
     /*
-    ** Subscribe to ground command packets
+    ** Subscribe to housekeeping requests and command packets, each on the pipe the policy gives it
     */
-    status = CFE_SB_Subscribe(CFE_SB_ValueToMsgId(FPGA_CTRL_CMD_MID), globalState.CommandPipe);
-    if (status != CFE_SUCCESS)
+    for (size_t i = 0; i < sizeof(FPGA_CTRL_PipePolicy) / sizeof(FPGA_CTRL_PipePolicy[0]); ++i)
     {
-        CFE_ES_WriteToSysLog("FPGA Ctrl: Error Subscribing to Command, RC = 0x%08lX\n", (unsigned long)status);
-
-        return (status);
+        status = CFE_SB_Subscribe(CFE_SB_ValueToMsgId(FPGA_CTRL_PipePolicy[i].MsgId),
+                                  FPGA_CTRL_PipePolicy[i].Priority ? globalState.PriorityPipe
+                                                                   : globalState.CommandPipe);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_ES_WriteToSysLog("FPGA Ctrl: Error Subscribing to %s, RC = 0x%08lX\n", FPGA_CTRL_PipePolicy[i].Name,
+                                 (unsigned long)status);
+            return (status);
+        }
     }
 
     /*
@@ -241,6 +342,63 @@ static int32 FPGA_CTRL_Init(void)
         status = CFE_TBL_Load(globalState.TblHandles[0], CFE_TBL_SRC_FILE, FPGA_CTRL_TABLE_FILE);
     }
 
+    /*
+    ** Apply the real-time scheduling profile before any child tasks exist
+    */
+    FPGA_CTRL_LoadSchedProfile();
+    FPGA_CTRL_ApplyMainSchedProfile();
+    FPGA_CTRL_LoadDrainBudget();
+    FPGA_CTRL_LoadRateBudget();
+    FPGA_CTRL_LoadJobSlice();
+    FPGA_CTRL_LoadMetricsConfig();
+
+    /*
+    ** Start reading the pipes, nothing is received without their relays
+    */
+    status = FPGA_CTRL_StartPipeRelays(globalState.PriorityPipe, globalState.CommandPipe);
+    if (status != CFE_SUCCESS)
+    {
+        return (status);
+    }
+
+    /*
+    ** Map the cores of the design loaded at boot, the interrupt device comes from them
+    */
+    FPGA_CTRL_InitAccelRegistry();
+    FPGA_CTRL_InitRegions();
+
+    /*
+    ** Start the interrupt child task, paused until interrupts are enabled.
+    ** Not fatal, the rest of the app works without the GPIO interrupt.
+    */
+    status = FPGA_CTRL_InitInterrupts();
+    if (status != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("FPGA Ctrl: Interrupts unavailable, RC = 0x%08lX\n", (unsigned long)status);
+    }
+
+    /*
+    ** Start the child that releases time-tagged commands. Not fatal, they're rejected without it.
+    */
+    status = FPGA_CTRL_InitTimedQueue();
+    if (status != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("FPGA Ctrl: Time-tagged commands unavailable, RC = 0x%08lX\n", (unsigned long)status);
+    }
+
+    /*
+    ** Periodic work, run from the scheduler's wakeups. Nothing runs without a scheduler, housekeeping only
+    ** reports what these last left.
+    */
+    FPGA_CTRL_RegisterRateItem("region", FPGA_CTRL_RegionSchedule, 1, 500);
+    FPGA_CTRL_RegisterRateItem("stats", FPGA_CTRL_AggregateStats, 10, 50);
+    FPGA_CTRL_RegisterRateItem("metrics", FPGA_CTRL_ExportMetrics, 1, 2000);
+
+    /*
+    ** Map the preloaded bitstreams so the first switch doesn't read storage
+    */
+    FPGA_CTRL_InitBitstreamCache();
+
     CFE_EVS_SendEvent(FPGA_CTRL_STARTUP_INF_EID, CFE_EVS_EventType_INFORMATION, "FPGA Ctrl Initialized.%s",
                       FPGA_CTRL_VERSION_STRING);
 
@@ -248,6 +406,342 @@ static int32 FPGA_CTRL_Init(void)
 
 } /* End of FPGA_CTRL_Init() */
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  FPGA_CTRL_ReceiveNext                                              */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*     Takes the next message, a priority one while there are any and        */
+/*     otherwise the oldest command. Sleeps until a message arrives on        */
+/*     either pipe when nothing is queued, returning CFE_SB_TIME_OUT after    */
+/*     TimeOut ms.                                                            */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static int32 FPGA_CTRL_ReceiveNext(CFE_SB_Buffer_t **SBBufPtr, int32 TimeOut)
+{
+    return FPGA_CTRL_PipeReceive(SBBufPtr, TimeOut);
+
+} /* End FPGA_CTRL_ReceiveNext */
+
+/*
+** The next message if there is one, CFE_SB_NO_MESSAGE if nothing is queued
+*/
+static int32 FPGA_CTRL_ReceivePolled(CFE_SB_Buffer_t **SBBufPtr)
+{
+    return FPGA_CTRL_PipeReceive(SBBufPtr, CFE_SB_POLL);
+
+} /* End FPGA_CTRL_ReceivePolled */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  FPGA_CTRL_DrainPipes                                               */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*     Handles whatever else is already queued after a wakeup, polling until  */
+/*     nothing is queued or the table's message or time budget runs out,     */
+/*     so a burst costs one wakeup and perf log pair instead of one each.     */
+/*     A drain cut short yields the CPU before the next one, so the other     */
+/*     apps at this priority still get to run.                                */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static void FPGA_CTRL_DrainPipes(int64 WakeNs)
+{
+    CFE_SB_Buffer_t *SBBufPtr;
+    uint32           handled  = 1; // The message that woke the task
+    bool             cutShort = false;
+    int64 const      budgetNs = (int64)drainState.BudgetUs * 1000;
+
+    while (true)
+    {
+        if (handled >= drainState.MaxMsgs)
+        {
+            ++cmdStatsTlm.drainCountLimited;
+            cutShort = true;
+            break;
+        }
+
+        if (budgetNs != 0 && FPGA_CTRL_MonotonicNs() - WakeNs >= budgetNs)
+        {
+            ++cmdStatsTlm.drainTimeLimited;
+            cutShort = true;
+            break;
+        }
+
+        /* A read error is left for the next pend to report */
+        if (FPGA_CTRL_ReceivePolled(&SBBufPtr) != CFE_SUCCESS)
+        {
+            break;
+        }
+
+        FPGA_CTRL_ProcessCommandPacket(SBBufPtr);
+        ++handled;
+    }
+
+    uint32 const bucket = handled <= 1 ? 0 : 32 - __builtin_clz(handled - 1);
+    ++cmdStatsTlm.drainHist[bucket < FPGA_CTRL_DRAIN_HIST_BUCKETS ? bucket : FPGA_CTRL_DRAIN_HIST_BUCKETS - 1];
+    ++cmdStatsTlm.wakeups;
+    drainState.HandlingNs += FPGA_CTRL_MonotonicNs() - WakeNs;
+
+    if (cutShort)
+    {
+        sched_yield();
+    }
+
+    return;
+
+} /* End FPGA_CTRL_DrainPipes */
+
+/*
+** Copies the drain budget out of the table, at startup and after each table update
+*/
+static void FPGA_CTRL_LoadDrainBudget(void)
+{
+    FPGA_CTRL_Table_t *TblPtr;
+
+    drainState.MaxMsgs  = 1;
+    drainState.BudgetUs = 0;
+
+    if (CFE_TBL_GetAddress((void **)&TblPtr, globalState.TblHandles[0]) < CFE_SUCCESS)
+    {
+        return;
+    }
+
+    drainState.MaxMsgs  = TblPtr->DrainMaxMsgs != 0 ? TblPtr->DrainMaxMsgs : 1;
+    drainState.BudgetUs = TblPtr->DrainBudgetUs;
+
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+
+} /* End FPGA_CTRL_LoadDrainBudget */
+
+/*
+** Folds the main task's time accounting into the dispatch statistics, a rate group item
+*/
+static int32 FPGA_CTRL_AggregateStats(void)
+{
+    uint64 const waitNs     = drainState.WaitNs - drainState.LastWaitNs;
+    uint64 const handlingNs = drainState.HandlingNs - drainState.LastHandlingNs;
+
+    if (waitNs + handlingNs != 0)
+    {
+        cmdStatsTlm.loadPct = (uint32)(handlingNs * 100 / (waitNs + handlingNs));
+    }
+    cmdStatsTlm.pipeWaitMs = (uint32)(drainState.WaitNs / 1000000);
+    cmdStatsTlm.handlingMs = (uint32)(drainState.HandlingNs / 1000000);
+
+    drainState.LastWaitNs     = drainState.WaitNs;
+    drainState.LastHandlingNs = drainState.HandlingNs;
+
+    return CFE_SUCCESS;
+
+} /* End FPGA_CTRL_AggregateStats */
+
+/*
+** Writes every counter, gauge and histogram the app keeps to the metrics file, a rate group item that only does
+** anything once per metrics period. Child task statistics are snapshotted the way housekeeping does.
+*/
+static int32 FPGA_CTRL_ExportMetrics(void)
+{
+    static FPGA_CTRL_MetricsFile_t       file;
+    static FPGA_CTRL_IrqStats_t          irqStats; // Kept between exports, see FPGA_CTRL_StatsRead
+    static FPGA_CTRL_SampleStats_t       sampleStats;
+    static FPGA_CTRL_SampleWriterStats_t sampleWriterStats;
+    static FPGA_CTRL_BitstreamStats_t    bitstreamStats;
+    FPGA_CTRL_PipeStats_t                pipeStats[FPGA_CTRL_PIPE_CLASSES];
+    uint32                               timedQueued = 0;
+    char                                 labels[64];
+    int32                                status;
+
+    if (!FPGA_CTRL_MetricsDue())
+    {
+        return CFE_SUCCESS;
+    }
+    if ((status = FPGA_CTRL_MetricsOpen(&file)) != CFE_SUCCESS)
+    {
+        return status;
+    }
+
+    FPGA_CTRL_StatsRead(&irqStats, &globalState.IrqStats, sizeof(irqStats));
+    FPGA_CTRL_StatsRead(&sampleStats, &globalState.SampleStats, sizeof(sampleStats));
+    FPGA_CTRL_StatsRead(&sampleWriterStats, &globalState.SampleWriterStats, sizeof(sampleWriterStats));
+    FPGA_CTRL_StatsRead(&bitstreamStats, &globalState.BitstreamStats, sizeof(bitstreamStats));
+    FPGA_CTRL_PipeStatsRead(pipeStats);
+    if (timedQueue.syncCreated)
+    {
+        pthread_mutex_lock(&timedQueue.lock);
+        timedQueued = timedQueue.queued;
+        pthread_mutex_unlock(&timedQueue.lock);
+    }
+
+    /*
+    ** Commands, and where the main task's time goes
+    */
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_commands_received_total", "counter",
+                            "Ground commands received, whether or not they were accepted");
+    for (uint32 cc = 0; cc < FPGA_CTRL_CC_COUNT; ++cc)
+    {
+        if (FPGA_CTRL_CmdTable[cc].handler == NULL)
+            continue;
+
+        snprintf(labels, sizeof(labels), "command=\"%s\"", FPGA_CTRL_CmdTable[cc].name);
+        FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_commands_received_total", labels, cmdStatsTlm.cmds[cc].count);
+    }
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_command_errors_total", "counter",
+                            "Ground commands rejected, or whose handler failed");
+    for (uint32 cc = 0; cc < FPGA_CTRL_CC_COUNT; ++cc)
+    {
+        if (FPGA_CTRL_CmdTable[cc].handler == NULL)
+            continue;
+
+        snprintf(labels, sizeof(labels), "command=\"%s\"", FPGA_CTRL_CmdTable[cc].name);
+        FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_command_errors_total", labels, cmdStatsTlm.cmds[cc].errors);
+    }
+
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_main_task_wall_microseconds", "histogram",
+                            "Main task wall time per command, housekeeping request, wakeup or job slice");
+    for (uint32 i = 0; i < FPGA_CTRL_PROFILE_ROWS; ++i)
+    {
+        FPGA_CTRL_ProfileRow_t const *const row = &cmdProfile.rows[i];
+        if (row->name == NULL)
+            continue;
+
+        snprintf(labels, sizeof(labels), "work=\"%s\"", row->name);
+        FPGA_CTRL_MetricsHistogram(&file, "fpga_ctrl_main_task_wall_microseconds", labels, row->wallHist,
+                                   FPGA_CTRL_PROFILE_BUCKETS, row->wallNs / 1000);
+    }
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_main_task_cpu_microseconds", "histogram",
+                            "Main task CPU time per command, housekeeping request, wakeup or job slice");
+    for (uint32 i = 0; i < FPGA_CTRL_PROFILE_ROWS; ++i)
+    {
+        FPGA_CTRL_ProfileRow_t const *const row = &cmdProfile.rows[i];
+        if (row->name == NULL)
+            continue;
+
+        snprintf(labels, sizeof(labels), "work=\"%s\"", row->name);
+        FPGA_CTRL_MetricsHistogram(&file, "fpga_ctrl_main_task_cpu_microseconds", labels, row->cpuHist,
+                                   FPGA_CTRL_PROFILE_BUCKETS, row->cpuNs / 1000);
+    }
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_main_task_load_percent", "gauge",
+                           "Share of the last stats interval the main task spent handling messages",
+                           cmdStatsTlm.loadPct);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_wakeups_total", "counter", "Scheduler wakeups run", rateGroups.wakeups);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_wakeup_overruns_total", "counter",
+                           "Scheduler wakeups whose periodic work took longer than its budget", rateGroups.overruns);
+
+    /*
+    ** Encryption
+    */
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_encrypt_latency_microseconds", "histogram",
+                            "AES core time from start to done");
+    FPGA_CTRL_MetricsHistogram(&file, "fpga_ctrl_encrypt_latency_microseconds", NULL, aesStats.latencyUs.buckets,
+                               FPGA_CTRL_METRICS_BUCKETS, aesStats.latencyUs.sum);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_encrypt_timeouts_total", "counter",
+                           "Encryptions given up on, the core never finished", aesStats.timeouts);
+
+    /*
+    ** Interrupts
+    */
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_irq_enabled", "gauge", "1 while GPIO interrupts are enabled",
+                           globalState.irqEnabled);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_irq_events_total", "counter", "GPIO events handled",
+                           irqStats.eventCount);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_irq_polling", "gauge", "1 while the GPIO is busy-polled", irqStats.mode);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_irq_mode_transitions_total", "counter",
+                           "Switches between interrupt and polling mode", irqStats.modeTransitions);
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_irq_mode_milliseconds_total", "counter", "Time spent in each mode");
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_irq_mode_milliseconds_total", "mode=\"interrupt\"",
+                            irqStats.interruptModeMs);
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_irq_mode_milliseconds_total", "mode=\"poll\"", irqStats.pollModeMs);
+
+    /*
+    ** Queue depths
+    */
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_pipe_messages_total", "counter", "Messages read, by pipe");
+    for (int c = 0; c < FPGA_CTRL_PIPE_CLASSES; ++c)
+    {
+        snprintf(labels, sizeof(labels), "pipe=\"%s\"", pipeRelays.relays[c].name);
+        FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_pipe_messages_total", labels, pipeStats[c].received);
+    }
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_pipe_depth_high_water", "gauge",
+                            "Most messages read off a pipe and not yet handled");
+    for (int c = 0; c < FPGA_CTRL_PIPE_CLASSES; ++c)
+    {
+        snprintf(labels, sizeof(labels), "pipe=\"%s\"", pipeRelays.relays[c].name);
+        FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_pipe_depth_high_water", labels, pipeStats[c].highWater);
+    }
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_pipe_backlogs_total", "counter",
+                            "Times messages were left waiting on a pipe, its queue full");
+    for (int c = 0; c < FPGA_CTRL_PIPE_CLASSES; ++c)
+    {
+        snprintf(labels, sizeof(labels), "pipe=\"%s\"", pipeRelays.relays[c].name);
+        FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_pipe_backlogs_total", labels, pipeStats[c].backlogs);
+    }
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_jobs_active", "gauge", "Long commands in progress", jobSched.active);
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_jobs_total", "counter", "Long commands finished, by outcome");
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_jobs_total", "result=\"completed\"", jobSched.completed);
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_jobs_total", "result=\"failed\"", jobSched.failed);
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_jobs_total", "result=\"cancelled\"", jobSched.cancelled);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_region_jobs_queued", "gauge",
+                           "Jobs waiting for their module to be loaded", regionSched.jobsQueued);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_region_jobs_dropped_total", "counter",
+                           "Jobs dropped, their queue was full or their module failed to load",
+                           regionSched.jobsDropped);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_timed_commands_queued", "gauge", "Time-tagged commands not yet due",
+                           timedQueued);
+
+    /*
+    ** Fabric, cores and bitstreams
+    */
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_fabric_up", "gauge", "1 while accelerator commands are accepted",
+                           atomic_load(&globalState.fabricUp));
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_fabric_state", "gauge", "Fabric state, FPGA_CTRL_FABRIC_*",
+                           atomic_load(&globalState.fabricState));
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_accels_mapped", "gauge", "Cores whose register window is mapped",
+                           (uint32)__builtin_popcount(globalState.accelMask));
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_accel_mappings_total", "counter", "Register window mappings, by outcome");
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_accel_mappings_total", "op=\"created\"",
+                            atomic_load_explicit(&accelMapStats.created, memory_order_relaxed));
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_accel_mappings_total", "op=\"deleted\"",
+                            atomic_load_explicit(&accelMapStats.deleted, memory_order_relaxed));
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_accel_mappings_total", "op=\"failed\"",
+                            atomic_load_explicit(&accelMapStats.failed, memory_order_relaxed));
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_bitstream_cache_lookups_total", "counter",
+                            "Bitstream cache lookups, by outcome");
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_bitstream_cache_lookups_total", "result=\"hit\"",
+                            bitstreamStats.cacheHits);
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_bitstream_cache_lookups_total", "result=\"miss\"",
+                            bitstreamStats.cacheMisses);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_bitstream_cache_bytes", "gauge", "Bytes of bitstreams held in memory",
+                           bitstreamStats.cacheBytes);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_bitstream_cache_entries", "gauge", "Bitstreams held in memory",
+                           bitstreamStats.cacheEntries);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_bitstream_verify_failures_total", "counter",
+                           "Bitstreams refused, their CRC didn't match the table", bitstreamStats.verifyFailures);
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_bitstream_last_phase_milliseconds", "gauge",
+                            "Time each phase of the last reload took");
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_bitstream_last_phase_milliseconds", "phase=\"stage\"",
+                            lastBitstreamTiming.stageMs);
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_bitstream_last_phase_milliseconds", "phase=\"verify\"",
+                            lastBitstreamTiming.verifyMs);
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_bitstream_last_phase_milliseconds", "phase=\"program\"",
+                            lastBitstreamTiming.programMs);
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_bitstream_last_phase_milliseconds", "phase=\"remap\"",
+                            lastBitstreamTiming.remapMs);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_bitstream_last_downtime_milliseconds", "gauge",
+                           "Time the fabric was down for the last reload", lastBitstreamTiming.downtimeMs);
+
+    /*
+    ** Sampling
+    */
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_sampling_active", "gauge", "1 while the sampler runs",
+                           sampler.samplerRunning);
+    FPGA_CTRL_MetricsFamily(&file, "fpga_ctrl_samples_total", "counter", "GPIO samples, by outcome");
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_samples_total", "result=\"taken\"", sampleStats.taken);
+    FPGA_CTRL_MetricsSample(&file, "fpga_ctrl_samples_total", "result=\"dropped\"", sampleStats.dropped);
+    FPGA_CTRL_MetricsValue(&file, "fpga_ctrl_sample_blocks_total", "counter", "Sample blocks written out",
+                           sampleWriterStats.blocks);
+
+    return FPGA_CTRL_MetricsPublish(&file);
+
+} /* End FPGA_CTRL_ExportMetrics */
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
 /*  Name:  FPGA_CTRL_ProcessCommandPacket                                    */
 /*                                                                            */
@@ -258,18 +752,35 @@ static int32 FPGA_CTRL_Init(void)
 /* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
 static void FPGA_CTRL_ProcessCommandPacket(CFE_SB_Buffer_t *SBBufPtr)
 {
-    CFE_SB_MsgId_t MsgId = CFE_SB_INVALID_MSG_ID;
+    CFE_SB_MsgId_t          MsgId = CFE_SB_INVALID_MSG_ID;
+    FPGA_CTRL_ProfileMark_t Mark;
 
     CFE_MSG_GetMsgId(&SBBufPtr->Msg, &MsgId);
 
     switch (CFE_SB_MsgIdToValue(MsgId))
     {
         case FPGA_CTRL_CMD_MID:
-            FPGA_CTRL_ProcessGroundCommand(SBBufPtr);
+            FPGA_CTRL_ProcessGroundCommand(SBBufPtr, false);
+            break;
+
+        case FPGA_CTRL_PRIORITY_CMD_MID:
+            FPGA_CTRL_ProcessGroundCommand(SBBufPtr, true);
             break;
 
         case FPGA_CTRL_SEND_HK_MID:
+            CFE_ES_PerfLogEntry(FPGA_CTRL_HK_PERF_ID);
+            FPGA_CTRL_ProfileStart(&Mark);
             FPGA_CTRL_ReportHousekeeping((CFE_MSG_CommandHeader_t *)SBBufPtr);
+            FPGA_CTRL_ProfileStop(FPGA_CTRL_PROFILE_HK, "HK", &Mark);
+            CFE_ES_PerfLogExit(FPGA_CTRL_HK_PERF_ID);
+            break;
+
+        case FPGA_CTRL_WAKEUP_MID:
+            CFE_ES_PerfLogEntry(FPGA_CTRL_WAKEUP_PERF_ID);
+            FPGA_CTRL_ProfileStart(&Mark);
+            FPGA_CTRL_RunRateGroups();
+            FPGA_CTRL_ProfileStop(FPGA_CTRL_PROFILE_WAKEUP, "WAKEUP", &Mark);
+            CFE_ES_PerfLogExit(FPGA_CTRL_WAKEUP_PERF_ID);
             break;
 
         default:
@@ -282,88 +793,283 @@ static void FPGA_CTRL_ProcessCommandPacket(CFE_SB_Buffer_t *SBBufPtr)
 
 } /* End FPGA_CTRL_ProcessCommandPacket */
 
+/*
+** Adapters from the dispatch table's handler type to each command's own, so handlers keep their typed arguments
+*/
+#define FPGA_CTRL_CMD_ADAPTER(Handler, CmdType)                         \
+    static int32 Handler##Cmd(CFE_SB_Buffer_t const *SBBufPtr)          \
+    {                                                                   \
+        return Handler((CmdType const *)SBBufPtr);                      \
+    }
+
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_Noop, FPGA_CTRL_NoopCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_ResetCounters, FPGA_CTRL_ResetCountersCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_Process, FPGA_CTRL_ProcessCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_SubmitEncrypt, FPGA_CTRL_EncryptCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_IntCtrl, FPGA_CTRL_IntCtrlCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_LoadBitstream, FPGA_CTRL_ReprogramCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_Sampling, FPGA_CTRL_SamplingCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_LoadGen, FPGA_CTRL_LoadGenCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_LoadNamedModule, FPGA_CTRL_ReprogramNamedCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_DumpProfile, FPGA_CTRL_ProfileDumpCmd_t)
+FPGA_CTRL_CMD_ADAPTER(FPGA_CTRL_TraceCtrl, FPGA_CTRL_TraceCmd_t)
+
+// Sent by the reprogram task as a load finishes, and before a full load to have the fabric taken down
+static int32 FPGA_CTRL_RegionScheduleCmd(CFE_SB_Buffer_t const *SBBufPtr)
+{
+    FPGA_CTRL_ServeReprogramJob();
+    return FPGA_CTRL_RegionSchedule();
+}
+
+// Tagged commands are released on the MID they'd be served from if sent now
+static int32 FPGA_CTRL_TimeTagCmd(CFE_SB_Buffer_t const *SBBufPtr)
+{
+    FPGA_CTRL_TimedCmd_t const *const Msg      = (FPGA_CTRL_TimedCmd_t const *)SBBufPtr;
+    bool                              priority = false;
+    size_t                            size     = 0;
+
+    CFE_MSG_GetSize(&SBBufPtr->Msg, &size);
+    if (Msg->fcnCode < FPGA_CTRL_CC_COUNT)
+        priority = (FPGA_CTRL_CmdTable[Msg->fcnCode].flags & FPGA_CTRL_CMD_PRIORITY) != 0;
+
+    return FPGA_CTRL_ScheduleTimedCmd(Msg, size, priority);
+}
+
+/*
+** Ground commands by command code. A new command is a message type, a handler and an entry here.
+*/
+static FPGA_CTRL_CmdDesc_t const FPGA_CTRL_CmdTable[FPGA_CTRL_CC_COUNT] = {
+    [FPGA_CTRL_NOOP_CC]            = {"NOOP", sizeof(FPGA_CTRL_NoopCmd_t), FPGA_CTRL_NoopCmd, FPGA_CTRL_CMD_PRIORITY},
+    [FPGA_CTRL_RESET_COUNTERS_CC]  = {"RESET_COUNTERS", sizeof(FPGA_CTRL_ResetCountersCmd_t),
+                                      FPGA_CTRL_ResetCountersCmd, FPGA_CTRL_CMD_UNCOUNTED | FPGA_CTRL_CMD_PRIORITY},
+    [FPGA_CTRL_PROCESS_CC]         = {"PROCESS", sizeof(FPGA_CTRL_ProcessCmd_t), FPGA_CTRL_ProcessCmd, 0},
+    [FPGA_CTRL_ENCRYPT_CC]         = {"ENCRYPT", sizeof(FPGA_CTRL_EncryptCmd_t), FPGA_CTRL_SubmitEncryptCmd,
+                                      FPGA_CTRL_CMD_NEEDS_FABRIC},
+    [FPGA_CTRL_INT_CTRL_CC]        = {"INT_CTRL", sizeof(FPGA_CTRL_IntCtrlCmd_t), FPGA_CTRL_IntCtrlCmd,
+                                      FPGA_CTRL_CMD_NEEDS_FABRIC | FPGA_CTRL_CMD_PRIORITY},
+    [FPGA_CTRL_REPROGRAM_CC]       = {"REPROGRAM", sizeof(FPGA_CTRL_ReprogramCmd_t), FPGA_CTRL_LoadBitstreamCmd, 0},
+    [FPGA_CTRL_SAMPLING_CC]        = {"SAMPLING", sizeof(FPGA_CTRL_SamplingCmd_t), FPGA_CTRL_SamplingCmd,
+                                      FPGA_CTRL_CMD_NEEDS_FABRIC | FPGA_CTRL_CMD_PRIORITY},
+    [FPGA_CTRL_LOADGEN_CC]         = {"LOADGEN", sizeof(FPGA_CTRL_LoadGenCmd_t), FPGA_CTRL_LoadGenCmd,
+                                      FPGA_CTRL_CMD_PRIORITY},
+    [FPGA_CTRL_REPROGRAM_NAMED_CC] = {"REPROGRAM_NAMED", sizeof(FPGA_CTRL_ReprogramNamedCmd_t),
+                                      FPGA_CTRL_LoadNamedModuleCmd, 0},
+    [FPGA_CTRL_REGION_SCHED_CC]    = {"REGION_SCHED", sizeof(FPGA_CTRL_RegionSchedCmd_t), FPGA_CTRL_RegionScheduleCmd,
+                                      FPGA_CTRL_CMD_UNCOUNTED},
+    [FPGA_CTRL_BATCH_CC]           = {"BATCH", sizeof(FPGA_CTRL_BatchCmd_t), FPGA_CTRL_Batch,
+                                      FPGA_CTRL_CMD_VARIABLE_LEN},
+    [FPGA_CTRL_TIMED_CC]           = {"TIMED", sizeof(FPGA_CTRL_TimedCmd_t), FPGA_CTRL_TimeTagCmd,
+                                      FPGA_CTRL_CMD_VARIABLE_LEN},
+    [FPGA_CTRL_PROFILE_DUMP_CC]    = {"PROFILE_DUMP", sizeof(FPGA_CTRL_ProfileDumpCmd_t), FPGA_CTRL_DumpProfileCmd, 0},
+    [FPGA_CTRL_TRACE_CC]           = {"TRACE", sizeof(FPGA_CTRL_TraceCmd_t), FPGA_CTRL_TraceCtrlCmd,
+                                      FPGA_CTRL_CMD_PRIORITY},
+};
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
 /*                                                                            */
 /* FPGA_CTRL_ProcessGroundCommand() -- SAMPLE ground commands                */
 /*                                                                            */
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
-static void FPGA_CTRL_ProcessGroundCommand(CFE_SB_Buffer_t *SBBufPtr)
+static void FPGA_CTRL_ProcessGroundCommand(CFE_SB_Buffer_t *SBBufPtr, bool Priority)
 {
     CFE_MSG_FcnCode_t CommandCode = 0;
 
     CFE_MSG_GetFcnCode(&SBBufPtr->Msg, &CommandCode);
 
-    /*
-    ** Process "known" SAMPLE app ground commands
-    */
-    switch (CommandCode)
+    if (FPGA_CTRL_RunCommand(SBBufPtr, CommandCode, Priority) != CFE_SUCCESS)
+    {
+        ++globalState.ErrCounter;
+    }
+    else if (!(FPGA_CTRL_CmdTable[CommandCode].flags & FPGA_CTRL_CMD_UNCOUNTED))
     {
-        case FPGA_CTRL_NOOP_CC:
-            if (FPGA_CTRL_VerifyCmdLength(&SBBufPtr->Msg, sizeof(FPGA_CTRL_NoopCmd_t)))
-            {
-                ++globalState.CmdCounter;
-                FPGA_CTRL_Noop((FPGA_CTRL_NoopCmd_t *)SBBufPtr);
-            }
+        ++globalState.CmdCounter;
+    }
 
-            break;
+    return;
 
-        case FPGA_CTRL_RESET_COUNTERS_CC:
-            if (FPGA_CTRL_VerifyCmdLength(&SBBufPtr->Msg, sizeof(FPGA_CTRL_ResetCountersCmd_t)))
-            {
-                ++globalState.CmdCounter;
-                FPGA_CTRL_ResetCounters((FPGA_CTRL_ResetCountersCmd_t *)SBBufPtr);
-            }
+} /* End of FPGA_CTRL_ProcessGroundCommand() */
 
-            break;
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*                                                                            */
+/* FPGA_CTRL_RunCommand() -- Checks a command against its descriptor, runs    */
+/* its handler and keeps its statistics. The app counters are left to the     */
+/* caller, a batch counts once however many sub-commands it has.              */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+static int32 FPGA_CTRL_RunCommand(CFE_SB_Buffer_t *SBBufPtr, CFE_MSG_FcnCode_t CommandCode, bool Priority)
+{
+    if (CommandCode >= FPGA_CTRL_CC_COUNT || FPGA_CTRL_CmdTable[CommandCode].handler == NULL)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR, "Invalid ground command code: CC = %d",
+                          CommandCode);
+        return CFE_STATUS_BAD_COMMAND_CODE;
+    }
 
-        case FPGA_CTRL_PROCESS_CC:
-            if (FPGA_CTRL_VerifyCmdLength(&SBBufPtr->Msg, sizeof(FPGA_CTRL_ProcessCmd_t)))
-            {
-                ++globalState.CmdCounter;
-                FPGA_CTRL_Process((FPGA_CTRL_ProcessCmd_t *)SBBufPtr);
-            }
+    FPGA_CTRL_CmdDesc_t const *const desc  = &FPGA_CTRL_CmdTable[CommandCode];
+    FPGA_CTRL_CmdStats_t *const      stats = &cmdStatsTlm.cmds[CommandCode];
+    ++stats->count;
 
-            break;
+    /* Long-running commands on the priority MID would hold up the housekeeping and control behind them */
+    if (Priority && !(desc->flags & FPGA_CTRL_CMD_PRIORITY))
+    {
+        ++stats->errors;
+        CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "%s isn't a priority command, send it on MID 0x%x", desc->name,
+                          (unsigned int)FPGA_CTRL_CMD_MID);
+        return CFE_STATUS_BAD_COMMAND_CODE;
+    }
 
-        case FPGA_CTRL_ENCRYPT_CC:
-            if (FPGA_CTRL_VerifyCmdLength(&SBBufPtr->Msg, sizeof(FPGA_CTRL_EncryptCmd_t)))
-            {
-                ++globalState.CmdCounter;
-                FPGA_CTRL_Encrypt((FPGA_CTRL_EncryptCmd_t *)SBBufPtr);
-            }
+    size_t const minLength =
+        (desc->flags & FPGA_CTRL_CMD_VARIABLE_LEN) ? sizeof(CFE_MSG_CommandHeader_t) : desc->length;
+    if (!FPGA_CTRL_VerifyCmdLength(&SBBufPtr->Msg, minLength, desc->length))
+    {
+        ++stats->errors;
+        return CFE_STATUS_WRONG_MSG_LENGTH;
+    }
 
-            break;
+    if ((desc->flags & FPGA_CTRL_CMD_NEEDS_FABRIC) && !FPGA_CTRL_CheckFabricUp(CommandCode))
+    {
+        ++stats->errors;
+        return CFE_STATUS_INCORRECT_STATE;
+    }
 
-        case FPGA_CTRL_INT_CTRL_CC:
-            if (FPGA_CTRL_VerifyCmdLength(&SBBufPtr->Msg, sizeof(FPGA_CTRL_IntCtrlCmd_t)))
-            {
-                ++globalState.CmdCounter;
-                FPGA_CTRL_IntCtrl((FPGA_CTRL_IntCtrlCmd_t *)SBBufPtr);
-            }
+    // Batches nest, each sub-command gets its own pair of markers inside the batch's
+    FPGA_CTRL_ProfileMark_t mark;
+    CFE_ES_PerfLogEntry(FPGA_CTRL_CMD_PERF_ID);
+    FPGA_CTRL_PROBE2(cmd__start, CommandCode, Priority);
+    FPGA_CTRL_ProfileStart(&mark);
+    int32 const  status    = desc->handler(SBBufPtr);
+    uint32 const elapsedUs = FPGA_CTRL_ProfileStop(CommandCode, desc->name, &mark);
+    FPGA_CTRL_PROBE3(cmd__done, CommandCode, status, elapsedUs);
+    FPGA_CTRL_TRACE(DEBUG, CMD, "%s done in %u us, status 0x%08x", desc->name, (unsigned int)elapsedUs,
+                    (unsigned int)status);
+    CFE_ES_PerfLogExit(FPGA_CTRL_CMD_PERF_ID);
+
+    stats->totalUs += elapsedUs;
+    if (elapsedUs > stats->maxUs)
+        stats->maxUs = elapsedUs;
 
-            break;
+    if (status != CFE_SUCCESS)
+        ++stats->errors;
+
+    return status;
+
+} /* End of FPGA_CTRL_RunCommand() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*                                                                            */
+/* FPGA_CTRL_Batch() -- Unpacks the sub-commands of a batch and runs each     */
+/* through FPGA_CTRL_RunCommand, as if it had been sent on its own, saving    */
+/* the SB send and wakeup of every one after the first. The results go out    */
+/* on FPGA_CTRL_BATCH_TLM_MID.                                                */
+/*                                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+static int32 FPGA_CTRL_Batch(CFE_SB_Buffer_t const *SBBufPtr)
+{
+    static FPGA_CTRL_BatchTlm_t result;
+
+    /* Each sub-command is rebuilt here with a header of its own, so handlers see an ordinary command */
+    static union
+    {
+        CFE_SB_Buffer_t Buf;
+        uint8           Bytes[sizeof(CFE_MSG_CommandHeader_t) + FPGA_CTRL_BATCH_MAX_BYTES];
+    } item;
+
+    FPGA_CTRL_BatchCmd_t const *const Msg        = (FPGA_CTRL_BatchCmd_t const *)SBBufPtr;
+    size_t const                      itemsStart = offsetof(FPGA_CTRL_BatchCmd_t, items);
+    size_t                            size       = 0;
+    CFE_SB_MsgId_t                    MsgId      = CFE_SB_INVALID_MSG_ID;
+    int32                             status     = CFE_SUCCESS;
+    bool                              malformed  = false;
+
+    CFE_MSG_GetSize(&SBBufPtr->Msg, &size);
+    CFE_MSG_GetMsgId(&SBBufPtr->Msg, &MsgId);
+
+    if (size < itemsStart || Msg->itemCount > FPGA_CTRL_BATCH_MAX_ITEMS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "Batch too short or has more than %u items", (unsigned int)FPGA_CTRL_BATCH_MAX_ITEMS);
+        return CFE_STATUS_WRONG_MSG_LENGTH;
+    }
 
-        case FPGA_CTRL_REPROGRAM_CC:
-            if (FPGA_CTRL_VerifyCmdLength(&SBBufPtr->Msg, sizeof(FPGA_CTRL_ReprogramCmd_t)))
-            {
-                ++globalState.CmdCounter;
-                FPGA_CTRL_LoadBitstream((FPGA_CTRL_ReprogramCmd_t *)SBBufPtr);
-            }
+    CFE_MSG_Init(&result.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_BATCH_TLM_MID), sizeof(result));
+    result.sequence     = Msg->sequence;
+    result.itemCount    = Msg->itemCount;
+    result.itemsRun     = 0;
+    result.resultBitmap = 0;
+    result.firstFailed  = 0xFF;
 
+    size_t const itemsEnd = size - itemsStart;
+    size_t       offset   = 0;
+    for (uint8 i = 0; i < Msg->itemCount; ++i)
+    {
+        FPGA_CTRL_BatchItemHeader_t header;
+        int32                       itemStatus;
+
+        if (itemsEnd - offset < sizeof(header))
+        {
+            malformed = true;
             break;
+        }
+        memcpy(&header, &Msg->items[offset], sizeof(header));
+        offset += sizeof(header);
 
-        /* default case already found during FC vs length test */
-        default:
-            ++globalState.ErrCounter;
-            CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
-                              "Invalid ground command code: CC = %d", CommandCode);
+        if (itemsEnd - offset < header.length)
+        {
+            malformed = true;
+            break;
+        }
+
+        CFE_MSG_Init(&item.Buf.Msg, MsgId, sizeof(CFE_MSG_CommandHeader_t) + header.length);
+        CFE_MSG_SetFcnCode(&item.Buf.Msg, header.fcnCode);
+        memcpy(&item.Bytes[sizeof(CFE_MSG_CommandHeader_t)], &Msg->items[offset], header.length);
+        offset += header.length;
+        offset += (4 - offset % 4) % 4;
+        if (offset > itemsEnd)
+            offset = itemsEnd;
+
+        /* Batches don't nest, a batch of batches could run far longer than anything sent on its own */
+        itemStatus = header.fcnCode == FPGA_CTRL_BATCH_CC ? CFE_STATUS_BAD_COMMAND_CODE
+                                                         : FPGA_CTRL_RunCommand(&item.Buf, header.fcnCode, false);
+
+        ++result.itemsRun;
+        if (itemStatus == CFE_SUCCESS)
+        {
+            result.resultBitmap |= 1u << i;
+            continue;
+        }
 
+        if (result.firstFailed == 0xFF)
+        {
+            result.firstFailed = i;
+            status             = itemStatus;
+        }
+        if (Msg->stopOnError)
             break;
     }
 
-    return;
+    if (malformed)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "Batch %u item %u runs past the end of the command", (unsigned int)Msg->sequence,
+                          (unsigned int)result.itemsRun);
+        if (status == CFE_SUCCESS)
+            status = CFE_STATUS_WRONG_MSG_LENGTH;
+    }
 
-} /* End of FPGA_CTRL_ProcessGroundCommand() */
+    result.status = status;
+    CFE_SB_TimeStampMsg(&result.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&result.TlmHeader.Msg, true);
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID,
+                      status == CFE_SUCCESS ? CFE_EVS_EventType_INFORMATION : CFE_EVS_EventType_ERROR,
+                      "Batch %u ran %u of %u items, results 0x%08x", (unsigned int)Msg->sequence,
+                      (unsigned int)result.itemsRun, (unsigned int)result.itemCount,
+                      (unsigned int)result.resultBitmap);
+
+    return status;
+
+} /* End of FPGA_CTRL_Batch() */
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
 /*  Name:  FPGA_CTRL_ReportHousekeeping                                          */
@@ -376,13 +1082,72 @@ static void FPGA_CTRL_ProcessGroundCommand(CFE_SB_Buffer_t *SBBufPtr)
 /* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
 static int32 FPGA_CTRL_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg)
 {
+    static FPGA_CTRL_IrqStats_t          irqStats;
+    static FPGA_CTRL_SampleStats_t       sampleStats;
+    static FPGA_CTRL_SampleWriterStats_t sampleWriterStats;
+    static FPGA_CTRL_BitstreamStats_t    bitstreamStats;
+    FPGA_CTRL_PipeStats_t                pipeStats[FPGA_CTRL_PIPE_CLASSES];
+
+    /*
+    ** Snapshot what the child tasks publish, each block as of the end of one update. A block whose writer
+    ** is stuck mid-update keeps the snapshot from the last report...
+    */
+    FPGA_CTRL_StatsRead(&irqStats, &globalState.IrqStats, sizeof(irqStats));
+    FPGA_CTRL_StatsRead(&sampleStats, &globalState.SampleStats, sizeof(sampleStats));
+    FPGA_CTRL_StatsRead(&sampleWriterStats, &globalState.SampleWriterStats, sizeof(sampleWriterStats));
+    FPGA_CTRL_StatsRead(&bitstreamStats, &globalState.BitstreamStats, sizeof(bitstreamStats));
+    FPGA_CTRL_PipeStatsRead(pipeStats);
+
     /*
     ** Get command execution counters...
     */
     FPGA_CTRL_HkTlm_Payload_t *const payload = &globalState.HkTlm.Payload;
     payload->CommandErrorCounter             = globalState.ErrCounter;
     payload->CommandCounter                  = globalState.CmdCounter;
-    payload->childTaskRunning                = globalState.childTaskRunning;
+    payload->interruptsEnabled               = globalState.irqEnabled;
+    payload->irqMode                         = irqStats.mode;
+    payload->irqEventCount                   = irqStats.eventCount;
+    payload->irqModeTransitions              = irqStats.modeTransitions;
+    payload->irqInterruptModeMs              = irqStats.interruptModeMs;
+    payload->irqPollModeMs                   = irqStats.pollModeMs;
+    payload->samplingActive                  = sampler.samplerRunning;
+    payload->fabricState                     = globalState.fabricState;
+    payload->samplesTaken                    = sampleStats.taken;
+    payload->samplesDropped                  = sampleStats.dropped;
+    payload->sampleBlocks                    = sampleWriterStats.blocks;
+    payload->bitstreamStageMs                = lastBitstreamTiming.stageMs;
+    payload->bitstreamProgramMs              = lastBitstreamTiming.programMs;
+    payload->bitstreamVerifyMs               = lastBitstreamTiming.verifyMs;
+    payload->bitstreamRemapMs                = lastBitstreamTiming.remapMs;
+    payload->fabricDowntimeMs                = lastBitstreamTiming.downtimeMs;
+    payload->bitstreamCacheHits              = bitstreamStats.cacheHits;
+    payload->bitstreamCacheMisses            = bitstreamStats.cacheMisses;
+    payload->bitstreamCacheBytes             = bitstreamStats.cacheBytes;
+    payload->bitstreamCacheEntries           = bitstreamStats.cacheEntries;
+    payload->bitstreamRawBytes               = lastBitstreamTiming.rawBytes;
+    payload->bitstreamCompressedBytes        = lastBitstreamTiming.compressedBytes;
+    payload->bitstreamRatioX100              = lastBitstreamTiming.compressedBytes != 0
+                                                   ? (uint32)((uint64)lastBitstreamTiming.rawBytes * 100 /
+                                                              lastBitstreamTiming.compressedBytes)
+                                                   : 0;
+    payload->bitstreamDecompressKBps         = lastBitstreamTiming.decompressKBps;
+    payload->bitstreamCrc32c                 = lastBitstreamTiming.crc32c;
+    payload->bitstreamVerifyMBps             = lastBitstreamTiming.verifyMBps;
+    payload->bitstreamVerifyFailures         = bitstreamStats.verifyFailures;
+    payload->accelMask                       = globalState.accelMask;
+    memcpy(payload->loadedDesign, accelRegistry.design, sizeof(payload->loadedDesign));
+    payload->priorityMsgs                    = pipeStats[FPGA_CTRL_PIPE_PRIORITY].received;
+    payload->commandMsgs                     = pipeStats[FPGA_CTRL_PIPE_COMMAND].received;
+    payload->priorityDepthHighWater          = (uint16)pipeStats[FPGA_CTRL_PIPE_PRIORITY].highWater;
+    payload->commandDepthHighWater           = (uint16)pipeStats[FPGA_CTRL_PIPE_COMMAND].highWater;
+    payload->priorityBacklogs                = (uint16)pipeStats[FPGA_CTRL_PIPE_PRIORITY].backlogs;
+    payload->commandBacklogs                 = (uint16)pipeStats[FPGA_CTRL_PIPE_COMMAND].backlogs;
+    payload->jobsActive                      = (uint16)jobSched.active;
+    payload->jobMaxSlices                    = (uint16)jobSched.maxSlices;
+    payload->jobsCompleted                   = jobSched.completed;
+    payload->jobsFailed                      = jobSched.failed;
+    payload->jobsCancelled                   = jobSched.cancelled;
+    payload->jobMaxRunMs                     = jobSched.maxRunMs;
     memcpy(payload->cyphertextHexString, globalState.cyphertextHexString, sizeof(globalState.cyphertextHexString));
 
     /*
@@ -391,6 +1156,19 @@ static int32 FPGA_CTRL_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg)
     CFE_SB_TimeStampMsg(&globalState.HkTlm.TlmHeader.Msg);
     CFE_SB_TransmitMsg(&globalState.HkTlm.TlmHeader.Msg, true);
 
+    /*
+    ** Region loading and the stats aggregation are rate group items, only their results are reported here
+    */
+    FPGA_CTRL_SendRegionTlm();
+
+    CFE_MSG_Init(&cmdStatsTlm.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_CMD_STATS_TLM_MID), sizeof(cmdStatsTlm));
+    CFE_SB_TimeStampMsg(&cmdStatsTlm.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&cmdStatsTlm.TlmHeader.Msg, true);
+
+    FPGA_CTRL_SendRateTlm();
+    FPGA_CTRL_SendTimedTlm();
+    FPGA_CTRL_SendProfileTlm();
+
     /*
     ** Manage any pending table loads, validations, etc.
     */
@@ -398,6 +1176,10 @@ static int32 FPGA_CTRL_ReportHousekeeping(const CFE_MSG_CommandHeader_t *Msg)
     {
         CFE_TBL_Manage(globalState.TblHandles[i]);
     }
+    FPGA_CTRL_LoadDrainBudget();
+    FPGA_CTRL_LoadRateBudget();
+    FPGA_CTRL_LoadJobSlice();
+    FPGA_CTRL_LoadMetricsConfig();
 
     // CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Hello");
 
@@ -436,6 +1218,12 @@ static int32 FPGA_CTRL_ResetCounters(const FPGA_CTRL_ResetCountersCmd_t *Msg)
 
     globalState.CmdCounter = 0;
     globalState.ErrCounter = 0;
+    memset(&cmdStatsTlm, 0, sizeof(cmdStatsTlm));
+    FPGA_CTRL_ResetProfile();
+    drainState.WaitNs         = 0;
+    drainState.HandlingNs     = 0;
+    drainState.LastWaitNs     = 0;
+    drainState.LastHandlingNs = 0;
 
     CFE_EVS_SendEvent(FPGA_CTRL_COMMANDRST_INF_EID, CFE_EVS_EventType_INFORMATION, "FPGA_CTRL: RESET command");
 
@@ -489,7 +1277,7 @@ static int32 FPGA_CTRL_Process(const FPGA_CTRL_ProcessCmd_t *Msg)
 /* FPGA_CTRL_VerifyCmdLength() -- Verify command packet length                   */
 /*                                                                            */
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
-static bool FPGA_CTRL_VerifyCmdLength(CFE_MSG_Message_t *MsgPtr, size_t ExpectedLength)
+static bool FPGA_CTRL_VerifyCmdLength(CFE_MSG_Message_t *MsgPtr, size_t MinLength, size_t MaxLength)
 {
     bool              result       = true;
     size_t            ActualLength = 0;
@@ -499,9 +1287,9 @@ static bool FPGA_CTRL_VerifyCmdLength(CFE_MSG_Message_t *MsgPtr, size_t Expected
     CFE_MSG_GetSize(MsgPtr, &ActualLength);
 
     /*
-    ** Verify the command packet length.
+    ** Verify the command packet length, fixed-size commands have MinLength == MaxLength.
     */
-    if (ExpectedLength != ActualLength)
+    if (ActualLength < MinLength || ActualLength > MaxLength)
     {
         CFE_MSG_GetMsgId(MsgPtr, &MsgId);
         CFE_MSG_GetFcnCode(MsgPtr, &FcnCode);
@@ -509,11 +1297,9 @@ static bool FPGA_CTRL_VerifyCmdLength(CFE_MSG_Message_t *MsgPtr, size_t Expected
         CFE_EVS_SendEvent(FPGA_CTRL_LEN_ERR_EID, CFE_EVS_EventType_ERROR,
                           "Invalid Msg length: ID = 0x%X,  CC = %u, Len = %u, Expected = %u",
                           (unsigned int)CFE_SB_MsgIdToValue(MsgId), (unsigned int)FcnCode, (unsigned int)ActualLength,
-                          (unsigned int)ExpectedLength);
+                          (unsigned int)MaxLength);
 
         result = false;
-
-        globalState.ErrCounter++;
     }
 
     return (result);
@@ -540,6 +1326,92 @@ static int32 FPGA_CTRL_TblValidationFunc(void *TblData)
         ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
     }
 
+    /* Polling mode needs a non-zero budget or it would never read the GPIO */
+    if (TblDataPtr->IrqPollEnterRate != 0 && TblDataPtr->IrqPollBudget == 0)
+    {
+        ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+    }
+
+    /* Bitstream names and paths must be terminated, and names unique so lookups are unambiguous */
+    for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+    {
+        FPGA_CTRL_BitstreamEntry_t const *const entry = &TblDataPtr->Bitstreams[i];
+        if (entry->Name[0] == '\0')
+            continue;
+
+        if (memchr(entry->Name, '\0', sizeof(entry->Name)) == NULL ||
+            memchr(entry->Path, '\0', sizeof(entry->Path)) == NULL || entry->Path[0] == '\0')
+        {
+            ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+            continue;
+        }
+
+        for (int j = 0; j < i; ++j)
+        {
+            if (strncmp(entry->Name, TblDataPtr->Bitstreams[j].Name, sizeof(entry->Name)) == 0)
+                ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+        }
+
+        /* Cores are registered by type, so each type at most once and with something to map */
+        uint32 typesSeen = 0;
+        for (int j = 0; j < FPGA_CTRL_MAX_ACCELS; ++j)
+        {
+            FPGA_CTRL_AccelDesc_t const *const desc = &entry->Accels[j];
+            if (desc->Type == FPGA_CTRL_ACCEL_NONE)
+                continue;
+
+            if (desc->Type >= FPGA_CTRL_ACCEL_TYPES || (typesSeen & (1u << desc->Type)) || desc->Range == 0)
+                ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+            else
+                typesSeen |= 1u << desc->Type;
+        }
+
+        /* Partial bitstreams need an overlay to program them, and the GPIO block is only in full designs */
+        if (entry->Region > FPGA_CTRL_MAX_REGIONS)
+        {
+            ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+        }
+        else if (entry->Region != 0 &&
+                 (memchr(entry->Overlay, '\0', sizeof(entry->Overlay)) == NULL || entry->Overlay[0] == '\0' ||
+                  (typesSeen & ((1u << FPGA_CTRL_ACCEL_GPIO_BTN) | (1u << FPGA_CTRL_ACCEL_GPIO_SW)))))
+        {
+            ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+        }
+    }
+
+    /* The boot design, if given, has to be one of the full bitstreams */
+    if (memchr(TblDataPtr->BootBitstream, '\0', sizeof(TblDataPtr->BootBitstream)) == NULL)
+    {
+        ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+    }
+    else if (TblDataPtr->BootBitstream[0] != '\0')
+    {
+        bool found = false;
+        for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+            found |= TblDataPtr->Bitstreams[i].Region == 0 &&
+                     strncmp(TblDataPtr->Bitstreams[i].Name, TblDataPtr->BootBitstream,
+                             sizeof(TblDataPtr->BootBitstream)) == 0;
+        if (!found)
+            ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+    }
+
+    /* Prefaulting must stay well inside the smallest task stack, the helper children get the default size */
+    uint32 const irqStackSize = TblDataPtr->Sched.IrqTaskStackSize != 0 ? TblDataPtr->Sched.IrqTaskStackSize
+                                                                        : CFE_PLATFORM_ES_DEFAULT_STACK_SIZE;
+    uint32 const minStackSize = irqStackSize < CFE_PLATFORM_ES_DEFAULT_STACK_SIZE ? irqStackSize
+                                                                                  : CFE_PLATFORM_ES_DEFAULT_STACK_SIZE;
+    if (TblDataPtr->Sched.PrefaultStack && (TblDataPtr->Sched.StackPrefaultBytes > FPGA_CTRL_SCHED_MAX_PREFAULT_BYTES ||
+                                            TblDataPtr->Sched.StackPrefaultBytes > minStackSize / 2))
+    {
+        ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+    }
+
+    /* The metrics path gets ".tmp" appended for the file it's written to, so it has to be terminated */
+    if (memchr(TblDataPtr->MetricsPath, '\0', sizeof(TblDataPtr->MetricsPath)) == NULL)
+    {
+        ReturnCode = FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE;
+    }
+
     return ReturnCode;
 
 } /* End of FPGA_CTRL_TBLValidationFunc() */
@@ -44,9 +44,13 @@
 #include "fpga_ctrl_msg.h"
 #include "fpga_ctrl_msgids.h"
 #include "fpga_ctrl_perfids.h"
+#include "fpga_ctrl_probes.h"
+#include "fpga_ctrl_table.h"
 
 /***********************************************************************/
-#define FPGA_CTRL_PIPE_DEPTH 32 /* Depth of the Command Pipe for Application */
+#define FPGA_CTRL_PIPE_DEPTH          32 /* Depth of the Command Pipe for Application */
+#define FPGA_CTRL_PRIORITY_PIPE_DEPTH 8  /* Depth of the pipe for housekeeping requests, wakeups and control commands */
+#define FPGA_CTRL_COMMAND_MAX_SIZE    sizeof(FPGA_CTRL_BatchCmd_t) /* Longest command, a full batch */
 
 #define FPGA_CTRL_NUMBER_OF_TABLES 1 /* Number of Table(s) */
 
@@ -56,24 +60,105 @@
 #define FPGA_CTRL_TABLE_OUT_OF_RANGE_ERR_CODE -1
 
 #define FPGA_CTRL_TBL_ELEMENT_1_MAX 10
+
+#define FPGA_CTRL_CACHE_LINE 64 /* Alignment of data written by different tasks */
+
+/* Command descriptor flags */
+#define FPGA_CTRL_CMD_NEEDS_FABRIC 0x01 // Refused while the fabric is down
+#define FPGA_CTRL_CMD_UNCOUNTED    0x02 // Not counted in CmdCounter: sent by the app itself, or resets the counter
+#define FPGA_CTRL_CMD_PRIORITY     0x04 // Quick and bounded, also accepted on FPGA_CTRL_PRIORITY_CMD_MID
+#define FPGA_CTRL_CMD_VARIABLE_LEN 0x08 // length is the most accepted, the handler checks what it got
 /************************************************************************
 ** Type Definitions
 *************************************************************************/
 
+typedef int32 (*FPGA_CTRL_CmdHandler_t)(CFE_SB_Buffer_t const *SBBufPtr);
+
+/*
+** How a command code is dispatched, an entry with no handler is an unknown code
+*/
+typedef struct
+{
+    char const            *name;
+    size_t                 length; // Exact size of the command
+    FPGA_CTRL_CmdHandler_t handler;
+    uint32                 flags; // FPGA_CTRL_CMD_*
+} FPGA_CTRL_CmdDesc_t;
+
+/*
+** Sequence of a statistics block, odd while its writer is updating it. See fpga_ctrl_stats.h.
+*/
+typedef struct
+{
+    atomic_uint seq;
+} FPGA_CTRL_SeqLock_t;
+
+/*
+** Statistics blocks, each written by a single task and read by housekeeping through its seqlock. Each starts on its
+** own cache line, so one task's counters never share a line with another's.
+*/
+typedef struct
+{
+    _Alignas(FPGA_CTRL_CACHE_LINE) FPGA_CTRL_SeqLock_t lock;
+    uint32 mode; // FPGA_CTRL_IRQ_MODE_*
+    uint32 eventCount;
+    uint32 modeTransitions;
+    uint32 interruptModeMs;
+    uint32 pollModeMs;
+} FPGA_CTRL_IrqStats_t;
+
+typedef struct
+{
+    _Alignas(FPGA_CTRL_CACHE_LINE) FPGA_CTRL_SeqLock_t lock;
+    uint32 taken;
+    uint32 dropped;
+} FPGA_CTRL_SampleStats_t;
+
+typedef struct
+{
+    _Alignas(FPGA_CTRL_CACHE_LINE) FPGA_CTRL_SeqLock_t lock;
+    uint32 blocks;
+} FPGA_CTRL_SampleWriterStats_t;
+
+typedef struct
+{
+    _Alignas(FPGA_CTRL_CACHE_LINE) FPGA_CTRL_SeqLock_t lock;
+    uint32 cacheHits;
+    uint32 cacheMisses;
+    uint32 cacheBytes;
+    uint32 cacheEntries;
+    uint32 verifyFailures; // Staged images that didn't match the table's CRC
+} FPGA_CTRL_BitstreamStats_t;
+
 /*
 ** Global Data
 */
 typedef struct
 {
     /*
-    ** Command interface counters...
+    ** Command interface counters, main task only...
+    */
+    uint8 CmdCounter;
+    uint8 ErrCounter;
+    char  cyphertextHexString[16 * 2 + 1]; // 16 bytes of cyphertext, 2 hex chars per byte, +1 for null terminator
+
+    /*
+    ** Control flags shared between the tasks, rarely written...
     */
-    uint8       CmdCounter;
-    uint8       ErrCounter;
-    char        cyphertextHexString[16 * 2 + 1]; // 16 bytes of cyphertext, 2 hex chars per byte, +1 for null terminator
-    atomic_bool childTaskRunning;
-    atomic_bool childTaskShouldExit;
+    _Alignas(FPGA_CTRL_CACHE_LINE) atomic_bool irqEnabled; // Interrupts unmasked and serviced by the child task
+    atomic_bool     irqTaskRunning;                        // Persistent interrupt child task is alive
     CFE_ES_TaskId_t childTaskId;
+    atomic_uint     fabricState; // FPGA_CTRL_FABRIC_*, written by the reprogram task
+    atomic_bool     fabricUp;    // Accelerator commands are accepted
+    atomic_uint     accelMask;   // Cores in the accelerator registry, bit n = FPGA_CTRL_ACCEL_* type n
+
+    /*
+    ** Statistics written by the child tasks...
+    */
+    FPGA_CTRL_IrqStats_t          IrqStats;          // Interrupt child task
+    FPGA_CTRL_SampleStats_t       SampleStats;       // Sampler task
+    FPGA_CTRL_SampleWriterStats_t SampleWriterStats; // Sample writer task
+    FPGA_CTRL_BitstreamStats_t    BitstreamStats;    // Reprogram task, and the main task at startup
 
     /*
     ** Housekeeping telemetry packet...
@@ -88,13 +173,18 @@ typedef struct
     /*
     ** Operational data (not reported in housekeeping)...
     */
-    CFE_SB_PipeId_t CommandPipe;
+    CFE_SB_PipeId_t CommandPipe;  // Everything not on the priority pipe
+    CFE_SB_PipeId_t PriorityPipe; // Housekeeping requests, wakeups and control commands, always handled first
 
     /*
     ** Initialization data (not reported in housekeeping)...
     */
     char   PipeName[CFE_MISSION_MAX_API_LEN];
     uint16 PipeDepth;
+    char   PriorityPipeName[CFE_MISSION_MAX_API_LEN];
+    uint16 PriorityPipeDepth;
+
+    FPGA_CTRL_SchedProfile_t SchedProfile; // Copy of the table's scheduling profile, read by child tasks
 
     CFE_EVS_BinFilter_t EventFilters[FPGA_CTRL_EVENT_COUNTS];
     CFE_TBL_Handle_t    TblHandles[FPGA_CTRL_NUMBER_OF_TABLES];
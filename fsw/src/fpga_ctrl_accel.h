@@ -0,0 +1,192 @@
+// Registry of the cores in the loaded design, built from the accelerator descriptors in the bitstream table at startup
+// and again after every load. Each register window is mapped once when the registry is built and found by type with
+// an array index, so commands never map or look anything up themselves.
+// A full load rebuilds the registry from the reprogram task, but only after the main task has cleared fabricUp and
+// cancelled every job using a core (FPGA_CTRL_TakeFabricDown), so nothing on the main task holds a core while it's
+// unmapped. Cores of partially reconfigured regions are added and removed on the main task by the region scheduler,
+// and jobs look their core up again every step.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cfe.h"
+#include "mmio_lib.h"
+#include "fpga_ctrl.h"
+#include "fpga_ctrl_table.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_ACCEL_BUILTIN_DESIGN "builtin"
+
+typedef struct
+{
+    FPGA_CTRL_AccelDesc_t desc;
+    void volatile        *base; // Mapped register window, NULL when the design doesn't have this core
+} FPGA_CTRL_Accel_t;
+
+typedef struct
+{
+    char              design[FPGA_CTRL_BITSTREAM_NAME_LEN]; // Table name of the loaded design, empty if unknown
+    FPGA_CTRL_Accel_t byType[FPGA_CTRL_ACCEL_TYPES];
+    uint32            mask; // Bit n set when a core of type n is mapped
+} FPGA_CTRL_AccelRegistry_t;
+
+static FPGA_CTRL_AccelRegistry_t accelRegistry;
+
+// Register windows mapped and unmapped since startup. Full loads change them from the reprogram task.
+static struct
+{
+    atomic_uint created;
+    atomic_uint deleted;
+    atomic_uint failed;
+} accelMapStats;
+
+// The layout the app was written against, used when the table doesn't name the design loaded at boot
+static FPGA_CTRL_AccelDesc_t const FPGA_CTRL_BuiltinAccels[FPGA_CTRL_MAX_ACCELS] = {
+    {.Type = FPGA_CTRL_ACCEL_AES_CTRL, .UioIndex = FPGA_CTRL_ACCEL_NO_UIO, .Base = 0x43c00000, .Range = 0x10000},
+    {.Type = FPGA_CTRL_ACCEL_AES_IN, .UioIndex = FPGA_CTRL_ACCEL_NO_UIO, .Base = 0x43c10000, .Range = 0x10000},
+    {.Type = FPGA_CTRL_ACCEL_AES_OUT, .UioIndex = FPGA_CTRL_ACCEL_NO_UIO, .Base = 0x43c20000, .Range = 0x10000},
+    {.Type = FPGA_CTRL_ACCEL_GPIO_BTN, .UioIndex = 0, .Base = 0x41200000, .Range = 0x10000},
+    {.Type = FPGA_CTRL_ACCEL_GPIO_SW, .UioIndex = FPGA_CTRL_ACCEL_NO_UIO, .Base = 0x41210000, .Range = 0x10000},
+};
+
+// Exported functions
+void                     FPGA_CTRL_InitAccelRegistry(void);
+void                     FPGA_CTRL_BuildAccelRegistry(char const *design, FPGA_CTRL_AccelDesc_t const *descs);
+void                     FPGA_CTRL_ClearAccelRegistry(void);
+void                     FPGA_CTRL_AddAccels(FPGA_CTRL_AccelDesc_t const *descs);
+void                     FPGA_CTRL_RemoveAccels(FPGA_CTRL_AccelDesc_t const *descs);
+FPGA_CTRL_Accel_t const *FPGA_CTRL_GetAccel(uint32 type);
+
+static void FPGA_CTRL_UnmapAccel(uint32 type, FPGA_CTRL_Accel_t const *accel);
+
+// Registers the cores of the design the table says is loaded at boot, or the built-in layout if it doesn't say
+void FPGA_CTRL_InitAccelRegistry(void)
+{
+    FPGA_CTRL_Table_t    *tblPtr;
+    FPGA_CTRL_AccelDesc_t descs[FPGA_CTRL_MAX_ACCELS];
+    char                  design[FPGA_CTRL_BITSTREAM_NAME_LEN] = FPGA_CTRL_ACCEL_BUILTIN_DESIGN;
+
+    memcpy(descs, FPGA_CTRL_BuiltinAccels, sizeof(descs));
+
+    if (CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0]) >= CFE_SUCCESS)
+    {
+        for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS && tblPtr->BootBitstream[0] != '\0'; ++i)
+        {
+            FPGA_CTRL_BitstreamEntry_t const *const entry = &tblPtr->Bitstreams[i];
+            if (entry->Name[0] != '\0' && strcmp(entry->Name, tblPtr->BootBitstream) == 0)
+            {
+                memcpy(descs, entry->Accels, sizeof(descs));
+                memcpy(design, entry->Name, sizeof(design));
+                break;
+            }
+        }
+
+        CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+    }
+
+    FPGA_CTRL_BuildAccelRegistry(design, descs);
+}
+
+// Maps every core in descs, replacing whatever was registered. A core that fails to map is left out and reported,
+// the rest of the design stays usable.
+void FPGA_CTRL_BuildAccelRegistry(char const *const design, FPGA_CTRL_AccelDesc_t const *const descs)
+{
+    FPGA_CTRL_ClearAccelRegistry();
+    strncpy(accelRegistry.design, design, sizeof(accelRegistry.design) - 1);
+    FPGA_CTRL_AddAccels(descs);
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "FPGA_CTRL: Design %s registered, core mask 0x%02x",
+                      accelRegistry.design[0] != '\0' ? accelRegistry.design : "(unknown)",
+                      (unsigned int)accelRegistry.mask);
+}
+
+// Unmaps every core, called before the fabric is reprogrammed
+void FPGA_CTRL_ClearAccelRegistry(void)
+{
+    for (int type = 0; type < FPGA_CTRL_ACCEL_TYPES; ++type)
+    {
+        FPGA_CTRL_UnmapAccel(type, &accelRegistry.byType[type]);
+    }
+
+    memset(&accelRegistry, 0, sizeof(accelRegistry));
+    globalState.accelMask = 0;
+}
+
+// Maps and registers the cores in descs, on top of those already registered
+void FPGA_CTRL_AddAccels(FPGA_CTRL_AccelDesc_t const *const descs)
+{
+    int32 err;
+
+    for (int i = 0; i < FPGA_CTRL_MAX_ACCELS && descs != NULL; ++i)
+    {
+        FPGA_CTRL_AccelDesc_t const *const desc = &descs[i];
+        if (desc->Type == FPGA_CTRL_ACCEL_NONE || desc->Type >= FPGA_CTRL_ACCEL_TYPES ||
+            accelRegistry.byType[desc->Type].base != NULL)
+        {
+            continue;
+        }
+
+        FPGA_CTRL_Accel_t *const accel = &accelRegistry.byType[desc->Type];
+        void                    *base  = NULL;
+        err                            = mmio_lib_NewMapping(&base, desc->Base, desc->Range);
+        FPGA_CTRL_PROBE4(map__create, desc->Type, desc->Base, desc->Range, err);
+        if (err < CFE_SUCCESS)
+        {
+            atomic_fetch_add_explicit(&accelMapStats.failed, 1, memory_order_relaxed);
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                              "FPGA_CTRL: Failed to map core type %u at 0x%08x, err = %d", (unsigned int)desc->Type,
+                              (unsigned int)desc->Base, (int)err);
+            continue;
+        }
+
+        accel->desc = *desc;
+        accel->base = base;
+        accelRegistry.mask |= 1u << desc->Type;
+        atomic_fetch_add_explicit(&accelMapStats.created, 1, memory_order_relaxed);
+    }
+
+    globalState.accelMask = accelRegistry.mask;
+}
+
+// Unmaps and forgets the cores in descs, before the region holding them is reconfigured
+void FPGA_CTRL_RemoveAccels(FPGA_CTRL_AccelDesc_t const *const descs)
+{
+    for (int i = 0; i < FPGA_CTRL_MAX_ACCELS && descs != NULL; ++i)
+    {
+        uint32 const type = descs[i].Type;
+        if (type == FPGA_CTRL_ACCEL_NONE || type >= FPGA_CTRL_ACCEL_TYPES)
+            continue;
+
+        FPGA_CTRL_Accel_t *const accel = &accelRegistry.byType[type];
+        FPGA_CTRL_UnmapAccel(type, accel);
+
+        memset(accel, 0, sizeof(*accel));
+        accelRegistry.mask &= ~(1u << type);
+    }
+
+    globalState.accelMask = accelRegistry.mask;
+}
+
+// The core of the given type in the loaded design, NULL if there isn't one
+FPGA_CTRL_Accel_t const *FPGA_CTRL_GetAccel(uint32 const type)
+{
+    if (type >= FPGA_CTRL_ACCEL_TYPES || accelRegistry.byType[type].base == NULL)
+        return NULL;
+    return &accelRegistry.byType[type];
+}
+
+// Leaves clearing the registry entry to the caller
+static void FPGA_CTRL_UnmapAccel(uint32 const type, FPGA_CTRL_Accel_t const *const accel)
+{
+    if (accel->base == NULL)
+        return;
+
+    FPGA_CTRL_PROBE3(map__delete, type, accel->base, accel->desc.Range);
+    atomic_fetch_add_explicit(&accelMapStats.deleted, 1, memory_order_relaxed);
+    if (mmio_lib_DeleteMapping((void *)accel->base, accel->desc.Range) < CFE_SUCCESS)
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Failed to unmap core type %u",
+                          (unsigned int)type);
+}
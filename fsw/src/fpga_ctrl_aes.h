@@ -4,98 +4,200 @@
 
 #include "mmio_lib.h"
 
-int32 FPGA_CTRL_Encrypt(FPGA_CTRL_EncryptCmd_t const *Msg);
-
-static void FPGA_CTRL_BinToHexStr(char *hexStr, uint8 const *bin, cpusize binLen);
+#define AES_BLOCK_SIZE           0x10
+#define FPGA_CTRL_AES_TIMEOUT_MS 100 // Longest the core may take before the job gives up on it
+
+// Steps of an encryption job. There's one core, so a job holds it from loading it until it's done and the others
+// wait in LOAD for their turn, taking it in the order they were started.
+#define FPGA_CTRL_AES_LOAD 0 // Wait for the core, then load the key and plaintext and start it
+#define FPGA_CTRL_AES_WAIT 1 // Poll for AP_DONE
+
+// Control register masks
+#define FPGA_CTRL_AES_AP_START 0x01 // Start the encryption
+#define FPGA_CTRL_AES_AP_DONE  0x02 // Encryption is done
+// #define FPGA_CTRL_AES_AP_IDLE      0x04 // Encryption is idle
+// #define FPGA_CTRL_AES_AP_READY     0x08 // Encryption is ready
+// #define FPGA_CTRL_AES_AUTO_RESTART 0x10 // Automatically restart the encryption after it is done
+
+// Offsets within the core's register windows
+#define FPGA_CTRL_AES_KEY_OFFSET        0x20
+#define FPGA_CTRL_AES_PLAINTEXT_OFFSET  0x10
+#define FPGA_CTRL_AES_CYPHERTEXT_OFFSET 0x10
+
+// What an encryption job keeps between steps
+typedef struct
+{
+    char  plaintext[AES_BLOCK_SIZE];
+    int64 startNs; // When the core was started
+} FPGA_CTRL_EncryptJob_t;
 
-int32 FPGA_CTRL_Encrypt(FPGA_CTRL_EncryptCmd_t const *Msg)
+// Core latency from start to done, and give-ups, for the metrics export. Only touched by the main task.
+static struct
 {
-#define AES_BLOCK_SIZE 0x10
-    int32 err;
-
-    // Control register masks
-    static uint8 const AP_START = 0x01; // Start the encryption
-    static uint8 const AP_DONE  = 0x02; // Encryption is done
-    // static uint8 const AP_IDLE      = 0x04; // Encryption is idle
-    // static uint8 const AP_READY     = 0x08; // Encryption is ready
-    // static uint8 const AUTO_RESTART = 0x10; // Automatically restart the encryption after it is done
-
-    // Addresses and sizes
-    static cpuaddr const CONTROL_REGISTER_BASE  = 0x43c00000;
-    static cpuaddr const IN_BASE                = 0x43c10000;
-    static cpuaddr const OUT_BASE               = 0x43c20000;
-    static cpusize const MAP_RANGE              = 0x10000;
-    static cpusize const KEY_BASE_OFFSET        = 0x20;
-    static cpusize const PLAINTEXT_BASE_OFFSET  = 0x10;
-    static cpusize const CYPHERTEXT_BASE_OFFSET = 0x10;
+    FPGA_CTRL_MetricsHist_t latencyUs;
+    uint32                  timeouts;
+} aesStats;
 
-    static uint8 const KEY[AES_BLOCK_SIZE] = {
-        0x2b, 0x28, 0xab, 0x09, 0x7e, 0xae, 0xf7, 0xcf, 0x15, 0xd2, 0x15, 0x4f, 0x16, 0xa6, 0x88, 0x3c,
-    };
+int32  FPGA_CTRL_Encrypt(FPGA_CTRL_EncryptCmd_t const *Msg);
+uint32 FPGA_CTRL_EncryptsPending(void);
 
-    char const *const plaintext = Msg->data;
+static int32 FPGA_CTRL_EncryptStep(FPGA_CTRL_Job_t *job);
+static bool  FPGA_CTRL_AesTurn(FPGA_CTRL_Job_t const *job);
+static void  FPGA_CTRL_BinToHexStr(char *hexStr, uint8 const *bin, cpusize binLen);
 
-    uint8 volatile *const controlReg = NULL;
-    void volatile *const  inBlk      = NULL;
-    void volatile *const  outBlk     = NULL;
-    if ((err = mmio_lib_NewMapping((void **)&controlReg, CONTROL_REGISTER_BASE, MAP_RANGE)) < CFE_SUCCESS)
-        return err;
-    if ((err = mmio_lib_NewMapping((void **)&inBlk, IN_BASE, MAP_RANGE)) < CFE_SUCCESS)
-        return err;
-    if ((err = mmio_lib_NewMapping((void **)&outBlk, OUT_BASE, MAP_RANGE)) < CFE_SUCCESS)
-        return err;
+// Starts an encryption job, the cyphertext is reported once the core is done. Jobs started while the core is busy
+// queue for it.
+int32 FPGA_CTRL_Encrypt(FPGA_CTRL_EncryptCmd_t const *Msg)
+{
+    FPGA_CTRL_EncryptJob_t ctx;
 
-    void volatile *const       plaintextReg = (void volatile *const)((cpuaddr)inBlk + (cpusize)PLAINTEXT_BASE_OFFSET);
-    void volatile *const       keyReg       = (void volatile *const)((cpuaddr)inBlk + (cpusize)KEY_BASE_OFFSET);
-    void const volatile *const cyphertextReg =
-        (void volatile *const)((cpuaddr)outBlk + (cpusize)CYPHERTEXT_BASE_OFFSET);
+    if (FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_AES_CTRL) == NULL || FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_AES_IN) == NULL ||
+        FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_AES_OUT) == NULL)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "The loaded design has no AES core");
+        return CFE_STATUS_INCORRECT_STATE;
+    }
 
-    OS_printf("Copying key to PL...\n");
-    memcpy((void *)keyReg, (void *)KEY, AES_BLOCK_SIZE);
+    memset(&ctx, 0, sizeof(ctx));
+    memcpy(ctx.plaintext, Msg->data, sizeof(ctx.plaintext));
+    return FPGA_CTRL_StartJob("encrypt", FPGA_CTRL_EncryptStep, FPGA_CTRL_JOB_FABRIC, &ctx, sizeof(ctx));
+}
 
-    OS_printf("Copying plaintext to PL...\n");
-    memcpy((void *)plaintextReg, (void *)plaintext, AES_BLOCK_SIZE);
+// Encryptions started and not finished yet, running or queued for the core
+uint32 FPGA_CTRL_EncryptsPending(void)
+{
+    uint32 pending = 0;
 
-    OS_printf("Control register = 0x%02x\n", *controlReg);
+    for (uint32 i = 0; i < FPGA_CTRL_MAX_JOBS; ++i)
+        pending += jobSched.jobs[i].step == FPGA_CTRL_EncryptStep;
+    return pending;
+}
 
-    char plaintextHex[AES_BLOCK_SIZE * 2 + 1]; // 2 hex digits per byte + null terminator
-    FPGA_CTRL_BinToHexStr(plaintextHex, (uint8 const *)plaintext, AES_BLOCK_SIZE);
+// Loads and starts the core in the first step, then polls it once a step instead of busy waiting.
+// The cores are looked up again every step, the registry may have changed in between.
+static int32 FPGA_CTRL_EncryptStep(FPGA_CTRL_Job_t *const job)
+{
+    static uint8 const KEY[AES_BLOCK_SIZE] = {
+        0x2b, 0x28, 0xab, 0x09, 0x7e, 0xae, 0xf7, 0xcf, 0x15, 0xd2, 0x15, 0x4f, 0x16, 0xa6, 0x88, 0x3c,
+    };
 
-    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Starting encryption on %s...",
-                      plaintextHex);
-    CFE_TIME_SysTime_t const startTime = CFE_TIME_GetTime();
-    *controlReg |= AP_START;
+    FPGA_CTRL_EncryptJob_t *const ctx = (FPGA_CTRL_EncryptJob_t *)job->ctx.bytes;
 
-    // Poll for AP_DONE
-    while (!(*controlReg & AP_DONE))
+    // Mapped by the accelerator registry when the design was loaded
+    FPGA_CTRL_Accel_t const *const controlAccel = FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_AES_CTRL);
+    FPGA_CTRL_Accel_t const *const inAccel      = FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_AES_IN);
+    FPGA_CTRL_Accel_t const *const outAccel     = FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_AES_OUT);
+    if (!globalState.fabricUp || controlAccel == NULL || inAccel == NULL || outAccel == NULL)
     {
-        // Busy wait
+        if (job->state == FPGA_CTRL_AES_WAIT)
+        {
+            CFE_ES_PerfLogExit(FPGA_CTRL_AES_WAIT_PERF_ID);
+            FPGA_CTRL_PROBE3(encrypt__done, CFE_STATUS_INCORRECT_STATE,
+                             (FPGA_CTRL_MonotonicNs() - ctx->startNs) / 1000, job->slices);
+        }
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "AES core went away mid encryption");
+        return CFE_STATUS_INCORRECT_STATE;
     }
 
-    CFE_TIME_SysTime_t const timeTaken      = CFE_TIME_Subtract(CFE_TIME_GetTime(), startTime);
-    uint32 const             microSecsTaken = CFE_TIME_Sub2MicroSecs(timeTaken.Subseconds);
-
-    OS_printf("Control register = 0x%02x\n", *controlReg);
-    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Encryption done in %u us",
-                      microSecsTaken);
+    uint8 volatile *const controlReg = controlAccel->base;
+    void volatile *const  inBlk      = inAccel->base;
+    void volatile *const  outBlk     = outAccel->base;
 
-    uint8 cyphertext[AES_BLOCK_SIZE] = {0};
-    memcpy((void *)cyphertext, (void *)cyphertextReg, AES_BLOCK_SIZE);
+    void volatile *const plaintextReg =
+        (void volatile *const)((cpuaddr)inBlk + (cpusize)FPGA_CTRL_AES_PLAINTEXT_OFFSET);
+    void volatile *const       keyReg = (void volatile *const)((cpuaddr)inBlk + (cpusize)FPGA_CTRL_AES_KEY_OFFSET);
+    void const volatile *const cyphertextReg =
+        (void volatile *const)((cpuaddr)outBlk + (cpusize)FPGA_CTRL_AES_CYPHERTEXT_OFFSET);
 
-    char cyphertextHexString[2 * AES_BLOCK_SIZE + 1] = {'\0'}; // 2 hex digits per byte + null terminator
-    FPGA_CTRL_BinToHexStr(cyphertextHexString, (void *)cyphertext, AES_BLOCK_SIZE);
-    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Cyphertext: %s", cyphertextHexString);
-    memcpy(globalState.cyphertextHexString, cyphertextHexString, sizeof(globalState.cyphertextHexString));
+    switch (job->state)
+    {
+        case FPGA_CTRL_AES_LOAD:
+        {
+            if (!FPGA_CTRL_AesTurn(job))
+                return FPGA_CTRL_JOB_PENDING;
+
+            CFE_ES_PerfLogEntry(FPGA_CTRL_AES_LOAD_PERF_ID);
+            FPGA_CTRL_TRACE(DEBUG, AES, "Copying key to PL");
+            memcpy((void *)keyReg, (void *)KEY, AES_BLOCK_SIZE);
+
+            FPGA_CTRL_TRACE(DEBUG, AES, "Copying plaintext to PL");
+            memcpy((void *)plaintextReg, (void *)ctx->plaintext, AES_BLOCK_SIZE);
+
+            FPGA_CTRL_TRACE(DEBUG, AES, "Control register = 0x%02x", *controlReg);
+
+            char plaintextHex[AES_BLOCK_SIZE * 2 + 1]; // 2 hex digits per byte + null terminator
+            FPGA_CTRL_BinToHexStr(plaintextHex, (uint8 const *)ctx->plaintext, AES_BLOCK_SIZE);
+
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Starting encryption on %s...",
+                              plaintextHex);
+            CFE_ES_PerfLogExit(FPGA_CTRL_AES_LOAD_PERF_ID);
+
+            // Closed in whichever step sees the core finish, or give up on it
+            CFE_ES_PerfLogEntry(FPGA_CTRL_AES_WAIT_PERF_ID);
+            ctx->startNs = FPGA_CTRL_MonotonicNs();
+            *controlReg |= FPGA_CTRL_AES_AP_START;
+            FPGA_CTRL_PROBE1(encrypt__start, (ctx->startNs - job->startNs) / 1000);
+
+            job->state = FPGA_CTRL_AES_WAIT;
+            return FPGA_CTRL_JOB_PENDING;
+        }
+
+        case FPGA_CTRL_AES_WAIT:
+        {
+            int64 const elapsedNs = FPGA_CTRL_MonotonicNs() - ctx->startNs;
+            if (!(*controlReg & FPGA_CTRL_AES_AP_DONE))
+            {
+                if (elapsedNs < FPGA_CTRL_AES_TIMEOUT_MS * 1000000LL)
+                    return FPGA_CTRL_JOB_PENDING;
+
+                CFE_ES_PerfLogExit(FPGA_CTRL_AES_WAIT_PERF_ID);
+                FPGA_CTRL_PROBE3(encrypt__done, CFE_STATUS_EXTERNAL_RESOURCE_FAIL, elapsedNs / 1000, job->slices);
+                ++aesStats.timeouts;
+                CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                                  "Encryption not done after %u ms, control register = 0x%02x",
+                                  (unsigned int)FPGA_CTRL_AES_TIMEOUT_MS, *controlReg);
+                return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+            }
+
+            CFE_ES_PerfLogExit(FPGA_CTRL_AES_WAIT_PERF_ID);
+            FPGA_CTRL_PROBE3(encrypt__done, CFE_SUCCESS, elapsedNs / 1000, job->slices);
+            FPGA_CTRL_MetricsObserve(&aesStats.latencyUs, (uint32)(elapsedNs / 1000));
+            FPGA_CTRL_TRACE(DEBUG, AES, "Control register = 0x%02x", *controlReg);
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                              "Encryption done in %u us, %u slices", (unsigned int)(elapsedNs / 1000),
+                              (unsigned int)job->slices);
+
+            uint8 cyphertext[AES_BLOCK_SIZE] = {0};
+            memcpy((void *)cyphertext, (void *)cyphertextReg, AES_BLOCK_SIZE);
+
+            char cyphertextHexString[2 * AES_BLOCK_SIZE + 1] = {'\0'}; // 2 hex digits per byte + null terminator
+            FPGA_CTRL_BinToHexStr(cyphertextHexString, (void *)cyphertext, AES_BLOCK_SIZE);
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Cyphertext: %s",
+                              cyphertextHexString);
+            memcpy(globalState.cyphertextHexString, cyphertextHexString, sizeof(globalState.cyphertextHexString));
+
+            return CFE_SUCCESS;
+        }
+
+        default:
+            return CFE_STATUS_INCORRECT_STATE;
+    }
+}
 
-    if ((err = mmio_lib_DeleteMapping((void *)controlReg, MAP_RANGE)) < CFE_SUCCESS)
-        return err;
-    if ((err = mmio_lib_DeleteMapping((void *)inBlk, MAP_RANGE)) < CFE_SUCCESS)
-        return err;
-    if ((err = mmio_lib_DeleteMapping((void *)outBlk, MAP_RANGE)) < CFE_SUCCESS)
-        return err;
+// Whether the core is free and no job waiting for it was started before this one. Worked out from the job slots
+// rather than kept as a flag, so a job cancelled while it holds the core doesn't keep it.
+static bool FPGA_CTRL_AesTurn(FPGA_CTRL_Job_t const *const job)
+{
+    for (uint32 i = 0; i < FPGA_CTRL_MAX_JOBS; ++i)
+    {
+        FPGA_CTRL_Job_t const *const other = &jobSched.jobs[i];
+        if (other == job || other->step != FPGA_CTRL_EncryptStep)
+            continue;
 
-    return CFE_SUCCESS;
-#undef AES_BLOCK_SIZE
+        if (other->state == FPGA_CTRL_AES_WAIT || (int32)(other->seq - job->seq) < 0)
+            return false;
+    }
+    return true;
 }
 
 static void FPGA_CTRL_BinToHexStr(char *const hexStrBuf, uint8 const *const bin, cpusize const binLen)
@@ -0,0 +1,253 @@
+// Keeps the bitstreams named in the table mapped in memory so switching designs doesn't wait on storage. Each file
+// is checksummed when it's mapped and checked against that before each time it's staged, the least recently used
+// ones are unmapped to stay under the table's byte limit.
+// LZ4 compressed bitstreams stay compressed in the cache and are decompressed while staging.
+// Only the main task during init and the reprogram task touch the cache, never both at once.
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+#include "fpga_ctrl_table.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+typedef struct
+{
+    char         name[FPGA_CTRL_BITSTREAM_NAME_LEN];
+    char         path[FPGA_CTRL_BITSTREAM_PATH_LEN];
+    uint8 const *data; // Read-only mapping of the whole file, NULL if the slot is free
+    uint32       size;
+    uint32       crc;      // CRC-32C of data as cached, computed when mapped
+    uint64       lastUsed; // bitstreamCache.useClock at the last lookup
+
+    // Where this image was last staged in the firmware directory, so an untouched copy isn't written again
+    bool            staged;
+    dev_t           stagedDev;
+    ino_t           stagedIno;
+    struct timespec stagedMtime;
+    uint32          stagedSize; // Decompressed size for LZ4 images
+} FPGA_CTRL_CachedBitstream_t;
+
+typedef struct
+{
+    FPGA_CTRL_CachedBitstream_t slots[FPGA_CTRL_MAX_BITSTREAMS];
+    uint64                      useClock;
+} FPGA_CTRL_BitstreamCache_t;
+
+static FPGA_CTRL_BitstreamCache_t bitstreamCache;
+
+// Exported functions
+void  FPGA_CTRL_InitBitstreamCache(void);
+int32 FPGA_CTRL_BitstreamCacheGet(char const *name, FPGA_CTRL_CachedBitstream_t **cached);
+int32 FPGA_CTRL_BitstreamCacheCheck(FPGA_CTRL_CachedBitstream_t *cached);
+
+static int32 FPGA_CTRL_BitstreamCacheLoad(char const *name, char const *path, uint32 limit,
+                                          FPGA_CTRL_CachedBitstream_t **cached);
+static void  FPGA_CTRL_BitstreamCacheEvict(FPGA_CTRL_CachedBitstream_t *slot);
+
+// Maps every bitstream the table marks for preloading
+void FPGA_CTRL_InitBitstreamCache(void)
+{
+    FPGA_CTRL_Table_t           *tblPtr;
+    FPGA_CTRL_CachedBitstream_t *cached;
+
+    FPGA_CTRL_StatsBegin(&globalState.BitstreamStats.lock);
+    globalState.BitstreamStats.cacheHits    = 0;
+    globalState.BitstreamStats.cacheMisses  = 0;
+    globalState.BitstreamStats.cacheBytes   = 0;
+    globalState.BitstreamStats.cacheEntries = 0;
+    FPGA_CTRL_StatsEnd(&globalState.BitstreamStats.lock);
+
+    if (CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0]) < CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Couldn't read table, no bitstreams preloaded");
+        return;
+    }
+
+    for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+    {
+        FPGA_CTRL_BitstreamEntry_t const *const entry = &tblPtr->Bitstreams[i];
+        if (entry->Name[0] == '\0' || !entry->Preload)
+            continue;
+
+        // Failures are reported by the load, the bitstream is retried on first use
+        FPGA_CTRL_BitstreamCacheLoad(entry->Name, entry->Path, tblPtr->BitstreamCacheLimit, &cached);
+    }
+
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "FPGA_CTRL: Preloaded %u bitstreams, %u bytes",
+                      (unsigned int)globalState.BitstreamStats.cacheEntries,
+                      (unsigned int)globalState.BitstreamStats.cacheBytes);
+}
+
+// Finds a bitstream by its table name, mapping it on a miss
+int32 FPGA_CTRL_BitstreamCacheGet(char const *const name, FPGA_CTRL_CachedBitstream_t **const cached)
+{
+    for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+    {
+        FPGA_CTRL_CachedBitstream_t *const slot = &bitstreamCache.slots[i];
+        if (slot->data != NULL && strcmp(slot->name, name) == 0)
+        {
+            slot->lastUsed = ++bitstreamCache.useClock;
+            FPGA_CTRL_StatsBegin(&globalState.BitstreamStats.lock);
+            ++globalState.BitstreamStats.cacheHits;
+            FPGA_CTRL_StatsEnd(&globalState.BitstreamStats.lock);
+            *cached = slot;
+            return CFE_SUCCESS;
+        }
+    }
+
+    FPGA_CTRL_StatsBegin(&globalState.BitstreamStats.lock);
+    ++globalState.BitstreamStats.cacheMisses;
+    FPGA_CTRL_StatsEnd(&globalState.BitstreamStats.lock);
+
+    FPGA_CTRL_Table_t *tblPtr;
+    int32              err;
+    if ((err = CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0])) < CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Couldn't read table to look up bitstream %s", name);
+        return err;
+    }
+
+    err = CFE_STATUS_VALIDATION_FAILURE;
+    for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+    {
+        FPGA_CTRL_BitstreamEntry_t const *const entry = &tblPtr->Bitstreams[i];
+        if (entry->Name[0] != '\0' && strcmp(entry->Name, name) == 0)
+        {
+            err = FPGA_CTRL_BitstreamCacheLoad(entry->Name, entry->Path, tblPtr->BitstreamCacheLimit, cached);
+            break;
+        }
+    }
+
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+
+    if (err == CFE_STATUS_VALIDATION_FAILURE)
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: No bitstream named %s",
+                          name);
+
+    return err;
+}
+
+// Checks a cached image against the CRC taken when it was mapped, before it's staged from memory. A mismatch means
+// the cached pages changed since, the file under the mapping was rewritten or memory was corrupted. The slot is
+// evicted, so the next load maps the file again, and the slot must not be used after a failure.
+int32 FPGA_CTRL_BitstreamCacheCheck(FPGA_CTRL_CachedBitstream_t *const cached)
+{
+    uint32       threads;
+    uint32 const crc = FPGA_CTRL_Crc32cParallel(cached->data, cached->size, &threads);
+
+    if (crc == cached->crc)
+        return CFE_SUCCESS;
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                      "FPGA_CTRL: Cached bitstream %s changed since it was mapped, CRC 0x%08x, was 0x%08x",
+                      cached->name, (unsigned int)crc, (unsigned int)cached->crc);
+    FPGA_CTRL_BitstreamCacheEvict(cached);
+    return CFE_STATUS_VALIDATION_FAILURE;
+}
+
+// Maps the file and pulls all of it into memory up front, evicting the least recently used bitstreams to make room
+static int32 FPGA_CTRL_BitstreamCacheLoad(char const *const name, char const *const path, uint32 const limit,
+                                          FPGA_CTRL_CachedBitstream_t **const cached)
+{
+    int const fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Failed to open bitstream %s",
+                          path);
+        return CFE_FS_INVALID_PATH;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) < 0 || fileStat.st_size == 0 || (uint64)fileStat.st_size > limit)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Bitstream %s is empty or larger than the %u byte cache", path,
+                          (unsigned int)limit);
+        close(fd);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+    uint32 const size = (uint32)fileStat.st_size;
+
+    FPGA_CTRL_CachedBitstream_t *slot = NULL;
+    for (;;)
+    {
+        FPGA_CTRL_CachedBitstream_t *lru = NULL;
+        slot                             = NULL;
+        for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+        {
+            FPGA_CTRL_CachedBitstream_t *const candidate = &bitstreamCache.slots[i];
+            if (candidate->data == NULL)
+                slot = slot != NULL ? slot : candidate;
+            else if (lru == NULL || candidate->lastUsed < lru->lastUsed)
+                lru = candidate;
+        }
+
+        if (slot != NULL && globalState.BitstreamStats.cacheBytes + size <= limit)
+            break;
+        if (lru == NULL)
+        {
+            close(fd);
+            return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+        }
+
+        FPGA_CTRL_BitstreamCacheEvict(lru);
+    }
+
+    void *const data = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Failed to map bitstream %s",
+                          path);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    // Clean file pages can be dropped under memory pressure, locking keeps them resident. Best effort.
+    mlock(data, size);
+
+    memset(slot, 0, sizeof(*slot));
+    strncpy(slot->name, name, sizeof(slot->name) - 1);
+    strncpy(slot->path, path, sizeof(slot->path) - 1);
+    slot->data     = data;
+    slot->size     = size;
+    slot->crc      = FPGA_CTRL_Crc32c(0, data, size);
+    slot->lastUsed = ++bitstreamCache.useClock;
+
+    FPGA_CTRL_StatsBegin(&globalState.BitstreamStats.lock);
+    globalState.BitstreamStats.cacheBytes += size;
+    ++globalState.BitstreamStats.cacheEntries;
+    FPGA_CTRL_StatsEnd(&globalState.BitstreamStats.lock);
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "FPGA_CTRL: Cached bitstream %s, %u bytes, CRC 0x%08x", name, (unsigned int)size,
+                      (unsigned int)slot->crc);
+
+    *cached = slot;
+    return CFE_SUCCESS;
+}
+
+static void FPGA_CTRL_BitstreamCacheEvict(FPGA_CTRL_CachedBitstream_t *const slot)
+{
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "FPGA_CTRL: Evicting bitstream %s",
+                      slot->name);
+
+    munmap((void *)slot->data, slot->size);
+    FPGA_CTRL_StatsBegin(&globalState.BitstreamStats.lock);
+    globalState.BitstreamStats.cacheBytes -= slot->size;
+    --globalState.BitstreamStats.cacheEntries;
+    FPGA_CTRL_StatsEnd(&globalState.BitstreamStats.lock);
+
+    memset(slot, 0, sizeof(*slot));
+}
@@ -0,0 +1,274 @@
+// CRC-32C (Castagnoli), used to check bitstreams against the checksums in the table before they're programmed.
+// Uses the CRC instructions of SSE4.2 or ARMv8 when the CPU has them, picked at runtime, and a slicing-by-8 table
+// otherwise. Large images are split across threads and the partial CRCs combined, so the check costs a fraction of
+// the time it takes the manager to program them.
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#endif
+
+#include "cfe.h"
+
+#define FPGA_CTRL_CRC32C_POLY        0x82F63B78u // Reflected Castagnoli polynomial
+#define FPGA_CTRL_CRC32C_MAX_THREADS 4
+#define FPGA_CTRL_CRC32C_SPLIT_BYTES (1024 * 1024) // Smallest piece worth starting a thread for
+
+// Advances a CRC kept inverted, the public functions do the inversions
+typedef uint32 (*FPGA_CTRL_Crc32cUpdate_t)(uint32 crc, uint8 const *data, size_t len);
+
+typedef struct
+{
+    FPGA_CTRL_Crc32cUpdate_t update;
+    char const              *implName;
+    uint32                   table[8][256]; // Slicing-by-8 tables for the software fallback
+    uint32                   x2n[32];       // x^(2^n) mod P, for combining the CRCs of split buffers
+} FPGA_CTRL_Crc32c_t;
+
+// One thread's share of a split buffer
+typedef struct
+{
+    uint8 const *data;
+    size_t       len;
+    uint32       crc;
+    pthread_t    thread;
+    bool         threaded;
+} FPGA_CTRL_Crc32cPiece_t;
+
+static FPGA_CTRL_Crc32c_t crc32c;
+static pthread_once_t     crc32cOnce = PTHREAD_ONCE_INIT;
+
+// Exported functions
+uint32      FPGA_CTRL_Crc32c(uint32 crc, void const *data, size_t len);
+uint32      FPGA_CTRL_Crc32cParallel(void const *data, size_t len, uint32 *threadsUsed);
+char const *FPGA_CTRL_Crc32cImplName(void);
+
+static void   FPGA_CTRL_Crc32cInit(void);
+static uint32 FPGA_CTRL_Crc32cSoftware(uint32 crc, uint8 const *data, size_t len);
+static uint32 FPGA_CTRL_Crc32cMultModP(uint32 a, uint32 b);
+static uint32 FPGA_CTRL_Crc32cCombine(uint32 crc1, uint32 crc2, size_t len2);
+static void  *FPGA_CTRL_Crc32cWorker(void *arg);
+
+#if defined(__x86_64__) || defined(__i386__)
+// crc32 with a 64 bit operand does 8 bytes per instruction, the head is byte-stepped so the loads are aligned
+__attribute__((target("sse4.2"))) static uint32 FPGA_CTRL_Crc32cHardware(uint32 crc, uint8 const *data, size_t len)
+{
+    while (len > 0 && ((uintptr_t)data & 7) != 0)
+    {
+        crc = _mm_crc32_u8(crc, *data++);
+        --len;
+    }
+
+#if defined(__x86_64__)
+    uint64 crc64 = crc;
+    for (; len >= 8; data += 8, len -= 8)
+    {
+        uint64 word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = (uint32)crc64;
+#endif
+
+    for (; len >= 4; data += 4, len -= 4)
+    {
+        uint32 word;
+        memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+
+    while (len-- > 0)
+        crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+#elif defined(__aarch64__)
+__attribute__((target("+crc"))) static uint32 FPGA_CTRL_Crc32cHardware(uint32 crc, uint8 const *data, size_t len)
+{
+    while (len > 0 && ((uintptr_t)data & 7) != 0)
+    {
+        crc = __crc32cb(crc, *data++);
+        --len;
+    }
+
+    for (; len >= 8; data += 8, len -= 8)
+    {
+        uint64 word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+
+    while (len-- > 0)
+        crc = __crc32cb(crc, *data++);
+    return crc;
+}
+#endif
+
+uint32 FPGA_CTRL_Crc32c(uint32 const crc, void const *const data, size_t const len)
+{
+    pthread_once(&crc32cOnce, FPGA_CTRL_Crc32cInit);
+    return ~crc32c.update(~crc, data, len);
+}
+
+// Splits the buffer into up to FPGA_CTRL_CRC32C_MAX_THREADS pieces checksummed at once, the caller takes the first.
+// These are plain pthreads because the callers run on cFE child tasks, which can't create child tasks of their own.
+uint32 FPGA_CTRL_Crc32cParallel(void const *const data, size_t const len, uint32 *const threadsUsed)
+{
+    FPGA_CTRL_Crc32cPiece_t pieces[FPGA_CTRL_CRC32C_MAX_THREADS];
+    long const              cpus    = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t                  nPieces = len / FPGA_CTRL_CRC32C_SPLIT_BYTES;
+
+    if (nPieces > FPGA_CTRL_CRC32C_MAX_THREADS)
+        nPieces = FPGA_CTRL_CRC32C_MAX_THREADS;
+    if (cpus > 0 && nPieces > (size_t)cpus)
+        nPieces = (size_t)cpus;
+    if (nPieces == 0)
+        nPieces = 1;
+
+    pthread_once(&crc32cOnce, FPGA_CTRL_Crc32cInit);
+
+    size_t const pieceLen = len / nPieces;
+    for (size_t i = 0; i < nPieces; ++i)
+    {
+        pieces[i].data     = (uint8 const *)data + i * pieceLen;
+        pieces[i].len      = i + 1 < nPieces ? pieceLen : len - i * pieceLen;
+        pieces[i].threaded = false;
+    }
+
+    // A piece whose thread can't be started is done inline after the first
+    *threadsUsed = 1;
+    for (size_t i = 1; i < nPieces; ++i)
+    {
+        pieces[i].threaded = pthread_create(&pieces[i].thread, NULL, FPGA_CTRL_Crc32cWorker, &pieces[i]) == 0;
+        *threadsUsed += pieces[i].threaded;
+    }
+
+    FPGA_CTRL_Crc32cWorker(&pieces[0]);
+
+    uint32 crc = pieces[0].crc;
+    for (size_t i = 1; i < nPieces; ++i)
+    {
+        if (pieces[i].threaded)
+            pthread_join(pieces[i].thread, NULL);
+        else
+            FPGA_CTRL_Crc32cWorker(&pieces[i]);
+        crc = FPGA_CTRL_Crc32cCombine(crc, pieces[i].crc, pieces[i].len);
+    }
+
+    return crc;
+}
+
+char const *FPGA_CTRL_Crc32cImplName(void)
+{
+    pthread_once(&crc32cOnce, FPGA_CTRL_Crc32cInit);
+    return crc32c.implName;
+}
+
+static void FPGA_CTRL_Crc32cInit(void)
+{
+    for (uint32 i = 0; i < 256; ++i)
+    {
+        uint32 entry = i;
+        for (int bit = 0; bit < 8; ++bit)
+            entry = (entry >> 1) ^ (FPGA_CTRL_CRC32C_POLY & -(entry & 1));
+        crc32c.table[0][i] = entry;
+    }
+    for (uint32 i = 0; i < 256; ++i)
+    {
+        for (int k = 1; k < 8; ++k)
+            crc32c.table[k][i] = (crc32c.table[k - 1][i] >> 8) ^ crc32c.table[0][crc32c.table[k - 1][i] & 0xFF];
+    }
+
+    // Bit 31 is x^0 in the reflected representation, so x^1 is bit 30
+    uint32 power = 1u << 30;
+    crc32c.x2n[0] = power;
+    for (int n = 1; n < 32; ++n)
+        crc32c.x2n[n] = power = FPGA_CTRL_Crc32cMultModP(power, power);
+
+    crc32c.update   = FPGA_CTRL_Crc32cSoftware;
+    crc32c.implName = "software";
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        crc32c.update   = FPGA_CTRL_Crc32cHardware;
+        crc32c.implName = "sse4.2";
+    }
+#elif defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+    {
+        crc32c.update   = FPGA_CTRL_Crc32cHardware;
+        crc32c.implName = "armv8 crc";
+    }
+#endif
+}
+
+static uint32 FPGA_CTRL_Crc32cSoftware(uint32 crc, uint8 const *data, size_t len)
+{
+    uint32 const(*const table)[256] = crc32c.table;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (len > 0 && ((uintptr_t)data & 7) != 0)
+    {
+        crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xFF];
+        --len;
+    }
+
+    for (; len >= 8; data += 8, len -= 8)
+    {
+        uint32 lo, hi;
+        memcpy(&lo, data, sizeof(lo));
+        memcpy(&hi, data + 4, sizeof(hi));
+        lo ^= crc;
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^ table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+    }
+#endif
+
+    while (len-- > 0)
+        crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xFF];
+    return crc;
+}
+
+// Multiplies two polynomials modulo P, a must be non-zero
+static uint32 FPGA_CTRL_Crc32cMultModP(uint32 const a, uint32 b)
+{
+    uint32 m = 1u << 31;
+    uint32 p = 0;
+    for (;;)
+    {
+        if (a & m)
+        {
+            p ^= b;
+            if ((a & (m - 1)) == 0)
+                break;
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ FPGA_CTRL_CRC32C_POLY : b >> 1;
+    }
+    return p;
+}
+
+// CRC of the concatenation of two buffers from their CRCs: crc1 shifted past len2 zero bytes, xored with crc2
+static uint32 FPGA_CTRL_Crc32cCombine(uint32 const crc1, uint32 const crc2, size_t len2)
+{
+    uint32 shift = 1u << 31; // x^0
+    for (int k = 3; len2 != 0; len2 >>= 1, ++k) // len2 bytes are 2^3 * len2 bits
+    {
+        if (len2 & 1)
+            shift = FPGA_CTRL_Crc32cMultModP(crc32c.x2n[k & 31], shift);
+    }
+    return FPGA_CTRL_Crc32cMultModP(shift, crc1) ^ crc2;
+}
+
+static void *FPGA_CTRL_Crc32cWorker(void *const arg)
+{
+    FPGA_CTRL_Crc32cPiece_t *const piece = arg;
+    piece->crc                           = ~crc32c.update(~0u, piece->data, piece->len);
+    return NULL;
+}
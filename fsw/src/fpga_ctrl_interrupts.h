@@ -7,301 +7,525 @@
 #include "cfe.h"
 #include "mmio_lib.h"
 #include "fpga_ctrl.h"
+#include "fpga_ctrl_table.h"
 
 // Defined in fpga_ctrl.c
 extern FPGA_CTRL_Data_t globalState;
 
-// Exported function
+// Length of the window the interrupt rate is measured over
+#define FPGA_CTRL_IRQ_RATE_WINDOW_MS 100
+
+// Adaptive interrupt/polling parameters, copied out of the table when the child starts
+typedef struct
+{
+    uint32 pollEnterRate;  // Interrupts per second that trigger poll mode, 0 = never poll
+    uint16 pollBudget;     // GPIO reads per busy-poll pass
+    uint16 pollIdleExitMs; // Idle time before going back to interrupts
+} FPGA_CTRL_IrqConfig_t;
+
+// Bookkeeping for the adaptive mode, local to the child task
+typedef struct
+{
+    OS_time_t modeStart;    // When time in the current mode was last accounted
+    OS_time_t windowStart;  // Start of the current rate measurement window
+    OS_time_t lastActivity; // Last GPIO change seen while polling
+    uint32    windowEvents; // Interrupts seen in the current window
+} FPGA_CTRL_IrqModeState_t;
+
+// The FPGA_INTERRUPTS_TEST build runs against the fake source so it can be driven by the load generator on a host
+// #define FPGA_INTERRUPTS_TEST
+#ifdef FPGA_INTERRUPTS_TEST
+static FPGA_CTRL_IrqDevice_t irqDev = {.source = &FPGA_CTRL_FakeIrqSource, .uioFd = -1};
+#else
+static FPGA_CTRL_IrqDevice_t irqDev = {.source = &FPGA_CTRL_UioIrqSource, .uioFd = -1};
+#endif
+
+// Exported functions
+int32 FPGA_CTRL_InitInterrupts(void);
+void  FPGA_CTRL_CleanupInterrupts(void);
 int32 FPGA_CTRL_IntCtrl(FPGA_CTRL_IntCtrlCmd_t const *SBBufPtr);
 
-static void  FPGA_CTRL_WaitForButton(void);
-static int32 FPGA_CTRL_ResetInterrupts(int uioFd, uint32 volatile *isr);
-static void  FPGA_CTRL_FullCleanupChildTaskAndExit(int uioFd, void volatile *btnBase, cpusize btnBaseMapRange,
-                                                   void volatile *swBase, cpusize swBaseMapRange);
-static void  FPGA_CTRL_ExitChildTask(void);
+static void   FPGA_CTRL_WaitForButton(void);
+static void   FPGA_CTRL_SetGpioIrqMasked(bool masked);
+static void   FPGA_CTRL_GetIrqConfig(FPGA_CTRL_IrqConfig_t *config);
+static uint32 FPGA_CTRL_MsSince(OS_time_t since, OS_time_t now);
+static void   FPGA_CTRL_AccountIrqModeTime(FPGA_CTRL_IrqModeState_t *state, OS_time_t now);
+static void   FPGA_CTRL_SendButtonTlm(uint8 switchPos);
+static bool   FPGA_CTRL_BusyPollPass(void volatile *btnBase, void volatile *swBase, bool *lastButtonPressed,
+                                     uint16 budget);
+static int32  FPGA_CTRL_ResetInterrupts(void);
+static void   FPGA_CTRL_ExitChildTask(void);
+
+// Opens the interrupt source, maps the GPIO blocks and starts the (paused) interrupt child task.
+// Interrupts stay masked until FPGA_CTRL_INT_CTRL_CC enables them.
+int32 FPGA_CTRL_InitInterrupts(void)
+{
+    int32 err;
+
+    globalState.irqEnabled     = false;
+    globalState.irqTaskRunning = false;
+    globalState.childTaskId    = CFE_ES_TASKID_UNDEFINED;
+
+    if ((err = OS_BinSemCreate(&irqDev.wakeSem, "FPGA_CTRL irq sem", OS_SEM_EMPTY, 0)) != OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to create interrupt semaphore: %d", err);
+        return err;
+    }
+
+    if ((err = irqDev.source->Open(&irqDev)) != CFE_SUCCESS)
+    {
+        FPGA_CTRL_CleanupInterrupts();
+        return err;
+    }
+
+    irqDev.gier = (uint32 volatile *)((cpuaddr)irqDev.btnBase + GIER_OFFSET);
+    irqDev.ier  = (uint32 volatile *)((cpuaddr)irqDev.btnBase + IER_OFFSET);
+    irqDev.isr  = (uint32 volatile *)((cpuaddr)irqDev.btnBase + ISR_OFFSET);
+
+    // Global enable stays on for the app's lifetime, channel 1 is gated through IER
+    // FIXME - the following line segfaults with compiled with -O
+    *irqDev.gier |= GIER_ENABLE_MASK;
+    FPGA_CTRL_SetGpioIrqMasked(true);
+
+    irqDev.available = true;
+
+    FPGA_CTRL_SchedProfile_t const *const profile = &globalState.SchedProfile;
+    if ((err = CFE_ES_CreateChildTask(
+             &globalState.childTaskId, "FPGA_CTRL child", FPGA_CTRL_WaitForButton, CFE_ES_TASK_STACK_ALLOCATE,
+             profile->IrqTaskStackSize != 0 ? profile->IrqTaskStackSize : CFE_PLATFORM_ES_DEFAULT_STACK_SIZE,
+             profile->IrqTaskPriority != 0 ? profile->IrqTaskPriority : CFE_PLATFORM_ES_PERF_CHILD_PRIORITY, 0)) <
+        CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to create child task: 0x%x", err);
+        globalState.childTaskId = CFE_ES_TASKID_UNDEFINED;
+        FPGA_CTRL_CleanupInterrupts();
+        return err;
+    }
+    globalState.irqTaskRunning = true;
 
+    return CFE_SUCCESS;
+}
+
+// Stops the child and releases the device, called when the app exits and before the fabric is reprogrammed
+void FPGA_CTRL_CleanupInterrupts(void)
+{
+    globalState.irqEnabled = false;
+
+    if (globalState.irqTaskRunning)
+    {
+        CFE_ES_DeleteChildTask(globalState.childTaskId);
+        globalState.irqTaskRunning = false;
+        globalState.childTaskId    = CFE_ES_TASKID_UNDEFINED;
+    }
+
+    FPGA_CTRL_SetGpioIrqMasked(true);
+
+    irqDev.source->Close(&irqDev);
+
+    irqDev.uioFd     = -1;
+    irqDev.btnBase   = NULL;
+    irqDev.swBase    = NULL;
+    irqDev.gier      = NULL;
+    irqDev.ier       = NULL;
+    irqDev.isr       = NULL;
+    irqDev.available = false;
+
+    if (OS_ObjectIdDefined(irqDev.wakeSem))
+    {
+        OS_BinSemDelete(irqDev.wakeSem);
+        irqDev.wakeSem = OS_OBJECT_ID_UNDEFINED;
+    }
+}
+
+// Enabling and disabling only flips irqEnabled and IER, the child task and mappings stay alive
 int32 FPGA_CTRL_IntCtrl(FPGA_CTRL_IntCtrlCmd_t const *SBBufPtr)
 {
-    int32      err;
     bool const doEnable = SBBufPtr->enable;
 
+    if (!irqDev.available || !globalState.irqTaskRunning)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Interrupt task isn't running, can't change interrupt state");
+        return CFE_STATUS_INCORRECT_STATE;
+    }
+
     if (doEnable)
     {
-        if (globalState.childTaskRunning)
+        if (globalState.irqEnabled)
         {
             CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
                               "FPGA_CTRL: Interrupts already enabled");
             return CFE_ES_ERR_CHILD_TASK_CREATE;
         }
 
-        CFE_ES_TaskId_t childTaskId;
-        if ((err = CFE_ES_CreateChildTask(&childTaskId, "FPGA_CTRL child", FPGA_CTRL_WaitForButton,
-                                          CFE_ES_TASK_STACK_ALLOCATE, CFE_PLATFORM_ES_DEFAULT_STACK_SIZE,
-                                          CFE_PLATFORM_ES_PERF_CHILD_PRIORITY, 0)) < CFE_SUCCESS)
-        {
-            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                              "FPGA_CTRL: Failed to create child task: 0x%x", err);
-            globalState.childTaskId = CFE_ES_TASKID_UNDEFINED;
-            return err;
-        }
-
-        globalState.childTaskId         = childTaskId;
-        globalState.childTaskShouldExit = false;
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
-                          "FPGA_CTRL: Spawned child task, child task ID: 0x%x", childTaskId);
+        globalState.irqEnabled = true;
+        FPGA_CTRL_SetGpioIrqMasked(false);
+        OS_BinSemGive(irqDev.wakeSem);
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "FPGA_CTRL: Interrupts enabled");
     }
     else
     {
-        if (!globalState.childTaskRunning)
+        if (!globalState.irqEnabled)
         {
             CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
                               "FPGA_CTRL_IntCtrl: Interrupts already disabled");
             return CFE_ES_ERR_CHILD_TASK_DELETE;
         }
 
-        // Tell the child to exit next time it wakes
-        globalState.childTaskShouldExit = true;
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
-                          "FPGA_CTRL: Marked child task %d to exit", globalState.childTaskId);
+        // The child pauses itself the next time it wakes
+        globalState.irqEnabled = false;
+        FPGA_CTRL_SetGpioIrqMasked(true);
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "FPGA_CTRL: Interrupts disabled");
     }
 
     return CFE_SUCCESS;
 }
 
-// Enable interrupts and infinitely loop waiting for interrupts.
+// Loops for the app's lifetime, pausing on the wake semaphore while interrupts are disabled
 static void FPGA_CTRL_WaitForButton(void)
 {
     int32 err;
-    globalState.childTaskRunning = true;
-    // #define FPGA_INTERRUPTS_TEST
-#ifndef FPGA_INTERRUPTS_TEST
-
-    // Addresses and sizes
-    static cpuaddr const AXI_BTN_BASE = 0x41200000; // Base address of the AXI GPIO for the buttons
-    static cpuaddr const AXI_SW_BASE  = 0x41210000; // Base address of the AXI GPIO for the switches
-    static cpusize const MAP_RANGE    = 0x10000;
-
-    static cpusize const GIER_OFFSET = 0x11c; // Global interrupt enable register
-    static cpusize const IER_OFFSET  = 0x128; // Interrupt enable register
-    static cpusize const ISR_OFFSET  = 0x120; // Interrupt status register
-
-    // Masks
-    static uint32 const GIER_ENABLE_MASK    = 0x80000000; // Enable interrupts
-    static uint32 const IER_CH1_ENABLE_MASK = 0x1;        // Enable interrupts on channel 1
-    // static uint32 const ISR_CH1_MASK        = 0x1;        // Mask for channel 1
-
-    void *const btnBase = NULL; // Base address of the AXI GPIO for the buttons
-    void *const swBase  = NULL; // Base address of the AXI GPIO for the switches
-    // TODO - Platform specific function, move to library?
-    OS_printf("FPGA_CTRL: opening uio0...\n");
-    int uioFd = open("/dev/uio0", O_RDWR | O_SYNC);
-    if (uioFd < 0)
-    {
-        // Error, cleanup and exit
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                          "Failed to open UIO device, uioFD = %d, exiting child...", uioFd);
-        FPGA_CTRL_ExitChildTask();
-    }
 
-    OS_printf("FPGA_CTRL: mapping btnBase...\n");
-    if ((err = mmio_lib_NewMapping((void **)&btnBase, AXI_BTN_BASE, MAP_RANGE)) < CFE_SUCCESS)
-    {
-        // Error, cleanup and exit
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                          "Failed to map button GPIO, err = %d, exiting child...", err);
-        if (close(uioFd) < 0)
-            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                              "Failed to close UIO device, uioFD = %d, exiting child...", uioFd);
-        FPGA_CTRL_ExitChildTask();
-    }
-
-    OS_printf("FPGA_CTRL: mapping swBase...\n");
-    if ((err = mmio_lib_NewMapping((void **)&swBase, AXI_SW_BASE, MAP_RANGE)) < CFE_SUCCESS)
-    {
-        // Error, cleanup and exit
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                          "Failed to map switch GPIO, err = %d, exiting child...", err);
-        if (close(uioFd) < 0)
-            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                              "Failed to close UIO device, uioFD = %d, exiting child...", uioFd);
-        if (mmio_lib_DeleteMapping((void *)btnBase, MAP_RANGE) < CFE_SUCCESS)
-            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                              "Failed to unmap button GPIO, exiting child...");
-        FPGA_CTRL_ExitChildTask();
-    }
+    FPGA_CTRL_ApplyChildSchedProfile(globalState.SchedProfile.IrqTaskCpuMask);
 
-    uint32 volatile *const gier =
-        (uint32 volatile *const)((cpuaddr)btnBase + (cpusize)GIER_OFFSET); // Global interrupt enable register
-    uint32 volatile *const ier =
-        (uint32 volatile *const)((cpuaddr)btnBase + (cpusize)IER_OFFSET); // Interrupt enable register
-    uint32 volatile *const isr =
-        (uint32 volatile *const)((cpuaddr)btnBase + (cpusize)ISR_OFFSET); // Interrupt status register
+    void volatile *const     btnBase           = irqDev.btnBase;
+    void volatile *const     swBase            = irqDev.swBase;
+    bool                     lastButtonPressed = false;
+    FPGA_CTRL_IrqConfig_t    config            = {.pollEnterRate = 0};
+    FPGA_CTRL_IrqModeState_t modeState         = {.windowEvents = 0};
 
-    OS_printf("FPGA_CTRL: enabling interrupts by setting registers...\n");
-    // FIXME - the following line segfaults with compiled with -O
-    *gier |= GIER_ENABLE_MASK;   // Enable global interrupts
-    *ier |= IER_CH1_ENABLE_MASK; // Enable interrupts on channel 1
-
-    if (FPGA_CTRL_ResetInterrupts(uioFd, isr) < CFE_SUCCESS)
-        FPGA_CTRL_FullCleanupChildTaskAndExit(uioFd, btnBase, MAP_RANGE, swBase, MAP_RANGE);
-
-    // Only send message on button down to avoid duplicate messages since button up generates an interrupt as well
-    bool lastButtonPressed = !!(*(uint8 volatile *)btnBase); // Read the button position
-#endif
+    CFE_ES_PerfLogEntry(FPGA_CTRL_IRQ_TASK_PERF_ID);
 
     // Wait on interrupt loop
     do
     {
-        OS_printf("FPGA_CTRL: Waiting for interrupt...\n");
-#ifdef FPGA_INTERRUPTS_TEST
-        OS_TaskDelay(2000); // Pretend to trigger an interrupt every 2 seconds
+        if (!globalState.irqEnabled)
+        {
+            FPGA_CTRL_StatsBegin(&globalState.IrqStats.lock);
+            globalState.IrqStats.mode = FPGA_CTRL_IRQ_MODE_INTERRUPT;
+            FPGA_CTRL_StatsEnd(&globalState.IrqStats.lock);
+            FPGA_CTRL_TRACE(INFO, IRQ, "Interrupts disabled, pausing child");
+            CFE_ES_PerfLogExit(FPGA_CTRL_IRQ_TASK_PERF_ID);
+            while (!globalState.irqEnabled)
+                OS_BinSemTake(irqDev.wakeSem);
+            CFE_ES_PerfLogEntry(FPGA_CTRL_IRQ_TASK_PERF_ID);
+
+            if (FPGA_CTRL_ResetInterrupts() < CFE_SUCCESS)
+                break;
+
+            // Only send message on button down to avoid duplicate messages since button up generates an interrupt as
+            // well
+            lastButtonPressed = !!(*(uint8 volatile *)btnBase); // Read the button position
+
+            // Pick up any table changes made while paused
+            FPGA_CTRL_GetIrqConfig(&config);
+
+            modeState.windowEvents = 0;
+            OS_GetLocalTime(&modeState.modeStart);
+            modeState.windowStart  = modeState.modeStart;
+            modeState.lastActivity = modeState.modeStart;
+            continue;
+        }
 
-        // Dummy variables for testing on a normal computer
-        uint8 const  switchPos         = 0xab;       // Dummy switch position
-        uint32 const buf               = 0xffffffff; // Dummy buffer of all 1s
-        bool const   lastButtonPressed = false;      // Pretend the button wasn't pressed
-        bool const   buttonPressed     = true;       // Pretend the button is pressed
-#else
+        OS_time_t now;
+        OS_GetLocalTime(&now);
+        FPGA_CTRL_AccountIrqModeTime(&modeState, now);
+
+        if (globalState.IrqStats.mode == FPGA_CTRL_IRQ_MODE_POLL)
+        {
+            // Poll mode: IER is masked, so the re-armed UIO interrupt never fires. Read the GPIO directly.
+            CFE_ES_PerfLogEntry(FPGA_CTRL_IRQ_POLL_PERF_ID);
+            bool const active = FPGA_CTRL_BusyPollPass(btnBase, swBase, &lastButtonPressed, config.pollBudget);
+            CFE_ES_PerfLogExit(FPGA_CTRL_IRQ_POLL_PERF_ID);
+
+            if (active)
+            {
+                modeState.lastActivity = now;
+            }
+            else if (FPGA_CTRL_MsSince(modeState.lastActivity, now) >= config.pollIdleExitMs)
+            {
+                // Activity dropped off, go back to interrupts. Clear anything latched while masked first.
+                if (FPGA_CTRL_ResetInterrupts() < CFE_SUCCESS)
+                {
+                    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                                      "FPGA_CTRL: Error resetting interrupts");
+                    break;
+                }
+                FPGA_CTRL_SetGpioIrqMasked(false);
+
+                FPGA_CTRL_StatsBegin(&globalState.IrqStats.lock);
+                globalState.IrqStats.mode = FPGA_CTRL_IRQ_MODE_INTERRUPT;
+                ++globalState.IrqStats.modeTransitions;
+                FPGA_CTRL_StatsEnd(&globalState.IrqStats.lock);
+                modeState.windowStart  = now;
+                modeState.windowEvents = 0;
+                CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                                  "FPGA_CTRL: GPIO idle for %u ms, back to interrupt mode",
+                                  (unsigned int)config.pollIdleExitMs);
+                continue;
+            }
+
+            // Give the rest of the system a chance to run between bounded passes
+            CFE_ES_PerfLogExit(FPGA_CTRL_IRQ_TASK_PERF_ID);
+            OS_TaskDelay(1);
+            CFE_ES_PerfLogEntry(FPGA_CTRL_IRQ_TASK_PERF_ID);
+            continue;
+        }
+
+        FPGA_CTRL_TRACE(DEBUG, IRQ, "Waiting for interrupt");
 
         // Actual interrupt checking code
         struct pollfd pollFd = {
-            .fd     = uioFd,
+            .fd     = irqDev.uioFd,
             .events = POLLIN,
         };
         // Block on poll() until interrupt or timeout of 5 seconds
-        // Has to timeout to check whether the child task should exit
-        if ((err = poll(&pollFd, 1, 5000)) < 0)
+        // Has to timeout to notice interrupts being disabled and pause
+        CFE_ES_PerfLogExit(FPGA_CTRL_IRQ_TASK_PERF_ID);
+        err = poll(&pollFd, 1, 5000);
+        CFE_ES_PerfLogEntry(FPGA_CTRL_IRQ_TASK_PERF_ID);
+        FPGA_CTRL_PROBE2(irq__wake, err, globalState.IrqStats.eventCount);
+        if (err < 0)
         {
             CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
                               "FPGA_CTRL: Error polling for interrupt: %d", err);
             break;
         }
 
-        if (FPGA_CTRL_ResetInterrupts(uioFd, isr) < CFE_SUCCESS)
+        // poll() returned, now check whether it was a timeout, an interrupt, or some error
+
+        uint32 buf = 0;
+        if (err > 0)
         {
-            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                              "FPGA_CTRL: Error resetting interrupts");
-            break;
+            if (!(pollFd.revents & POLLIN))
+            {
+                CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                                  "FPGA_CTRL: Error polling for interrupt: %d", pollFd.revents);
+                break;
+            }
+
+            // Consume the interrupt before re-arming so one that arrives in between isn't lost
+            // read() shouldn't block since poll() returned
+            if ((err = irqDev.source->Read(&irqDev, &buf)) < CFE_SUCCESS)
+            {
+                CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                                  "FPGA_CTRL: Error reading interrupt: %d", err);
+                break;
+            }
+            err = 1;
         }
 
-#endif
-        if (globalState.childTaskShouldExit)
+        if (FPGA_CTRL_ResetInterrupts() < CFE_SUCCESS)
         {
-            OS_printf("FPGA_CTRL: Child should quit, breaking loop\n");
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                              "FPGA_CTRL: Error resetting interrupts");
             break;
         }
 
-        // poll() returned, now check whether it was a timeout, an interrupt, or some error
-
-#ifndef FPGA_INTERRUPTS_TEST
-        if (err == 0)
+        if (err == 0 || !globalState.irqEnabled)
         {
-            // Do nothing and continue to loop if timeout
-            OS_printf("FPGA_CTRL: Timed out waiting for interrupt\n");
+            // Do nothing and continue to loop if timeout, or pause if interrupts were disabled meanwhile
+            FPGA_CTRL_TRACE(DEBUG, IRQ, "Timed out waiting for interrupt");
             continue;
         }
-        if (!(pollFd.revents & POLLIN))
-        {
-            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                              "FPGA_CTRL: Error polling for interrupt: %d", pollFd.revents);
-            break;
-        }
 
         // If execution reaches here, then an interrupt occurred
         // Now handle the interrupt
+        CFE_ES_PerfLogEntry(FPGA_CTRL_IRQ_SERVICE_PERF_ID);
 
-        uint32 buf;
-        // read() shouldn't block since poll() returned
-        if (read(uioFd, &buf, sizeof(buf)) < 0)
-        {
-            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                              "FPGA_CTRL: Error reading interrupt: %d", err);
-            break;
-        }
-
-        uint8 const switchPos = *(uint8 const *)swBase; // Read the switch position
+        uint8 const switchPos = *(uint8 const volatile *)swBase; // Read the switch position
 
         bool const buttonPressed = !!(*(uint8 volatile *)btnBase); // Read the button position
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
-                          "FPGA_CTRL: Button interrupt! Switch position: 0x%02x, last button position %d, current "
-                          "button position %d, read 0x%x from the uioFd",
-                          switchPos, lastButtonPressed, buttonPressed, buf);
-#endif
+        FPGA_CTRL_TRACE(DEBUG, IRQ, "Button interrupt, switch position 0x%02x, button %d -> %d, read 0x%x", switchPos,
+                        lastButtonPressed, buttonPressed, (unsigned int)buf);
+
+        FPGA_CTRL_StatsBegin(&globalState.IrqStats.lock);
+        ++globalState.IrqStats.eventCount;
+        FPGA_CTRL_StatsEnd(&globalState.IrqStats.lock);
+        if (irqDev.source->EventHandled != NULL)
+            irqDev.source->EventHandled();
 
         // Send telemetry packet on rising edge (button pressed down)
         if (!lastButtonPressed && buttonPressed)
         {
-            OS_printf("FPGA_CTRL: Sending telemetry packet...\n");
-            FPGA_CTRL_IntTlm_t telemetryPacket;
-            if ((err = CFE_MSG_Init(&telemetryPacket.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_INT_TLM_MID),
-                                    sizeof(telemetryPacket)) < CFE_SUCCESS))
-            {
-                CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                                  "FPGA_CTRL: Error initializing telemetry packet: %d", err);
-            }
-            telemetryPacket.switchPos = switchPos;
-            CFE_SB_TimeStampMsg((CFE_MSG_Message_t *)&telemetryPacket);
-            if ((err = CFE_SB_TransmitMsg((CFE_MSG_Message_t *)&telemetryPacket, true)) < CFE_SUCCESS)
-                CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                                  "FPGA_CTRL: Failed to send telemetry packet, error: 0x%08x", err);
+            FPGA_CTRL_SendButtonTlm(switchPos);
         }
 
-#ifndef FPGA_INTERRUPTS_TEST
         lastButtonPressed = buttonPressed;
-#endif
+
+        // Measure the interrupt rate and switch to polling once it crosses the threshold
+        OS_GetLocalTime(&now); // poll() may have blocked since the top of the loop
+        ++modeState.windowEvents;
+        uint32 const windowMs = FPGA_CTRL_MsSince(modeState.windowStart, now);
+        if (config.pollEnterRate != 0 &&
+            (uint64)modeState.windowEvents * 1000 > (uint64)config.pollEnterRate * (windowMs > 0 ? windowMs : 1) &&
+            modeState.windowEvents > 1)
+        {
+            // Mask the GPIO interrupt. The UIO interrupt was already read and re-armed above, with IER masked
+            // nothing reaches it until interrupt mode unmasks IER again.
+            FPGA_CTRL_SetGpioIrqMasked(true);
+
+            FPGA_CTRL_StatsBegin(&globalState.IrqStats.lock);
+            globalState.IrqStats.mode = FPGA_CTRL_IRQ_MODE_POLL;
+            ++globalState.IrqStats.modeTransitions;
+            FPGA_CTRL_StatsEnd(&globalState.IrqStats.lock);
+            modeState.lastActivity = now;
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                              "FPGA_CTRL: %u interrupts in %u ms, switching to poll mode",
+                              (unsigned int)modeState.windowEvents, (unsigned int)windowMs);
+        }
+        else if (windowMs >= FPGA_CTRL_IRQ_RATE_WINDOW_MS)
+        {
+            modeState.windowStart  = now;
+            modeState.windowEvents = 0;
+        }
+
+        CFE_ES_PerfLogExit(FPGA_CTRL_IRQ_SERVICE_PERF_ID);
     } while (true);
 
-#ifndef FPGA_INTERRUPTS_TEST
-    FPGA_CTRL_FullCleanupChildTaskAndExit(uioFd, btnBase, MAP_RANGE, swBase, MAP_RANGE);
-#endif
+    FPGA_CTRL_ExitChildTask();
 }
 
 static void FPGA_CTRL_ExitChildTask(void)
 {
-    globalState.childTaskRunning = false;
-    // globalState.childTaskId      = CFE_ES_TASKID_UNDEFINED;
+    // The device stays mapped for the app, just make sure nothing fires with nobody servicing it
+    globalState.irqEnabled = false;
+    FPGA_CTRL_SetGpioIrqMasked(true);
+    globalState.irqTaskRunning = false;
+    CFE_ES_PerfLogExit(FPGA_CTRL_IRQ_TASK_PERF_ID);
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Interrupt child task exiting");
     CFE_ES_ExitChildTask();                // This shouldn't return
     CFE_PSP_Panic(CFE_ES_NOT_IMPLEMENTED); // Panic if it does return
 }
 
-static void FPGA_CTRL_FullCleanupChildTaskAndExit(int uioFd, void volatile *btnBase, cpusize btnBaseMapRange,
-                                                  void volatile *swBase, cpusize swBaseMapRange)
+// Masks or unmasks GPIO channel 1 in IER. Both the main task (enable/disable) and the child (poll mode) call this.
+// Unmasking re-checks irqEnabled afterwards, so a disable racing with an unmask always leaves IER masked.
+static void FPGA_CTRL_SetGpioIrqMasked(bool const masked)
 {
-    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
-                      "FPGA_CTRL: Fully cleaning up and exiting child..");
-    if (close(uioFd) < 0)
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                          "FPGA_CTRL: Failed to close UIO device, uioFD = %d", uioFd);
-    if (mmio_lib_DeleteMapping((void *)btnBase, btnBaseMapRange) < CFE_SUCCESS)
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Failed to unmap button GPIO");
-    if (mmio_lib_DeleteMapping((void *)swBase, swBaseMapRange) < CFE_SUCCESS)
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Failed to unmap switch GPIO");
-    FPGA_CTRL_ExitChildTask(); // This shouldn't return
+    if (irqDev.ier == NULL)
+        return;
+
+    if (masked)
+    {
+        *irqDev.ier = 0;
+        return;
+    }
+
+    *irqDev.ier = IER_CH1_ENABLE_MASK;
+    if (!globalState.irqEnabled)
+        *irqDev.ier = 0;
 }
 
-static int32 FPGA_CTRL_ResetInterrupts(int const uioFd, uint32 volatile *const isr)
+// Copies the adaptive mode parameters out of the table, falling back to interrupt-only if it isn't available
+static void FPGA_CTRL_GetIrqConfig(FPGA_CTRL_IrqConfig_t *const config)
 {
-    OS_printf("FPGA_CTRL: Resetting interrupts...\n");
-    static uint32 const ISR_CH1_MASK = 0x1; // Mask for channel 1
+    FPGA_CTRL_Table_t *tblPtr;
+
+    config->pollEnterRate  = 0;
+    config->pollBudget     = 0;
+    config->pollIdleExitMs = 0;
 
-    if (*isr & ISR_CH1_MASK)
+    if (CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0]) < CFE_SUCCESS)
     {
-        OS_printf("FPGA_CTRL: Clearing interrupt on channel 1...\n");
-        *isr |= ISR_CH1_MASK;
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Couldn't read table, adaptive polling disabled");
+        return;
     }
+
+    config->pollEnterRate  = tblPtr->IrqPollEnterRate;
+    config->pollBudget     = tblPtr->IrqPollBudget;
+    config->pollIdleExitMs = tblPtr->IrqPollIdleExitMs;
+
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+}
+
+static uint32 FPGA_CTRL_MsSince(OS_time_t const since, OS_time_t const now)
+{
+    return (uint32)OS_TimeGetTotalMilliseconds(OS_TimeSubtract(now, since));
+}
+
+// Adds the time since the last call to the counter of the mode the child is currently in
+static void FPGA_CTRL_AccountIrqModeTime(FPGA_CTRL_IrqModeState_t *const state, OS_time_t const now)
+{
+    uint32 const elapsedMs = FPGA_CTRL_MsSince(state->modeStart, now);
+    if (elapsedMs == 0)
+        return; // Keep the remainder until at least a whole ms has passed
+
+    FPGA_CTRL_StatsBegin(&globalState.IrqStats.lock);
+    if (globalState.IrqStats.mode == FPGA_CTRL_IRQ_MODE_POLL)
+        globalState.IrqStats.pollModeMs += elapsedMs;
     else
+        globalState.IrqStats.interruptModeMs += elapsedMs;
+    FPGA_CTRL_StatsEnd(&globalState.IrqStats.lock);
+
+    state->modeStart = OS_TimeAdd(state->modeStart, OS_TimeFromTotalMilliseconds(elapsedMs));
+}
+
+static void FPGA_CTRL_SendButtonTlm(uint8 const switchPos)
+{
+    int32 err;
+
+    FPGA_CTRL_TRACE(DEBUG, IRQ, "Sending button telemetry, switch position 0x%02x", switchPos);
+    FPGA_CTRL_IntTlm_t telemetryPacket;
+    if ((err = CFE_MSG_Init(&telemetryPacket.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_INT_TLM_MID),
+                            sizeof(telemetryPacket))) < CFE_SUCCESS)
     {
-        OS_printf("FPGA_CTRL: No interrupt pending on channel 1.\n");
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Error initializing telemetry packet: %d", err);
     }
+    telemetryPacket.switchPos = switchPos;
+    CFE_SB_TimeStampMsg((CFE_MSG_Message_t *)&telemetryPacket);
+    if ((err = CFE_SB_TransmitMsg((CFE_MSG_Message_t *)&telemetryPacket, true)) < CFE_SUCCESS)
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to send telemetry packet, error: 0x%08x", err);
+    FPGA_CTRL_PROBE1(irq__tx, switchPos);
+}
+
+// Reads the button GPIO data register up to budget times, handling every change the same way an interrupt would.
+// Returns whether anything changed.
+static bool FPGA_CTRL_BusyPollPass(void volatile *const btnBase, void volatile *const swBase,
+                                   bool *const lastButtonPressed, uint16 const budget)
+{
+    bool sawActivity = false;
 
-    OS_printf("FPGA_CTRL: Clearing UIO interrupt...\n");
-    uint32 const one = 1;
-    if (write(uioFd, &one, sizeof(one)) != sizeof(one))
+    for (uint16 i = 0; i < budget; ++i)
     {
-        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                          "Failed to clear UIO interrupt, exiting child...");
-        return CFE_EVS_FILE_WRITE_ERROR;
+        bool const buttonPressed = !!(*(uint8 volatile *)btnBase);
+        if (buttonPressed == *lastButtonPressed)
+            continue;
+
+        sawActivity = true;
+        FPGA_CTRL_StatsBegin(&globalState.IrqStats.lock);
+        ++globalState.IrqStats.eventCount;
+        FPGA_CTRL_StatsEnd(&globalState.IrqStats.lock);
+        if (irqDev.source->EventHandled != NULL)
+            irqDev.source->EventHandled();
+        if (buttonPressed)
+            FPGA_CTRL_SendButtonTlm(*(uint8 volatile *)swBase);
+        *lastButtonPressed = buttonPressed;
     }
 
-    return CFE_SUCCESS;
+    return sawActivity;
+}
+
+static int32 FPGA_CTRL_ResetInterrupts(void)
+{
+    FPGA_CTRL_TRACE(DEBUG, IRQ, "Resetting interrupts");
+    static uint32 const ISR_CH1_MASK = 0x1; // Mask for channel 1
+
+    uint32 const isr = *irqDev.isr;
+    FPGA_CTRL_PROBE1(irq__clear, isr);
+    if (isr & ISR_CH1_MASK)
+    {
+        FPGA_CTRL_TRACE(DEBUG, IRQ, "Clearing interrupt on channel 1");
+        *irqDev.isr |= ISR_CH1_MASK;
+    }
+    else
+    {
+        FPGA_CTRL_TRACE(DEBUG, IRQ, "No interrupt pending on channel 1");
+    }
+
+    return irqDev.source->Rearm(&irqDev);
 }
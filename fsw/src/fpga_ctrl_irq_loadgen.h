@@ -0,0 +1,205 @@
+// Synthetic interrupt load generator for soak and throughput testing. Drives the fake interrupt source at a
+// configurable average rate and burst size and reports sustained throughput, drops and latency of the interrupt
+// pipeline. Only available in builds using the fake source (FPGA_INTERRUPTS_TEST).
+
+#include <string.h>
+#include <time.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_LOADGEN_MAX_RATE_HZ 100000
+#define FPGA_CTRL_LOADGEN_REPORT_MS   1000 // Telemetry period while running
+
+typedef struct
+{
+    uint32      rateHz;
+    uint32      burstLen;
+    uint32      durationMs;
+    atomic_bool running;
+    atomic_bool shouldExit;
+} FPGA_CTRL_LoadGen_t;
+
+static FPGA_CTRL_LoadGen_t loadGen;
+
+// Exported function
+int32 FPGA_CTRL_LoadGen(FPGA_CTRL_LoadGenCmd_t const *Msg);
+
+static void FPGA_CTRL_LoadGenTask(void);
+static void FPGA_CTRL_LoadGenReport(uint32 elapsedMs, uint32 intervalMs, uint32 intervalHandled);
+
+int32 FPGA_CTRL_LoadGen(FPGA_CTRL_LoadGenCmd_t const *Msg)
+{
+    int32           err;
+    CFE_ES_TaskId_t taskId;
+
+    if (Msg->durationMs == 0)
+    {
+        if (!loadGen.running)
+        {
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                              "FPGA_CTRL: Load generator isn't running");
+            return CFE_STATUS_INCORRECT_STATE;
+        }
+
+        loadGen.shouldExit = true;
+        return CFE_SUCCESS;
+    }
+
+    if (irqDev.source != &FPGA_CTRL_FakeIrqSource || !irqDev.available)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Load generator needs the fake interrupt source, current source is %s",
+                          irqDev.source->name);
+        return CFE_STATUS_INCORRECT_STATE;
+    }
+
+    if (loadGen.running)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Load generator already running, stop it before starting another run");
+        return CFE_STATUS_REQUEST_ALREADY_PENDING;
+    }
+
+    if (Msg->rateHz == 0 || Msg->rateHz > FPGA_CTRL_LOADGEN_MAX_RATE_HZ || Msg->burstLen == 0 ||
+        Msg->burstLen > Msg->rateHz)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Invalid load generator parameters, rate = %u Hz, burst = %u",
+                          (unsigned int)Msg->rateHz, (unsigned int)Msg->burstLen);
+        return CFE_ES_BAD_ARGUMENT;
+    }
+
+    loadGen.rateHz     = Msg->rateHz;
+    loadGen.burstLen   = Msg->burstLen;
+    loadGen.durationMs = Msg->durationMs;
+    loadGen.shouldExit = false;
+
+    // Start every run from clean statistics
+    fakeIrqModel.raised         = 0;
+    fakeIrqModel.delivered      = 0;
+    fakeIrqModel.handled        = 0;
+    fakeIrqModel.covered        = 0;
+    fakeIrqModel.coalesced      = 0;
+    fakeIrqModel.latencySamples = 0;
+    fakeIrqModel.latencySumUs   = 0;
+    fakeIrqModel.latencyMaxUs   = 0;
+    for (int i = 0; i < FPGA_CTRL_IRQ_LATENCY_BUCKETS; ++i)
+        fakeIrqModel.latencyHist[i] = 0;
+
+    loadGen.running = true;
+    if ((err = CFE_ES_CreateChildTask(&taskId, "FPGA_CTRL irq gen", FPGA_CTRL_LoadGenTask, CFE_ES_TASK_STACK_ALLOCATE,
+                                      CFE_PLATFORM_ES_DEFAULT_STACK_SIZE, CFE_PLATFORM_ES_PERF_CHILD_PRIORITY, 0)) <
+        CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to create load generator task: 0x%x", err);
+        loadGen.running = false;
+        return err;
+    }
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "FPGA_CTRL: Load generator started, %u events/s in bursts of %u for %u ms",
+                      (unsigned int)loadGen.rateHz, (unsigned int)loadGen.burstLen, (unsigned int)loadGen.durationMs);
+    return CFE_SUCCESS;
+}
+
+// Raises bursts of events so the running total tracks rate * elapsed, sleeping on absolute deadlines in between
+static void FPGA_CTRL_LoadGenTask(void)
+{
+    FPGA_CTRL_ApplyChildSchedProfile(0);
+
+    int64 const startNs       = FPGA_CTRL_MonotonicNs();
+    int64 const burstPeriodNs = (int64)loadGen.burstLen * 1000000000LL / loadGen.rateHz;
+    int64       nextReportNs  = startNs + FPGA_CTRL_LOADGEN_REPORT_MS * 1000000LL;
+    int64       lastReportNs  = startNs;
+    uint32      lastHandled   = 0;
+    uint64      raised        = 0;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    while (!loadGen.shouldExit)
+    {
+        int64 const nowNs     = FPGA_CTRL_MonotonicNs();
+        int64 const elapsedNs = nowNs - startNs;
+        if (elapsedNs >= (int64)loadGen.durationMs * 1000000LL)
+            break;
+
+        // Catch up in whole bursts if we overslept, so the average rate holds
+        uint64 const due = (uint64)(elapsedNs / burstPeriodNs + 1) * loadGen.burstLen;
+        while (raised < due)
+        {
+            FPGA_CTRL_FakeRaise();
+            ++raised;
+        }
+
+        if (nowNs >= nextReportNs)
+        {
+            uint32 const handled = fakeIrqModel.handled;
+            FPGA_CTRL_LoadGenReport((uint32)(elapsedNs / 1000000), (uint32)((nowNs - lastReportNs) / 1000000),
+                                    handled - lastHandled);
+            lastHandled  = handled;
+            lastReportNs = nowNs;
+            nextReportNs += FPGA_CTRL_LOADGEN_REPORT_MS * 1000000LL;
+        }
+
+        int64 const nextNs = startNs + (int64)(elapsedNs / burstPeriodNs + 1) * burstPeriodNs;
+        deadline.tv_sec    = nextNs / 1000000000LL;
+        deadline.tv_nsec   = nextNs % 1000000000LL;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+    }
+
+    // Give the interrupt task a moment to drain before taking the final numbers
+    OS_TaskDelay(100);
+
+    int64 const  endNs     = FPGA_CTRL_MonotonicNs();
+    uint32 const elapsedMs = (uint32)((endNs - startNs) / 1000000);
+    uint32 const handled   = fakeIrqModel.handled;
+    FPGA_CTRL_LoadGenReport(elapsedMs, (uint32)((endNs - lastReportNs) / 1000000), handled - lastHandled);
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "FPGA_CTRL: Load generator done, raised %u, handled %u (%u/s), max latency %u us",
+                      (unsigned int)fakeIrqModel.raised, (unsigned int)handled,
+                      (unsigned int)(elapsedMs > 0 ? (uint64)handled * 1000 / elapsedMs : 0),
+                      (unsigned int)fakeIrqModel.latencyMaxUs);
+
+    loadGen.running = false;
+    CFE_ES_ExitChildTask();
+}
+
+static void FPGA_CTRL_LoadGenReport(uint32 const elapsedMs, uint32 const intervalMs, uint32 const intervalHandled)
+{
+    static FPGA_CTRL_LoadGenTlm_t packet;
+    static FPGA_CTRL_IrqStats_t   irqStats; // Kept between reports, see FPGA_CTRL_StatsRead
+
+    CFE_MSG_Init(&packet.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_LOADGEN_TLM_MID), sizeof(packet));
+    FPGA_CTRL_StatsRead(&irqStats, &globalState.IrqStats, sizeof(irqStats));
+
+    // Read before raised, which it never gets ahead of
+    uint32 const covered = fakeIrqModel.covered;
+
+    FPGA_CTRL_LoadGenTlm_Payload_t *const payload = &packet.Payload;
+    payload->rateHz                               = loadGen.rateHz;
+    payload->burstLen                             = loadGen.burstLen;
+    payload->elapsedMs                            = elapsedMs;
+    payload->raised                               = fakeIrqModel.raised;
+    payload->delivered                            = fakeIrqModel.delivered;
+    payload->handled                              = fakeIrqModel.handled;
+    payload->coalesced                            = fakeIrqModel.coalesced;
+    payload->dropped                              = payload->raised - covered;
+    payload->handledPerSec  = intervalMs > 0 ? (uint32)((uint64)intervalHandled * 1000 / intervalMs) : 0;
+    payload->latencySamples = fakeIrqModel.latencySamples;
+    payload->latencyAvgUs =
+        payload->latencySamples > 0 ? (uint32)(fakeIrqModel.latencySumUs / payload->latencySamples) : 0;
+    payload->latencyMaxUs = fakeIrqModel.latencyMaxUs;
+    for (int i = 0; i < FPGA_CTRL_IRQ_LATENCY_BUCKETS; ++i)
+        payload->latencyHist[i] = fakeIrqModel.latencyHist[i];
+    payload->irqMode = irqStats.mode;
+
+    CFE_SB_TimeStampMsg(&packet.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&packet.TlmHeader.Msg, true);
+}
@@ -0,0 +1,294 @@
+// Pluggable interrupt sources for the interrupt child task.
+//
+// The UIO source is the real hardware: the UIO node and the two AXI GPIO windows the accelerator registry has for
+// the loaded design.
+// The fake source stands in for it on a plain Linux host: an eventfd plays the part of the UIO file descriptor and
+// an anonymous shared mapping models the GPIO registers, driven by the load generator in fpga_ctrl_irq_loadgen.h.
+
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#include "cfe.h"
+#include "mmio_lib.h"
+#include "fpga_ctrl.h"
+
+#define FPGA_CTRL_GPIO_MAP_RANGE 0x10000 // Size of each modelled GPIO block in the fake source
+
+// Register offsets and masks
+static cpusize const GIER_OFFSET         = 0x11c;      // Global interrupt enable register
+static cpusize const IER_OFFSET          = 0x128;      // Interrupt enable register
+static cpusize const ISR_OFFSET          = 0x120;      // Interrupt status register
+static uint32 const  GIER_ENABLE_MASK    = 0x80000000; // Enable interrupts
+static uint32 const  IER_CH1_ENABLE_MASK = 0x1;        // Enable interrupts on channel 1
+
+struct FPGA_CTRL_IrqSource;
+
+// Interrupt device, opened and mapped once at app init and kept for the app's lifetime so that enabling and
+// disabling interrupts only has to touch IER
+typedef struct
+{
+    struct FPGA_CTRL_IrqSource const *source;
+    int                               uioFd;   // poll()able, readable when an interrupt is pending
+    void volatile                    *btnBase; // Base address of the AXI GPIO for the buttons
+    void volatile                    *swBase;  // Base address of the AXI GPIO for the switches
+    uint32 volatile                  *gier;    // Global interrupt enable register
+    uint32 volatile                  *ier;     // Interrupt enable register
+    uint32 volatile                  *isr;     // Interrupt status register
+    osal_id_t                         wakeSem; // Given on enable to resume the paused child
+    bool                              available;
+} FPGA_CTRL_IrqDevice_t;
+
+typedef struct FPGA_CTRL_IrqSource
+{
+    char const *name;
+    int32 (*Open)(FPGA_CTRL_IrqDevice_t *dev);  // Fills in the fd and register pointers
+    void (*Close)(FPGA_CTRL_IrqDevice_t *dev);  // Releases whatever Open acquired, safe on a half-open device
+    int32 (*Read)(FPGA_CTRL_IrqDevice_t *dev, uint32 *count); // Consumes the pending interrupt
+    int32 (*Rearm)(FPGA_CTRL_IrqDevice_t *dev); // Re-enables delivery after an interrupt was taken
+    void (*EventHandled)(void);                 // Called once per GPIO event the child handles, may be NULL
+} FPGA_CTRL_IrqSource_t;
+
+/*
+** Real hardware through the UIO node of the button GPIO
+*/
+
+static int32 FPGA_CTRL_UioOpen(FPGA_CTRL_IrqDevice_t *const dev)
+{
+    FPGA_CTRL_Accel_t const *const btn = FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_GPIO_BTN);
+    FPGA_CTRL_Accel_t const *const sw  = FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_GPIO_SW);
+    if (btn == NULL || sw == NULL || btn->desc.UioIndex == FPGA_CTRL_ACCEL_NO_UIO)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: The loaded design has no GPIO interrupt, interrupts unavailable");
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    char uioPath[16];
+    snprintf(uioPath, sizeof(uioPath), "/dev/uio%u", (unsigned int)btn->desc.UioIndex);
+
+    // TODO - Platform specific function, move to library?
+    FPGA_CTRL_TRACE(INFO, IRQ, "Opening %s", uioPath);
+    if ((dev->uioFd = open(uioPath, O_RDWR | O_SYNC)) < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to open UIO device, interrupts unavailable");
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    // The registry owns the mappings, they go away with it when the fabric is reprogrammed
+    dev->btnBase = btn->base;
+    dev->swBase  = sw->base;
+
+    return CFE_SUCCESS;
+}
+
+static void FPGA_CTRL_UioClose(FPGA_CTRL_IrqDevice_t *const dev)
+{
+    if (dev->uioFd >= 0 && close(dev->uioFd) < 0)
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to close UIO device, uioFD = %d", dev->uioFd);
+}
+
+static int32 FPGA_CTRL_UioRead(FPGA_CTRL_IrqDevice_t *const dev, uint32 *const count)
+{
+    // UIO returns the total interrupt count as a 32 bit integer
+    if (read(dev->uioFd, count, sizeof(*count)) != sizeof(*count))
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+
+    return CFE_SUCCESS;
+}
+
+static int32 FPGA_CTRL_UioRearm(FPGA_CTRL_IrqDevice_t *const dev)
+{
+    FPGA_CTRL_TRACE(DEBUG, IRQ, "Clearing UIO interrupt");
+    uint32 const one = 1;
+    if (write(dev->uioFd, &one, sizeof(one)) != sizeof(one))
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to clear UIO interrupt");
+        return CFE_EVS_FILE_WRITE_ERROR;
+    }
+
+    return CFE_SUCCESS;
+}
+
+static FPGA_CTRL_IrqSource_t const FPGA_CTRL_UioIrqSource = {
+    .name         = "uio",
+    .Open         = FPGA_CTRL_UioOpen,
+    .Close        = FPGA_CTRL_UioClose,
+    .Read         = FPGA_CTRL_UioRead,
+    .Rearm        = FPGA_CTRL_UioRearm,
+    .EventHandled = NULL,
+};
+
+/*
+** Fake UIO on an eventfd with a shared-memory GPIO model
+*/
+
+// Delivery state bits, one word so raising and re-arming can't both miss that the other just happened
+#define FPGA_CTRL_FAKE_ARMED   0x1u // Like UIO, delivery is disabled after each interrupt until re-armed
+#define FPGA_CTRL_FAKE_PENDING 0x2u // Raised while delivery was disabled (level interrupt still asserted)
+
+// State of the modelled GPIO block beyond the plain register memory
+typedef struct
+{
+    uint8      *regs;             // Button block followed by switch block, each FPGA_CTRL_GPIO_MAP_RANGE long
+    int         eventFd;          // Stands in for /dev/uio0
+    atomic_uint state;            // FPGA_CTRL_FAKE_*
+    atomic_llong firstPendingNs;  // CLOCK_MONOTONIC time of the oldest event not yet handled, 0 if none
+    atomic_uint raised;           // Events raised by the generator
+    atomic_uint delivered;        // Interrupts signalled on the eventfd
+    atomic_uint handled;          // Events the child reported handling
+    atomic_uint covered;          // Raised events the handlings so far accounted for
+    atomic_uint coalesced;        // Raised events handled along with an earlier one rather than on their own
+    atomic_uint latencySamples;   // Handlings with a raise time to measure from
+    atomic_ullong latencySumUs;
+    atomic_uint  latencyMaxUs;
+    atomic_uint  latencyHist[FPGA_CTRL_IRQ_LATENCY_BUCKETS];
+} FPGA_CTRL_FakeIrqModel_t;
+
+static FPGA_CTRL_FakeIrqModel_t fakeIrqModel = {.regs = NULL, .eventFd = -1};
+
+static int64 FPGA_CTRL_MonotonicNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Sets an FPGA_CTRL_FAKE_* bit, and once the interrupt is both armed and pending with the GPIO enabled clears both
+// and signals the eventfd. The generator raising and the child re-arming race, the CAS makes sure exactly one of
+// them sees the other's bit and delivers.
+static void FPGA_CTRL_FakeDeliver(uint32 const bit)
+{
+    uint32 volatile const *const gier    = (uint32 volatile *)(fakeIrqModel.regs + GIER_OFFSET);
+    uint32 volatile const *const ier     = (uint32 volatile *)(fakeIrqModel.regs + IER_OFFSET);
+    bool const                   enabled = (*gier & GIER_ENABLE_MASK) && (*ier & IER_CH1_ENABLE_MASK);
+    uint64 const                 one     = 1;
+    unsigned int                 state   = atomic_load(&fakeIrqModel.state);
+    unsigned int                 next;
+
+    do
+    {
+        next = state | bit;
+        if (enabled && next == (FPGA_CTRL_FAKE_ARMED | FPGA_CTRL_FAKE_PENDING))
+            next = 0;
+    } while (!atomic_compare_exchange_weak(&fakeIrqModel.state, &state, next));
+
+    if (next == 0 && write(fakeIrqModel.eventFd, &one, sizeof(one)) == sizeof(one))
+        ++fakeIrqModel.delivered;
+}
+
+// Called by the load generator: toggles the button, latches the ISR bit and raises the interrupt
+static void FPGA_CTRL_FakeRaise(void)
+{
+    uint8 volatile *const  btnData = (uint8 volatile *)fakeIrqModel.regs;
+    uint32 volatile *const isr     = (uint32 volatile *)(fakeIrqModel.regs + ISR_OFFSET);
+    long long              expected = 0;
+
+    atomic_compare_exchange_strong(&fakeIrqModel.firstPendingNs, &expected, FPGA_CTRL_MonotonicNs());
+    *btnData ^= 0x1;
+    *isr |= 0x1;
+    ++fakeIrqModel.raised;
+
+    FPGA_CTRL_FakeDeliver(FPGA_CTRL_FAKE_PENDING);
+}
+
+static int32 FPGA_CTRL_FakeOpen(FPGA_CTRL_IrqDevice_t *const dev)
+{
+    fakeIrqModel.regs = mmap(NULL, 2 * FPGA_CTRL_GPIO_MAP_RANGE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                             -1, 0);
+    if (fakeIrqModel.regs == MAP_FAILED)
+    {
+        fakeIrqModel.regs = NULL;
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to map fake GPIO registers");
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    if ((fakeIrqModel.eventFd = eventfd(0, EFD_NONBLOCK)) < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Failed to create fake UIO");
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    fakeIrqModel.state = FPGA_CTRL_FAKE_ARMED;
+
+    dev->uioFd   = fakeIrqModel.eventFd;
+    dev->btnBase = fakeIrqModel.regs;
+    dev->swBase  = fakeIrqModel.regs + FPGA_CTRL_GPIO_MAP_RANGE;
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "FPGA_CTRL: Using fake UIO interrupt source");
+    return CFE_SUCCESS;
+}
+
+static void FPGA_CTRL_FakeClose(FPGA_CTRL_IrqDevice_t *const dev)
+{
+    if (fakeIrqModel.eventFd >= 0)
+        close(fakeIrqModel.eventFd);
+    if (fakeIrqModel.regs != NULL)
+        munmap(fakeIrqModel.regs, 2 * FPGA_CTRL_GPIO_MAP_RANGE);
+
+    fakeIrqModel.eventFd = -1;
+    fakeIrqModel.regs    = NULL;
+}
+
+static int32 FPGA_CTRL_FakeRead(FPGA_CTRL_IrqDevice_t *const dev, uint32 *const count)
+{
+    uint64 eventCount;
+
+    // eventfd hands back an 8 byte counter and resets it, report it like UIO would
+    if (read(dev->uioFd, &eventCount, sizeof(eventCount)) != sizeof(eventCount))
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+
+    *count = (uint32)eventCount;
+    return CFE_SUCCESS;
+}
+
+static int32 FPGA_CTRL_FakeRearm(FPGA_CTRL_IrqDevice_t *const dev)
+{
+    // A level interrupt that stayed asserted while disabled fires again as soon as it's re-enabled
+    FPGA_CTRL_FakeDeliver(FPGA_CTRL_FAKE_ARMED);
+
+    return CFE_SUCCESS;
+}
+
+// Accounts for every event raised since the last handling, all but one of them coalesced into this one, and records
+// the latency from the oldest of them to now. A handling with nothing new, delivered again for an event already
+// accounted for, has no latency to record.
+static void FPGA_CTRL_FakeEventHandled(void)
+{
+    ++fakeIrqModel.handled;
+
+    int64 const  raisedNs = atomic_exchange(&fakeIrqModel.firstPendingNs, 0);
+    uint32 const raised   = fakeIrqModel.raised;
+    uint32 const events   = raised - atomic_exchange(&fakeIrqModel.covered, raised);
+    if (events > 1)
+        fakeIrqModel.coalesced += events - 1;
+    if (raisedNs == 0)
+        return;
+
+    uint32 const latencyUs = (uint32)((FPGA_CTRL_MonotonicNs() - raisedNs) / 1000);
+    ++fakeIrqModel.latencySamples;
+    fakeIrqModel.latencySumUs += latencyUs;
+    if (latencyUs > fakeIrqModel.latencyMaxUs)
+        fakeIrqModel.latencyMaxUs = latencyUs;
+
+    uint32 bucket = 0;
+    while (bucket < FPGA_CTRL_IRQ_LATENCY_BUCKETS - 1 && (latencyUs >> bucket) > 1)
+        ++bucket;
+    ++fakeIrqModel.latencyHist[bucket];
+}
+
+static FPGA_CTRL_IrqSource_t const FPGA_CTRL_FakeIrqSource = {
+    .name         = "fake",
+    .Open         = FPGA_CTRL_FakeOpen,
+    .Close        = FPGA_CTRL_FakeClose,
+    .Read         = FPGA_CTRL_FakeRead,
+    .Rearm        = FPGA_CTRL_FakeRearm,
+    .EventHandled = FPGA_CTRL_FakeEventHandled,
+};
@@ -0,0 +1,198 @@
+// Cooperative jobs for commands that take too long to run in one go. A job is a resumable state machine: its step
+// function does a short, bounded piece of the work, records in the job where to pick up and returns
+// FPGA_CTRL_JOB_PENDING, or returns the job's outcome once it's done. Whatever the job has to keep between steps lives
+// in its context, so it needs no stack or task of its own.
+// The main task steps the active jobs round robin between pipe reads, for at most the table's slice budget each
+// time, so housekeeping and control commands are still served while they run.
+// Runs on the main task only.
+
+#include <string.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+#include "fpga_ctrl_table.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_MAX_JOBS      8
+#define FPGA_CTRL_JOB_CTX_SIZE  64
+#define FPGA_CTRL_JOB_PEND_MS   1 // Pipe pend between slices while jobs are active
+#define FPGA_CTRL_JOB_PENDING   1 // Step result: not done, step again next slice
+#define FPGA_CTRL_JOB_CANCELLED 2 // Outcome of a job ended by FPGA_CTRL_CancelJobs, never a step result
+
+// Job flags
+#define FPGA_CTRL_JOB_FABRIC 0x01 // Uses the fabric, cancelled before it's reprogrammed
+
+typedef struct FPGA_CTRL_Job FPGA_CTRL_Job_t;
+
+// Returns FPGA_CTRL_JOB_PENDING to be resumed, anything else ends the job with that status
+typedef int32 (*FPGA_CTRL_JobStep_t)(FPGA_CTRL_Job_t *job);
+
+struct FPGA_CTRL_Job
+{
+    char const         *name;
+    FPGA_CTRL_JobStep_t step; // NULL when the slot is free
+    uint32              flags;
+    uint32              state; // Where the step picks up, 0 on the first one
+    uint32              seq;   // Order jobs were started in, jobSched.started at the time
+    int64               startNs;
+    uint32              slices;
+    union
+    {
+        uint64 align;
+        uint8  bytes[FPGA_CTRL_JOB_CTX_SIZE];
+    } ctx; // The job's own variables, kept across steps
+};
+
+typedef struct
+{
+    FPGA_CTRL_Job_t jobs[FPGA_CTRL_MAX_JOBS];
+    uint32          active;
+    uint32          next;    // Slot the next slice starts at, so every job gets its turn
+    uint16          sliceUs; // From the table, 0 = one step per job per slice
+    uint32          started;
+    uint32          completed;
+    uint32          failed;    // Not including those cancelled
+    uint32          cancelled;
+    uint32          maxSlices; // Most slices a job has taken
+    uint32          maxRunMs;  // Longest a job has taken, start to finish
+} FPGA_CTRL_JobSched_t;
+
+static FPGA_CTRL_JobSched_t jobSched;
+
+// Exported functions
+int32  FPGA_CTRL_StartJob(char const *name, FPGA_CTRL_JobStep_t step, uint32 flags, void const *ctx, size_t ctxSize);
+uint32 FPGA_CTRL_JobsFree(void);
+bool   FPGA_CTRL_JobsPending(void);
+void   FPGA_CTRL_LoadJobSlice(void);
+void   FPGA_CTRL_RunJobs(void);
+void   FPGA_CTRL_CancelJobs(uint32 flags);
+
+static void FPGA_CTRL_FinishJob(FPGA_CTRL_Job_t *job, int32 status);
+
+// Takes a free slot for the job, its first step runs in the next slice. ctx is copied into the job.
+int32 FPGA_CTRL_StartJob(char const *const name, FPGA_CTRL_JobStep_t const step, uint32 const flags,
+                         void const *const ctx, size_t const ctxSize)
+{
+    if (ctxSize > FPGA_CTRL_JOB_CTX_SIZE)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Job %s context is %u bytes, at most %u fit", name, (unsigned int)ctxSize,
+                          (unsigned int)FPGA_CTRL_JOB_CTX_SIZE);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    for (uint32 i = 0; i < FPGA_CTRL_MAX_JOBS; ++i)
+    {
+        FPGA_CTRL_Job_t *const job = &jobSched.jobs[i];
+        if (job->step != NULL)
+            continue;
+
+        memset(job, 0, sizeof(*job));
+        job->name    = name;
+        job->step    = step;
+        job->flags   = flags;
+        job->seq     = jobSched.started;
+        job->startNs = FPGA_CTRL_MonotonicNs();
+        if (ctx != NULL)
+            memcpy(job->ctx.bytes, ctx, ctxSize);
+
+        ++jobSched.active;
+        ++jobSched.started;
+        return CFE_SUCCESS;
+    }
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "All %u job slots busy, can't start %s",
+                      (unsigned int)FPGA_CTRL_MAX_JOBS, name);
+    return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+}
+
+uint32 FPGA_CTRL_JobsFree(void)
+{
+    return FPGA_CTRL_MAX_JOBS - jobSched.active;
+}
+
+bool FPGA_CTRL_JobsPending(void)
+{
+    return jobSched.active != 0;
+}
+
+// Copies the slice budget out of the table, at startup and after each table update
+void FPGA_CTRL_LoadJobSlice(void)
+{
+    FPGA_CTRL_Table_t *tblPtr;
+
+    if (CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0]) < CFE_SUCCESS)
+        return;
+
+    jobSched.sliceUs = tblPtr->JobSliceUs;
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+}
+
+// Steps every active job once, and keeps going round while the slice budget lasts
+void FPGA_CTRL_RunJobs(void)
+{
+    int64 const startNs = FPGA_CTRL_MonotonicNs();
+    int64 const sliceNs = (int64)jobSched.sliceUs * 1000;
+
+    do
+    {
+        for (uint32 n = 0; n < FPGA_CTRL_MAX_JOBS && jobSched.active != 0; ++n)
+        {
+            FPGA_CTRL_Job_t *const job = &jobSched.jobs[jobSched.next];
+            jobSched.next              = (jobSched.next + 1) % FPGA_CTRL_MAX_JOBS;
+            if (job->step == NULL)
+                continue;
+
+            ++job->slices;
+            int32 const status = job->step(job);
+            if (status != FPGA_CTRL_JOB_PENDING)
+                FPGA_CTRL_FinishJob(job, status);
+        }
+    } while (jobSched.active != 0 && sliceNs != 0 && FPGA_CTRL_MonotonicNs() - startNs < sliceNs);
+}
+
+// Ends the jobs with any of the flags without stepping them again, counted as cancelled and nothing else
+void FPGA_CTRL_CancelJobs(uint32 const flags)
+{
+    for (uint32 i = 0; i < FPGA_CTRL_MAX_JOBS; ++i)
+    {
+        FPGA_CTRL_Job_t *const job = &jobSched.jobs[i];
+        if (job->step == NULL || (job->flags & flags) == 0)
+            continue;
+
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Job %s cancelled after %u slices",
+                          job->name, (unsigned int)job->slices);
+        FPGA_CTRL_FinishJob(job, FPGA_CTRL_JOB_CANCELLED);
+    }
+}
+
+// The command was counted when the job started, so only a failure is counted now. Each job ends up in exactly one of
+// completed, failed and cancelled. A cancelled job isn't a command error, the reload that cancelled it reports itself.
+static void FPGA_CTRL_FinishJob(FPGA_CTRL_Job_t *const job, int32 const status)
+{
+    uint32 const runMs = (uint32)((FPGA_CTRL_MonotonicNs() - job->startNs) / 1000000);
+
+    if (status == CFE_SUCCESS)
+    {
+        ++jobSched.completed;
+    }
+    else if (status == FPGA_CTRL_JOB_CANCELLED)
+    {
+        ++jobSched.cancelled;
+    }
+    else
+    {
+        ++jobSched.failed;
+        ++globalState.ErrCounter;
+    }
+
+    if (job->slices > jobSched.maxSlices)
+        jobSched.maxSlices = job->slices;
+    if (runMs > jobSched.maxRunMs)
+        jobSched.maxRunMs = runMs;
+
+    job->step = NULL;
+    --jobSched.active;
+}
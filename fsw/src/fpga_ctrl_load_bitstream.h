@@ -1,35 +1,1132 @@
+// Loads bitstreams through the Linux FPGA manager. The bitstream is staged into the firmware search path and the
+// manager is triggered through sysfs for a full load, or a device tree overlay naming it is applied through configfs
+// for a partial one. All in-process on a background task so the command pipe stays responsive.
+// FPGA_MGR_TEST swaps the real sysfs and firmware directories for a fake tree with a software stand-in for the kernel
+// driver, so loading works on any Linux box.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <cfe.h>
 
-// Loads a bitstream using a script in the home directory.
-// Completely breaks cFS's abstractions, but it's just for the demo.
+#include "fpga_ctrl.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#ifdef FPGA_MGR_TEST
+#define FPGA_CTRL_FAKE_SYSFS_ROOT "/tmp/fpga_ctrl_fake"
+#define FPGA_CTRL_FIRMWARE_DIR    FPGA_CTRL_FAKE_SYSFS_ROOT "/lib/firmware"
+#define FPGA_CTRL_FPGA_MGR_DIR    FPGA_CTRL_FAKE_SYSFS_ROOT "/sys/class/fpga_manager/fpga0"
+#define FPGA_CTRL_OVERLAY_DIR     FPGA_CTRL_FAKE_SYSFS_ROOT "/sys/kernel/config/device-tree/overlays"
+#else
+#define FPGA_CTRL_FIRMWARE_DIR "/lib/firmware"
+#define FPGA_CTRL_FPGA_MGR_DIR "/sys/class/fpga_manager/fpga0"
+#define FPGA_CTRL_OVERLAY_DIR  "/sys/kernel/config/device-tree/overlays"
+#endif
+
+#define FPGA_CTRL_FPGA_MGR_FLAGS_FULL 0 // Full reconfiguration, see FPGA_MGR_* in linux/fpga/fpga-mgr.h
+#define FPGA_CTRL_STAGE_CHUNK_SIZE    (64 * 1024)
+#define FPGA_CTRL_PROGRESS_BYTES      (1024 * 1024) // Progress telemetry period while staging
+#define FPGA_CTRL_LZ4_SUFFIX          ".lz4"        // Dropped from the staged name of compressed bitstreams
+#define FPGA_CTRL_FABRIC_DOWN_POKE_MS 100           // Asks the main task again at this period until it answers
+
+// Phase times and sizes of the last load, reported in housekeeping
+typedef struct
+{
+    uint32 stageMs;         // Copying (and decompressing) the bitstream into the firmware directory
+    uint32 verifyMs;        // Checking the staged image against the table
+    uint32 programMs;       // Manager writing the fabric
+    uint32 remapMs;         // Reopening the interrupt device and GPIO mappings
+    uint32 downtimeMs;      // Fabric unusable, from the main task taking it down to the remap finishing
+    uint32 rawBytes;        // Size of the staged image
+    uint32 compressedBytes; // Size of the LZ4 source, 0 if it wasn't compressed
+    uint32 decompressKBps;  // Decompressed output rate, including writing it out
+    uint32 crc32c;          // CRC-32C of the staged image, 0 if the table has none for it
+    uint32 verifyMBps;      // CRC-32C throughput over the staged image
+} FPGA_CTRL_BitstreamTiming_t;
+
+// The reload in progress, owned by the reprogram task while running is set
+typedef struct
+{
+    char                         name[FPGA_CTRL_BITSTREAM_NAME_LEN]; // Table name for cached loads, empty otherwise
+    uint32                       region; // Reconfigurable region for partial loads, 0 for a full load
+    FPGA_CTRL_CachedBitstream_t *cached;                            // Image in memory for cached loads
+    char                         path[sizeof(((FPGA_CTRL_ReprogramCmd_t *)NULL)->path)];
+    char                         firmwareName[sizeof(((FPGA_CTRL_ReprogramCmd_t *)NULL)->path)];
+    char                         stagedPath[256];
+    uint32                       expectedCrc; // From the table, 0 if the bitstream isn't in it or has no CRC
+    char                         design[FPGA_CTRL_BITSTREAM_NAME_LEN]; // Table entry of the bitstream, empty if none
+    FPGA_CTRL_AccelDesc_t        accels[FPGA_CTRL_MAX_ACCELS];         // Cores registered once it's loaded
+    char                         overlay[FPGA_CTRL_BITSTREAM_PATH_LEN]; // Partial loads, overlay that programs it
+    uint32                       bytesTotal;
+    uint32                       bytesStaged;
+    int64                        startNs;
+    int64                        downStartNs; // Full loads, when the main task took the fabric down
+    FPGA_CTRL_BitstreamTiming_t  timing;
+    bool                         irqWasEnabled; // Full loads, interrupts were on before the main task quiesced them
+    atomic_bool                  running;
+    atomic_bool                  downRequested; // Full loads, verified and waiting for the main task to take it down
+    osal_id_t                    downSem;       // Given by the main task once the fabric is down
+    bool                         semCreated;
+
+    // Outcome of the last job, for the main task once running is clear
+    atomic_uint completed;   // Incremented as each job finishes
+    int32       result;      // CFE_SUCCESS or why it failed
+    bool        fabricReset; // Full load that took the fabric down, every region and core is gone
+} FPGA_CTRL_ReprogramJob_t;
+
+static FPGA_CTRL_ReprogramJob_t    reprogramJob;
+static FPGA_CTRL_BitstreamTiming_t lastBitstreamTiming;
+
+// Exported functions
+int32 FPGA_CTRL_LoadBitstream(FPGA_CTRL_ReprogramCmd_t const *SBBufPtr);
+int32 FPGA_CTRL_LoadNamedBitstream(FPGA_CTRL_ReprogramNamedCmd_t const *Msg);
+bool  FPGA_CTRL_CheckFabricUp(CFE_MSG_FcnCode_t CommandCode);
+void  FPGA_CTRL_ServeReprogramJob(void);
+
+static int32 FPGA_CTRL_CheckCanReprogram(void);
+static int32 FPGA_CTRL_SetJobPath(char const *path);
+static int32 FPGA_CTRL_StartReprogramJob(char const *what);
+static int32 FPGA_CTRL_LookupManifest(void);
+static void  FPGA_CTRL_TakeFabricDown(void);
+static void  FPGA_CTRL_RequestFabricDown(void);
+static void  FPGA_CTRL_BringFabricBack(void);
+static void  FPGA_CTRL_ReprogramTask(void);
+static int32 FPGA_CTRL_RunReprogramJob(void);
+static void  FPGA_CTRL_SetFabricState(uint32 state);
+static void  FPGA_CTRL_SendReprogramTlm(uint32 elapsedMs);
+static int32 FPGA_CTRL_StageBitstream(void);
+static int32 FPGA_CTRL_StageFromFile(char const *tmpPath);
+static int32 FPGA_CTRL_StageFromMemory(char const *tmpPath, uint8 const *data, uint32 size);
+static int32 FPGA_CTRL_StageChunk(void *dst, void const *chunk, size_t len);
+static int32 FPGA_CTRL_VerifyStagedBitstream(void);
+static int32 FPGA_CTRL_TriggerFpgaMgr(char const *firmwareName);
+static int32 FPGA_CTRL_CheckFpgaMgrState(void);
+static int32 FPGA_CTRL_StageOverlay(char *overlayName, size_t size);
+static int32 FPGA_CTRL_ApplyOverlay(uint32 region, char const *overlayName);
+static void  FPGA_CTRL_RemoveOverlay(uint32 region);
+static void  FPGA_CTRL_OverlayDir(uint32 region, char *dir, size_t size);
+static void  FPGA_CTRL_PokeMainTask(void);
+static int32 FPGA_CTRL_WriteSysfsAttr(char const *attr, char const *value);
+static int32 FPGA_CTRL_ReadSysfsAttr(char const *attr, char *value, size_t size);
+static int32 FPGA_CTRL_WriteAttr(char const *path, char const *value);
+static int32 FPGA_CTRL_ReadAttr(char const *path, char *value, size_t size);
+#ifdef FPGA_MGR_TEST
+static int32 FPGA_CTRL_FakeFpgaMgrInit(void);
+static void  FPGA_CTRL_FakeFpgaMgrProgram(void);
+static void  FPGA_CTRL_FakeOverlayApply(char const *dir);
+#endif
+
+// Validates the request and hands it to the reprogram task, the result is reported by events and telemetry
 int32 FPGA_CTRL_LoadBitstream(FPGA_CTRL_ReprogramCmd_t const *SBBufPtr)
 {
-    static char const *const SCRIPT_PATH   = "/home/ubuntu/program-fpga.sh";
-    char const *const        bitstreamPath = SBBufPtr->path;
+    char const *const bitstreamPath = SBBufPtr->path;
+    int32             err;
 
     BUGCHECK(bitstreamPath != NULL, OS_INVALID_POINTER);
 
+    if ((err = FPGA_CTRL_CheckCanReprogram()) != CFE_SUCCESS)
+        return err;
+
+    if (memchr(bitstreamPath, '\0', sizeof(SBBufPtr->path)) == NULL)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Bitstream path isn't terminated");
+        return CFE_FS_FNAME_TOO_LONG;
+    }
+
+    if ((err = FPGA_CTRL_SetJobPath(bitstreamPath)) != CFE_SUCCESS)
+        return err;
+
+    reprogramJob.name[0] = '\0';
+    reprogramJob.region  = 0;
+    return FPGA_CTRL_StartReprogramJob(bitstreamPath);
+}
+
+// Loads a bitstream from the table by name, through the cache. The path is resolved by the reprogram task.
+int32 FPGA_CTRL_LoadNamedBitstream(FPGA_CTRL_ReprogramNamedCmd_t const *const Msg)
+{
     int32 err;
 
-    char buf[256];
-    if ((err = snprintf(buf, sizeof(buf), "bash -c \"%s %s\"", SCRIPT_PATH, bitstreamPath)) >= sizeof(buf))
+    if ((err = FPGA_CTRL_CheckCanReprogram()) != CFE_SUCCESS)
+        return err;
+
+    if (memchr(Msg->name, '\0', sizeof(Msg->name)) == NULL || Msg->name[0] == '\0')
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Bitstream name is empty or too long");
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    strncpy(reprogramJob.name, Msg->name, sizeof(reprogramJob.name) - 1);
+    reprogramJob.name[sizeof(reprogramJob.name) - 1] = '\0';
+    reprogramJob.path[0]                             = '\0';
+    reprogramJob.firmwareName[0]                     = '\0';
+    reprogramJob.region                              = 0;
+    return FPGA_CTRL_StartReprogramJob(reprogramJob.name);
+}
+
+static int32 FPGA_CTRL_CheckCanReprogram(void)
+{
+    if (reprogramJob.running)
     {
         CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                          "Command to program FPGA is too long (%d bytes)", err);
+                          "Reprogramming with %s already in progress",
+                          reprogramJob.name[0] != '\0' ? reprogramJob.name : reprogramJob.path);
+        return CFE_STATUS_INCORRECT_STATE;
+    }
+
+    // The sampler maps the GPIO itself and can't be remapped under its feet
+    if (sampler.samplerRunning || sampler.writerRunning)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Stop sampling before reprogramming");
+        return CFE_STATUS_INCORRECT_STATE;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Sets the source path and works out the name the manager will look for in the firmware directory.
+// Compressed bitstreams are staged decompressed, without their .lz4 suffix.
+static int32 FPGA_CTRL_SetJobPath(char const *const path)
+{
+    char const *const slash    = strrchr(path, '/');
+    char const *const baseName = slash != NULL ? slash + 1 : path;
+    size_t            nameLen  = strlen(baseName);
+    size_t const      sfxLen   = sizeof(FPGA_CTRL_LZ4_SUFFIX) - 1;
+
+    if (nameLen > sfxLen && strcmp(baseName + nameLen - sfxLen, FPGA_CTRL_LZ4_SUFFIX) == 0)
+        nameLen -= sfxLen;
+
+    if (nameLen == 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Bitstream path %s has no file name",
+                          path);
+        return CFE_FS_INVALID_PATH;
+    }
+
+    if (snprintf(reprogramJob.stagedPath, sizeof(reprogramJob.stagedPath), "%s/%.*s", FPGA_CTRL_FIRMWARE_DIR,
+                 (int)nameLen, baseName) >= (int)sizeof(reprogramJob.stagedPath))
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Staged bitstream path is too long");
         return CFE_FS_FNAME_TOO_LONG;
     }
-    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Executing command %s", buf);
 
-    // This is very bad
-    if ((err = system(buf)))
+    strncpy(reprogramJob.path, path, sizeof(reprogramJob.path) - 1);
+    reprogramJob.path[sizeof(reprogramJob.path) - 1] = '\0';
+    snprintf(reprogramJob.firmwareName, sizeof(reprogramJob.firmwareName), "%.*s", (int)nameLen, baseName);
+    return CFE_SUCCESS;
+}
+
+static int32 FPGA_CTRL_StartReprogramJob(char const *const what)
+{
+    int32           err;
+    CFE_ES_TaskId_t taskId;
+
+    reprogramJob.cached      = NULL;
+    reprogramJob.expectedCrc = 0;
+    reprogramJob.design[0]   = '\0';
+    reprogramJob.overlay[0]  = '\0';
+    reprogramJob.fabricReset = false;
+    memset(reprogramJob.accels, 0, sizeof(reprogramJob.accels));
+    reprogramJob.bytesTotal  = 0;
+    reprogramJob.bytesStaged = 0;
+    memset(&reprogramJob.timing, 0, sizeof(reprogramJob.timing));
+
+    if (!reprogramJob.semCreated)
+    {
+        if ((err = OS_BinSemCreate(&reprogramJob.downSem, "FPGA_CTRL down sem", OS_SEM_EMPTY, 0)) != OS_SUCCESS)
+        {
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                              "Failed to create reprogram semaphore: %d", (int)err);
+            return err;
+        }
+        reprogramJob.semCreated = true;
+    }
+
+    reprogramJob.running = true;
+    if ((err = CFE_ES_CreateChildTask(&taskId, "FPGA_CTRL reprogram", FPGA_CTRL_ReprogramTask,
+                                      CFE_ES_TASK_STACK_ALLOCATE, CFE_PLATFORM_ES_DEFAULT_STACK_SIZE,
+                                      CFE_PLATFORM_ES_PERF_CHILD_PRIORITY, 0)) < CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "Failed to create reprogram task: 0x%x", err);
+        reprogramJob.running = false;
+        return err;
+    }
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Reprogramming with %s", what);
+    return CFE_SUCCESS;
+}
+
+// Answers the reprogram task on the main task, taking the fabric down once a full load's bitstream is verified
+void FPGA_CTRL_ServeReprogramJob(void)
+{
+    if (!reprogramJob.downRequested)
+        return;
+
+    FPGA_CTRL_TakeFabricDown();
+    reprogramJob.downRequested = false;
+    OS_BinSemGive(reprogramJob.downSem);
+}
+
+// Takes the fabric away from everything on the main task just before a full load programs it: fabric commands,
+// INT_CTRL included, are refused from here on, no job is left stepping through a core, and interrupts are masked
+// with their setting kept for after the load. The reprogram task can then unmap the cores and delete the interrupt
+// device without anything on the main task racing it.
+static void FPGA_CTRL_TakeFabricDown(void)
+{
+    globalState.fabricUp     = false;
+    reprogramJob.downStartNs = FPGA_CTRL_MonotonicNs();
+    FPGA_CTRL_CancelJobs(FPGA_CTRL_JOB_FABRIC);
+
+    reprogramJob.irqWasEnabled = globalState.irqEnabled;
+    globalState.irqEnabled     = false;
+    FPGA_CTRL_SetGpioIrqMasked(true);
+}
+
+// Waits on the reprogram task for the main task to take the fabric down. The request rides on the command pipe, so
+// it's repeated in case the pipe was full.
+static void FPGA_CTRL_RequestFabricDown(void)
+{
+    reprogramJob.downRequested = true;
+    while (reprogramJob.downRequested)
+    {
+        FPGA_CTRL_PokeMainTask();
+        OS_BinSemTimedWait(reprogramJob.downSem, FPGA_CTRL_FABRIC_DOWN_POKE_MS);
+    }
+}
+
+// Undoes FPGA_CTRL_TakeFabricDown once the new design is loaded
+static void FPGA_CTRL_BringFabricBack(void)
+{
+    if (reprogramJob.irqWasEnabled && irqDev.available)
+    {
+        globalState.irqEnabled = true;
+        FPGA_CTRL_SetGpioIrqMasked(false);
+        OS_BinSemGive(irqDev.wakeSem);
+    }
+
+    globalState.fabricUp = true;
+}
+
+// Finds the bitstream's table entry, by name for named loads and by path otherwise, and takes the CRC to check it
+// against and the cores to register once it's loaded. Fails if the table requires a CRC and there isn't one, or if
+// the entry is for a different region than the load.
+static int32 FPGA_CTRL_LookupManifest(void)
+{
+    FPGA_CTRL_Table_t *tblPtr;
+    int32              err;
+
+    if ((err = CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0])) < CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "Couldn't read table to look up the CRC of %s", reprogramJob.path);
+        return err;
+    }
+
+    uint32 entryRegion = reprogramJob.region;
+    for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+    {
+        FPGA_CTRL_BitstreamEntry_t const *const entry = &tblPtr->Bitstreams[i];
+        if (entry->Name[0] != '\0' && (reprogramJob.name[0] != '\0' ? strcmp(entry->Name, reprogramJob.name) == 0
+                                                                    : strcmp(entry->Path, reprogramJob.path) == 0))
+        {
+            reprogramJob.expectedCrc = entry->Crc32c;
+            memcpy(reprogramJob.design, entry->Name, sizeof(reprogramJob.design));
+            memcpy(reprogramJob.accels, entry->Accels, sizeof(reprogramJob.accels));
+            memcpy(reprogramJob.overlay, entry->Overlay, sizeof(reprogramJob.overlay));
+            entryRegion = entry->Region;
+            break;
+        }
+    }
+
+    bool const required = tblPtr->RequireBitstreamCrc;
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+
+    if (entryRegion != reprogramJob.region)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "Table entry %s is for region %u, the load is into region %u (0 = full design)",
+                          reprogramJob.design, (unsigned int)entryRegion, (unsigned int)reprogramJob.region);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    if (reprogramJob.expectedCrc == 0 && required)
     {
         CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
-                          "Failed to load bitstream file %s, err = %d", bitstreamPath, err);
+                          "No CRC in the table for %s, refusing to load it", reprogramJob.path);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Rejects commands that touch the fabric while it's being reprogrammed or after a failed load.
+// The dispatcher counts the rejection as a command error.
+bool FPGA_CTRL_CheckFabricUp(CFE_MSG_FcnCode_t const CommandCode)
+{
+    if (globalState.fabricUp)
+        return true;
+
+    CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
+                      "Fabric is down (state %u), rejecting command CC = %u", (unsigned int)globalState.fabricState,
+                      (unsigned int)CommandCode);
+    return false;
+}
+
+// Runs one reload and reports how it went
+static void FPGA_CTRL_ReprogramTask(void)
+{
+    FPGA_CTRL_ApplyChildSchedProfile(0);
+
+    FPGA_CTRL_BitstreamTiming_t const *const timing = &reprogramJob.timing;
+    char const *const what = reprogramJob.name[0] != '\0' ? reprogramJob.name : reprogramJob.path;
+
+    CFE_ES_PerfLogEntry(FPGA_CTRL_REPROGRAM_PERF_ID);
+    reprogramJob.startNs = FPGA_CTRL_MonotonicNs();
+
+    int32 const err = FPGA_CTRL_RunReprogramJob();
+    reprogramJob.result = err;
+    if (err == CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                          "Loaded bitstream %s, downtime %u ms (stage %u, verify %u, program %u, remap %u ms)", what,
+                          (unsigned int)timing->downtimeMs, (unsigned int)timing->stageMs,
+                          (unsigned int)timing->verifyMs, (unsigned int)timing->programMs,
+                          (unsigned int)timing->remapMs);
+    }
+    else
+    {
+        // A full load that failed staging or verification never took the fabric down, the old design is still
+        // loaded and in use. Once it's down it stays down, accelerator commands are refused until a load succeeds.
+        // A failed partial load only leaves its region empty.
+        bool const down = reprogramJob.region == 0 && !globalState.fabricUp;
+        FPGA_CTRL_SetFabricState(down ? FPGA_CTRL_FABRIC_FAILED : FPGA_CTRL_FABRIC_READY);
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "Failed to load bitstream %s, err = 0x%x, fabric %s", what, (unsigned int)err,
+                          down ? "down" : "unchanged");
+    }
+
+    CFE_ES_PerfLogExit(FPGA_CTRL_REPROGRAM_PERF_ID);
+    FPGA_CTRL_PROBE3(bitstream__done, err, timing->downtimeMs, timing->rawBytes);
+
+    ++reprogramJob.completed;
+    reprogramJob.running = false;
+
+    // The main task registers a partial load's cores and runs the jobs that were waiting on the load
+    FPGA_CTRL_PokeMainTask();
+
+    CFE_ES_ExitChildTask();
+}
+
+// Stages and verifies the bitstream with the old design still running, then has the main task take the fabric
+// down, quiesces the interrupt task, programs the fabric and brings the interrupt device back up. Every state change
+// is published on FPGA_CTRL_REPROGRAM_TLM_MID.
+static int32 FPGA_CTRL_RunReprogramJob(void)
+{
+    FPGA_CTRL_BitstreamTiming_t *const timing = &reprogramJob.timing;
+    int32                              err;
+
+#ifdef FPGA_MGR_TEST
+    if ((err = FPGA_CTRL_FakeFpgaMgrInit()) != CFE_SUCCESS)
+        return err;
+#endif
+
+    int64 phaseStartNs = FPGA_CTRL_MonotonicNs();
+    FPGA_CTRL_SetFabricState(FPGA_CTRL_FABRIC_STAGING);
+
+    // A miss maps the file here rather than on the main task, so it counts as staging time
+    if (reprogramJob.name[0] != '\0' &&
+        ((err = FPGA_CTRL_BitstreamCacheGet(reprogramJob.name, &reprogramJob.cached)) != CFE_SUCCESS ||
+         (err = FPGA_CTRL_SetJobPath(reprogramJob.cached->path)) != CFE_SUCCESS))
+    {
+        return err;
+    }
+
+    if ((err = FPGA_CTRL_LookupManifest()) != CFE_SUCCESS || (err = FPGA_CTRL_StageBitstream()) != CFE_SUCCESS)
+        return err;
+    timing->stageMs  = (uint32)((FPGA_CTRL_MonotonicNs() - phaseStartNs) / 1000000);
+    timing->rawBytes = reprogramJob.bytesTotal;
+
+    if (timing->compressedBytes != 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                          "Decompressed %s, %u -> %u bytes (ratio %u.%02u), %u KB/s", reprogramJob.firmwareName,
+                          (unsigned int)timing->compressedBytes, (unsigned int)timing->rawBytes,
+                          (unsigned int)(timing->rawBytes / timing->compressedBytes),
+                          (unsigned int)((uint64)timing->rawBytes * 100 / timing->compressedBytes % 100),
+                          (unsigned int)timing->decompressKBps);
+    }
+
+    phaseStartNs = FPGA_CTRL_MonotonicNs();
+    FPGA_CTRL_SetFabricState(FPGA_CTRL_FABRIC_VERIFYING);
+    if ((err = FPGA_CTRL_VerifyStagedBitstream()) != CFE_SUCCESS)
         return err;
+    timing->verifyMs = (uint32)((FPGA_CTRL_MonotonicNs() - phaseStartNs) / 1000000);
+
+    // Partial loads leave the rest of the fabric running. The main task already dropped the region's old cores.
+    if (reprogramJob.region != 0)
+    {
+        char overlayName[sizeof(reprogramJob.overlay)];
+
+        phaseStartNs = FPGA_CTRL_MonotonicNs();
+        FPGA_CTRL_SetFabricState(FPGA_CTRL_FABRIC_PROGRAMMING);
+        if ((err = FPGA_CTRL_StageOverlay(overlayName, sizeof(overlayName))) != CFE_SUCCESS ||
+            (err = FPGA_CTRL_ApplyOverlay(reprogramJob.region, overlayName)) != CFE_SUCCESS)
+        {
+            return err;
+        }
+        timing->programMs = (uint32)((FPGA_CTRL_MonotonicNs() - phaseStartNs) / 1000000);
+
+        lastBitstreamTiming = *timing;
+        FPGA_CTRL_SetFabricState(FPGA_CTRL_FABRIC_READY);
+        return CFE_SUCCESS;
     }
 
-    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Loaded bitstream file %s",
-                      bitstreamPath);
+    // Nothing can fail from here until the manager is written, so the fabric only goes down for a load that will
+    // be attempted. The main task stops everything touching it, see FPGA_CTRL_TakeFabricDown.
+    FPGA_CTRL_RequestFabricDown();
+    reprogramJob.fabricReset = true;
+    FPGA_CTRL_CleanupInterrupts();
+    FPGA_CTRL_ClearAccelRegistry();
+
+    // The regions belong to the design being replaced
+    for (uint32 region = 1; region <= FPGA_CTRL_MAX_REGIONS; ++region)
+        FPGA_CTRL_RemoveOverlay(region);
+
+    phaseStartNs = FPGA_CTRL_MonotonicNs();
+    FPGA_CTRL_SetFabricState(FPGA_CTRL_FABRIC_PROGRAMMING);
+    if ((err = FPGA_CTRL_TriggerFpgaMgr(reprogramJob.firmwareName)) != CFE_SUCCESS ||
+        (err = FPGA_CTRL_CheckFpgaMgrState()) != CFE_SUCCESS)
+    {
+        return err;
+    }
+    timing->programMs = (uint32)((FPGA_CTRL_MonotonicNs() - phaseStartNs) / 1000000);
+
+    // A bitstream that isn't in the table loads with no cores registered, so accelerator commands are refused.
+    // Not every design has the GPIO block either, so losing interrupts doesn't fail the load.
+    phaseStartNs = FPGA_CTRL_MonotonicNs();
+    FPGA_CTRL_SetFabricState(FPGA_CTRL_FABRIC_REMAPPING);
+    FPGA_CTRL_BuildAccelRegistry(reprogramJob.design, reprogramJob.accels);
+    if (FPGA_CTRL_InitInterrupts() != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "Interrupts unavailable with bitstream %s", reprogramJob.firmwareName);
+    }
+    timing->remapMs = (uint32)((FPGA_CTRL_MonotonicNs() - phaseStartNs) / 1000000);
+
+    timing->downtimeMs  = (uint32)((FPGA_CTRL_MonotonicNs() - reprogramJob.downStartNs) / 1000000);
+    lastBitstreamTiming = *timing;
+    FPGA_CTRL_BringFabricBack();
+    FPGA_CTRL_SetFabricState(FPGA_CTRL_FABRIC_READY);
 
     return CFE_SUCCESS;
 }
+
+// Also moves the reload's phase marker in the performance log, leaving it closed once the fabric is ready or failed
+static void FPGA_CTRL_SetFabricState(uint32 const state)
+{
+    static uint32 const phasePerfIds[] = {
+        [FPGA_CTRL_FABRIC_STAGING]     = FPGA_CTRL_STAGE_PERF_ID,
+        [FPGA_CTRL_FABRIC_VERIFYING]   = FPGA_CTRL_VERIFY_PERF_ID,
+        [FPGA_CTRL_FABRIC_PROGRAMMING] = FPGA_CTRL_PROGRAM_PERF_ID,
+        [FPGA_CTRL_FABRIC_REMAPPING]   = FPGA_CTRL_REMAP_PERF_ID,
+    };
+    size_t const numStates = sizeof(phasePerfIds) / sizeof(phasePerfIds[0]);
+    uint32 const previous  = globalState.fabricState;
+
+    if (previous < numStates && phasePerfIds[previous] != 0)
+        CFE_ES_PerfLogExit(phasePerfIds[previous]);
+    globalState.fabricState = state;
+    if (state < numStates && phasePerfIds[state] != 0)
+        CFE_ES_PerfLogEntry(phasePerfIds[state]);
+
+    // Read once for the telemetry, the probe and trace take it from there rather than reading the clock themselves
+    uint32 const elapsedMs = (uint32)((FPGA_CTRL_MonotonicNs() - reprogramJob.startNs) / 1000000);
+    FPGA_CTRL_PROBE2(bitstream__phase, state, elapsedMs);
+    FPGA_CTRL_TRACE(INFO, BITSTREAM, "%s: fabric state %u after %u ms", reprogramJob.firmwareName,
+                    (unsigned int)state, (unsigned int)elapsedMs);
+
+    FPGA_CTRL_SendReprogramTlm(elapsedMs);
+}
+
+static void FPGA_CTRL_SendReprogramTlm(uint32 const elapsedMs)
+{
+    static FPGA_CTRL_ReprogramTlm_t packet;
+
+    CFE_MSG_Init(&packet.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_REPROGRAM_TLM_MID), sizeof(packet));
+
+    packet.fabricState = globalState.fabricState;
+    packet.fabricUp    = globalState.fabricUp;
+    packet.bytesTotal  = reprogramJob.bytesTotal;
+    packet.bytesStaged = reprogramJob.bytesStaged;
+    packet.elapsedMs   = elapsedMs;
+    strncpy(packet.firmwareName, reprogramJob.firmwareName, sizeof(packet.firmwareName) - 1);
+    packet.firmwareName[sizeof(packet.firmwareName) - 1] = '\0';
+
+    CFE_SB_TimeStampMsg(&packet.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&packet.TlmHeader.Msg, true);
+}
+
+// Copies the bitstream into the firmware directory under a temporary name and renames it into place, so the
+// manager never sees a partial file. Skipped when the bitstream already lives there, or for a cached bitstream
+// when the copy it staged last time is still untouched.
+static int32 FPGA_CTRL_StageBitstream(void)
+{
+    FPGA_CTRL_CachedBitstream_t *const cached     = reprogramJob.cached;
+    char const *const                  stagedPath = reprogramJob.stagedPath;
+    char                               tmpPath[sizeof(reprogramJob.stagedPath) + 8];
+    struct stat                        srcStat, dstStat;
+    bool const                         haveDst = stat(stagedPath, &dstStat) == 0;
+
+    if (cached != NULL)
+    {
+        if (haveDst && cached->staged && cached->stagedDev == dstStat.st_dev && cached->stagedIno == dstStat.st_ino &&
+            cached->stagedMtime.tv_sec == dstStat.st_mtim.tv_sec &&
+            cached->stagedMtime.tv_nsec == dstStat.st_mtim.tv_nsec && (uint32)dstStat.st_size == cached->stagedSize)
+        {
+            reprogramJob.bytesTotal  = cached->stagedSize;
+            reprogramJob.bytesStaged = reprogramJob.bytesTotal;
+            return CFE_SUCCESS;
+        }
+    }
+    else
+    {
+        if (stat(reprogramJob.path, &srcStat) < 0)
+        {
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Can't find bitstream file %s: %s",
+                              reprogramJob.path, strerror(errno));
+            return CFE_FS_INVALID_PATH;
+        }
+
+        if (haveDst && srcStat.st_dev == dstStat.st_dev && srcStat.st_ino == dstStat.st_ino)
+        {
+            reprogramJob.bytesTotal  = (uint32)srcStat.st_size;
+            reprogramJob.bytesStaged = reprogramJob.bytesTotal;
+            return CFE_SUCCESS;
+        }
+    }
+
+    // The cache evicts an image that fails its check, so the job lets go of it
+    if (cached != NULL && FPGA_CTRL_BitstreamCacheCheck(cached) != CFE_SUCCESS)
+    {
+        reprogramJob.cached = NULL;
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", stagedPath);
+
+    int32 const err = cached != NULL ? FPGA_CTRL_StageFromMemory(tmpPath, cached->data, cached->size)
+                                     : FPGA_CTRL_StageFromFile(tmpPath);
+    if (err != CFE_SUCCESS || rename(tmpPath, stagedPath) < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to stage %s into %s: %s",
+                          reprogramJob.path, FPGA_CTRL_FIRMWARE_DIR,
+                          err != CFE_SUCCESS ? "decompress or write failed" : strerror(errno));
+        unlink(tmpPath);
+        return err != CFE_SUCCESS ? err : CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    // Remember the staged copy so the next load of this bitstream can skip writing it
+    if (cached != NULL && stat(stagedPath, &dstStat) == 0)
+    {
+        cached->staged      = true;
+        cached->stagedDev   = dstStat.st_dev;
+        cached->stagedIno   = dstStat.st_ino;
+        cached->stagedMtime = dstStat.st_mtim;
+        cached->stagedSize  = (uint32)dstStat.st_size;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Maps the source file so it goes through the same path as a cached image
+static int32 FPGA_CTRL_StageFromFile(char const *const tmpPath)
+{
+    struct stat srcStat;
+
+    int const src = open(reprogramJob.path, O_RDONLY);
+    if (src < 0 || fstat(src, &srcStat) < 0 || srcStat.st_size == 0)
+    {
+        if (src >= 0)
+            close(src);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    // Read sequentially once, let the kernel read ahead and drop pages behind us
+    void *const data = mmap(NULL, srcStat.st_size, PROT_READ, MAP_PRIVATE, src, 0);
+    close(src);
+    if (data == MAP_FAILED)
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    madvise(data, srcStat.st_size, MADV_SEQUENTIAL);
+
+    int32 const err = FPGA_CTRL_StageFromMemory(tmpPath, data, (uint32)srcStat.st_size);
+
+    munmap(data, srcStat.st_size);
+    return err;
+}
+
+// Writes an image out to tmpPath, decompressing it on the way if it's an LZ4 frame
+static int32 FPGA_CTRL_StageFromMemory(char const *const tmpPath, uint8 const *const data, uint32 const size)
+{
+    int const dst = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (dst < 0)
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+
+    int32 err = CFE_SUCCESS;
+    if (FPGA_CTRL_Lz4IsFrame(data, size))
+    {
+        uint64 const contentSize = FPGA_CTRL_Lz4ContentSize(data, size);
+        reprogramJob.bytesTotal  = contentSize != 0 ? (uint32)contentSize : size;
+
+        int64 const startNs = FPGA_CTRL_MonotonicNs();
+        uint64      rawSize;
+        err = FPGA_CTRL_Lz4Decompress(data, size, FPGA_CTRL_StageChunk, (void *)&dst, &rawSize);
+
+        int64 const elapsedUs               = (FPGA_CTRL_MonotonicNs() - startNs) / 1000;
+        reprogramJob.timing.compressedBytes = size;
+        reprogramJob.timing.decompressKBps  = elapsedUs > 0 ? (uint32)(rawSize * 1000 / 1024 * 1000 / elapsedUs) : 0;
+    }
+    else
+    {
+        reprogramJob.bytesTotal = size;
+        for (uint32 offset = 0; offset < size && err == CFE_SUCCESS; offset += FPGA_CTRL_STAGE_CHUNK_SIZE)
+        {
+            uint32 const len = size - offset < FPGA_CTRL_STAGE_CHUNK_SIZE ? size - offset : FPGA_CTRL_STAGE_CHUNK_SIZE;
+            err              = FPGA_CTRL_StageChunk((void *)&dst, data + offset, len);
+        }
+    }
+
+    if (close(dst) < 0 && err == CFE_SUCCESS)
+        err = CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+
+    // From here on the total is what the manager will read
+    reprogramJob.bytesTotal = reprogramJob.bytesStaged;
+    return err;
+}
+
+// Writes one chunk of the staged file and publishes progress every FPGA_CTRL_PROGRESS_BYTES.
+// dst points at the file descriptor, the signature doubles as the LZ4 sink.
+static int32 FPGA_CTRL_StageChunk(void *const dst, void const *const chunk, size_t const len)
+{
+    if (write(*(int const *)dst, chunk, len) != (ssize_t)len)
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+
+    uint32 const before = reprogramJob.bytesStaged;
+    reprogramJob.bytesStaged += (uint32)len;
+    if (before / FPGA_CTRL_PROGRESS_BYTES != reprogramJob.bytesStaged / FPGA_CTRL_PROGRESS_BYTES)
+        FPGA_CTRL_SendReprogramTlm((uint32)((FPGA_CTRL_MonotonicNs() - reprogramJob.startNs) / 1000000));
+
+    return CFE_SUCCESS;
+}
+
+// Makes sure the staged image is complete and matches the table's CRC before the fabric is taken down for it.
+// The file is checked as the manager will read it, so corruption in staging or on storage is caught too.
+static int32 FPGA_CTRL_VerifyStagedBitstream(void)
+{
+    FPGA_CTRL_BitstreamTiming_t *const timing = &reprogramJob.timing;
+    struct stat                        stagedStat;
+
+    int const fd = open(reprogramJob.stagedPath, O_RDONLY);
+    if (fd < 0 || fstat(fd, &stagedStat) < 0 || stagedStat.st_size == 0 ||
+        (uint32)stagedStat.st_size != reprogramJob.bytesTotal)
+    {
+        if (fd >= 0)
+            close(fd);
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "Staged bitstream %s is missing or incomplete", reprogramJob.stagedPath);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    if (reprogramJob.expectedCrc == 0)
+    {
+        close(fd);
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                          "No CRC in the table for %s, loading it unchecked", reprogramJob.firmwareName);
+        return CFE_SUCCESS;
+    }
+
+    size_t const size = (size_t)stagedStat.st_size;
+    void *const  data = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to map %s to check it: %s",
+                          reprogramJob.stagedPath, strerror(errno));
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    int64 const startNs = FPGA_CTRL_MonotonicNs();
+    uint32      threads;
+    timing->crc32c = FPGA_CTRL_Crc32cParallel(data, size, &threads);
+    int64 const elapsedUs = (FPGA_CTRL_MonotonicNs() - startNs) / 1000;
+    munmap(data, size);
+
+    timing->verifyMBps = elapsedUs > 0 ? (uint32)((uint64)size / elapsedUs) : 0;
+
+    if (timing->crc32c != reprogramJob.expectedCrc)
+    {
+        FPGA_CTRL_StatsBegin(&globalState.BitstreamStats.lock);
+        ++globalState.BitstreamStats.verifyFailures;
+        FPGA_CTRL_StatsEnd(&globalState.BitstreamStats.lock);
+
+        // Don't trust the cached staged copy again, the next load rewrites it
+        if (reprogramJob.cached != NULL)
+            reprogramJob.cached->staged = false;
+
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "CRC-32C mismatch on %s, expected 0x%08x, got 0x%08x", reprogramJob.stagedPath,
+                          (unsigned int)reprogramJob.expectedCrc, (unsigned int)timing->crc32c);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "Verified %s, CRC-32C 0x%08x, %u bytes in %u us on %u threads (%s)", reprogramJob.firmwareName,
+                      (unsigned int)timing->crc32c, (unsigned int)size, (unsigned int)elapsedUs, (unsigned int)threads,
+                      FPGA_CTRL_Crc32cImplName());
+    return CFE_SUCCESS;
+}
+
+// Writing the firmware attribute makes the kernel load and program the bitstream before the write returns
+static int32 FPGA_CTRL_TriggerFpgaMgr(char const *const firmwareName)
+{
+    char  flags[12];
+    int32 err;
+
+    snprintf(flags, sizeof(flags), "%d", FPGA_CTRL_FPGA_MGR_FLAGS_FULL);
+    if ((err = FPGA_CTRL_WriteSysfsAttr("flags", flags)) != CFE_SUCCESS ||
+        (err = FPGA_CTRL_WriteSysfsAttr("firmware", firmwareName)) != CFE_SUCCESS)
+    {
+        return err;
+    }
+
+#ifdef FPGA_MGR_TEST
+    FPGA_CTRL_FakeFpgaMgrProgram();
+#endif
+
+    return CFE_SUCCESS;
+}
+
+// The manager reports operating once the fabric is programmed and released from reset
+static int32 FPGA_CTRL_CheckFpgaMgrState(void)
+{
+    char  state[32];
+    int32 err;
+
+    if ((err = FPGA_CTRL_ReadSysfsAttr("state", state, sizeof(state))) != CFE_SUCCESS)
+        return err;
+
+    if (strcmp(state, "operating") != 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA manager is in state '%s' after load",
+                          state);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Copies the overlay into the firmware directory, where configfs looks for it, and returns its name there
+static int32 FPGA_CTRL_StageOverlay(char *const overlayName, size_t const size)
+{
+    char const *const slash    = strrchr(reprogramJob.overlay, '/');
+    char const *const baseName = slash != NULL ? slash + 1 : reprogramJob.overlay;
+    char              stagedPath[sizeof(reprogramJob.stagedPath)];
+    char              tmpPath[sizeof(stagedPath) + 8];
+    uint8             buf[4096];
+    struct stat       srcStat, dstStat;
+    int32             err = CFE_SUCCESS;
+
+    snprintf(overlayName, size, "%s", baseName);
+    snprintf(stagedPath, sizeof(stagedPath), "%s/%s", FPGA_CTRL_FIRMWARE_DIR, baseName);
+
+    int const src = open(reprogramJob.overlay, O_RDONLY);
+    if (src < 0 || fstat(src, &srcStat) < 0)
+    {
+        if (src >= 0)
+            close(src);
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Can't open overlay %s: %s",
+                          reprogramJob.overlay, strerror(errno));
+        return CFE_FS_INVALID_PATH;
+    }
+
+    if (stat(stagedPath, &dstStat) == 0 && srcStat.st_dev == dstStat.st_dev && srcStat.st_ino == dstStat.st_ino)
+    {
+        close(src);
+        return CFE_SUCCESS;
+    }
+
+    // Overlays are a few KB, a plain copy is fine
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", stagedPath);
+    int const dst = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (dst < 0)
+        err = CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+
+    ssize_t bytesRead;
+    while (err == CFE_SUCCESS && (bytesRead = read(src, buf, sizeof(buf))) != 0)
+    {
+        if (bytesRead < 0 || write(dst, buf, bytesRead) != bytesRead)
+            err = CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    close(src);
+    if (dst >= 0 && close(dst) < 0)
+        err = CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+
+    if (err != CFE_SUCCESS || rename(tmpPath, stagedPath) < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to stage overlay %s into %s",
+                          reprogramJob.overlay, FPGA_CTRL_FIRMWARE_DIR);
+        unlink(tmpPath);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Replaces whatever overlay the region had with overlayName. Writing its path makes the kernel apply it, which
+// programs the partial bitstream it names through the region's FPGA bridge and manager before the write returns.
+static int32 FPGA_CTRL_ApplyOverlay(uint32 const region, char const *const overlayName)
+{
+    char  dir[128];
+    char  attrPath[sizeof(dir) + 8];
+    char  status[32];
+    int32 err;
+
+    FPGA_CTRL_RemoveOverlay(region);
+
+    FPGA_CTRL_OverlayDir(region, dir, sizeof(dir));
+    if (mkdir(dir, 0755) < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to create overlay %s: %s", dir,
+                          strerror(errno));
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    snprintf(attrPath, sizeof(attrPath), "%s/path", dir);
+#ifdef FPGA_MGR_TEST
+    // configfs creates the attributes along with the directory
+    close(open(attrPath, O_WRONLY | O_CREAT, 0644));
+#endif
+    if ((err = FPGA_CTRL_WriteAttr(attrPath, overlayName)) != CFE_SUCCESS)
+        return err;
+
+#ifdef FPGA_MGR_TEST
+    FPGA_CTRL_FakeOverlayApply(dir);
+#endif
+
+    snprintf(attrPath, sizeof(attrPath), "%s/status", dir);
+    if ((err = FPGA_CTRL_ReadAttr(attrPath, status, sizeof(status))) != CFE_SUCCESS)
+        return err;
+
+    if (strcmp(status, "applied") != 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Overlay %s is '%s' in region %u",
+                          overlayName, status, (unsigned int)region);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Removing the overlay directory unapplies it, which frees the region. Nothing to do if the region is empty.
+static void FPGA_CTRL_RemoveOverlay(uint32 const region)
+{
+    char dir[128];
+    FPGA_CTRL_OverlayDir(region, dir, sizeof(dir));
+
+#ifdef FPGA_MGR_TEST
+    // configfs takes the attributes with the directory, a real directory needs them gone first
+    char attrPath[sizeof(dir) + 8];
+    snprintf(attrPath, sizeof(attrPath), "%s/path", dir);
+    unlink(attrPath);
+    snprintf(attrPath, sizeof(attrPath), "%s/status", dir);
+    unlink(attrPath);
+#endif
+
+    if (rmdir(dir) < 0 && errno != ENOENT)
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to remove overlay %s: %s", dir,
+                          strerror(errno));
+}
+
+static void FPGA_CTRL_OverlayDir(uint32 const region, char *const dir, size_t const size)
+{
+    snprintf(dir, size, "%s/fpga_ctrl_region%u", FPGA_CTRL_OVERLAY_DIR, (unsigned int)region);
+}
+
+// Sends FPGA_CTRL_REGION_SCHED_CC to our own command pipe
+static void FPGA_CTRL_PokeMainTask(void)
+{
+    static FPGA_CTRL_RegionSchedCmd_t cmd;
+
+    CFE_MSG_Init(&cmd.CmdHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_CMD_MID), sizeof(cmd));
+    CFE_MSG_SetFcnCode(&cmd.CmdHeader.Msg, FPGA_CTRL_REGION_SCHED_CC);
+    CFE_SB_TransmitMsg(&cmd.CmdHeader.Msg, true);
+}
+
+static int32 FPGA_CTRL_WriteSysfsAttr(char const *const attr, char const *const value)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", FPGA_CTRL_FPGA_MGR_DIR, attr);
+    return FPGA_CTRL_WriteAttr(path, value);
+}
+
+// Reads a sysfs attribute with the trailing newline stripped
+static int32 FPGA_CTRL_ReadSysfsAttr(char const *const attr, char *const value, size_t const size)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", FPGA_CTRL_FPGA_MGR_DIR, attr);
+    return FPGA_CTRL_ReadAttr(path, value, size);
+}
+
+static int32 FPGA_CTRL_WriteAttr(char const *const path, char const *const value)
+{
+    int const fd = open(path, O_WRONLY | O_TRUNC);
+    if (fd < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to open %s: %s", path,
+                          strerror(errno));
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    size_t const  len     = strlen(value);
+    ssize_t const written = write(fd, value, len);
+    int const     writeErrno = errno;
+    close(fd);
+
+    if (written != (ssize_t)len)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to write '%s' to %s: %s", value,
+                          path, written < 0 ? strerror(writeErrno) : "short write");
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Reads a sysfs or configfs attribute with the trailing newline stripped
+static int32 FPGA_CTRL_ReadAttr(char const *const path, char *const value, size_t const size)
+{
+    int const fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to open %s: %s", path,
+                          strerror(errno));
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    ssize_t const bytesRead = read(fd, value, size - 1);
+    close(fd);
+    if (bytesRead < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to read %s", path);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    value[bytesRead] = '\0';
+    value[strcspn(value, "\n")] = '\0';
+    return CFE_SUCCESS;
+}
+
+#ifdef FPGA_MGR_TEST
+// Creates the fake firmware directory and manager attributes if they aren't there yet
+static int32 FPGA_CTRL_FakeFpgaMgrInit(void)
+{
+    static char const *const dirs[] = {
+        FPGA_CTRL_FAKE_SYSFS_ROOT,
+        FPGA_CTRL_FAKE_SYSFS_ROOT "/lib",
+        FPGA_CTRL_FIRMWARE_DIR,
+        FPGA_CTRL_FAKE_SYSFS_ROOT "/sys",
+        FPGA_CTRL_FAKE_SYSFS_ROOT "/sys/class",
+        FPGA_CTRL_FAKE_SYSFS_ROOT "/sys/class/fpga_manager",
+        FPGA_CTRL_FPGA_MGR_DIR,
+        FPGA_CTRL_FAKE_SYSFS_ROOT "/sys/kernel",
+        FPGA_CTRL_FAKE_SYSFS_ROOT "/sys/kernel/config",
+        FPGA_CTRL_FAKE_SYSFS_ROOT "/sys/kernel/config/device-tree",
+        FPGA_CTRL_OVERLAY_DIR,
+    };
+
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); ++i)
+    {
+        if (mkdir(dirs[i], 0755) < 0 && errno != EEXIST)
+        {
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to create %s: %s", dirs[i],
+                              strerror(errno));
+            return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+        }
+    }
+
+    static char const *const attrs[][2] = {
+        {"name", "Fake FPGA Manager\n"},
+        {"state", "operating\n"},
+        {"flags", "0\n"},
+        {"firmware", ""},
+    };
+
+    for (size_t i = 0; i < sizeof(attrs) / sizeof(attrs[0]); ++i)
+    {
+        char path[128];
+        snprintf(path, sizeof(path), "%s/%s", FPGA_CTRL_FPGA_MGR_DIR, attrs[i][0]);
+
+        int const fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (fd < 0)
+            continue; // Already there from an earlier load
+        if (write(fd, attrs[i][1], strlen(attrs[i][1])) < 0)
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to write %s", path);
+        close(fd);
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Does what the kernel driver does when firmware is written: looks the name up in the firmware directory and moves
+// the state to operating, or to a firmware request error if it isn't there
+static void FPGA_CTRL_FakeFpgaMgrProgram(void)
+{
+    char firmwareName[128];
+    char firmwarePath[256];
+
+    if (FPGA_CTRL_ReadSysfsAttr("firmware", firmwareName, sizeof(firmwareName)) != CFE_SUCCESS)
+        return;
+
+    snprintf(firmwarePath, sizeof(firmwarePath), "%s/%s", FPGA_CTRL_FIRMWARE_DIR, firmwareName);
+
+    struct stat firmwareStat;
+    bool const  found = stat(firmwarePath, &firmwareStat) == 0 && firmwareStat.st_size > 0;
+
+    FPGA_CTRL_WriteSysfsAttr("state", found ? "write\n" : "firmware request error\n");
+    if (found)
+        FPGA_CTRL_WriteSysfsAttr("state", "operating\n");
+}
+// What configfs does when an overlay's path is written: looks it up in the firmware directory and reports it applied,
+// standing in for the kernel programming the region
+static void FPGA_CTRL_FakeOverlayApply(char const *const dir)
+{
+    char attrPath[256];
+    char overlayName[128];
+    char overlayPath[256];
+
+    snprintf(attrPath, sizeof(attrPath), "%s/path", dir);
+    if (FPGA_CTRL_ReadAttr(attrPath, overlayName, sizeof(overlayName)) != CFE_SUCCESS)
+        return;
+
+    snprintf(overlayPath, sizeof(overlayPath), "%s/%s", FPGA_CTRL_FIRMWARE_DIR, overlayName);
+
+    struct stat overlayStat;
+    bool const  found = stat(overlayPath, &overlayStat) == 0 && overlayStat.st_size > 0;
+
+    snprintf(attrPath, sizeof(attrPath), "%s/status", dir);
+    int const fd = open(attrPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return;
+    char const *const status = found ? "applied\n" : "unapplied\n";
+    if (write(fd, status, strlen(status)) < 0)
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to write %s", attrPath);
+    close(fd);
+}
+#endif
@@ -0,0 +1,383 @@
+// Streaming decoder for LZ4 frames (the format written by the lz4 command line tool), used for compressed
+// bitstreams. Decodes one block at a time into a window of the previous 64 KB plus one block, so memory stays bounded
+// by the frame's block size no matter how large the image is. Checksums use xxHash32 as the format specifies.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+
+#define FPGA_CTRL_LZ4_MAGIC       0x184D2204u
+#define FPGA_CTRL_LZ4_WINDOW_SIZE (64 * 1024) // Furthest back a match can reach
+
+// FLG byte of the frame descriptor
+#define FPGA_CTRL_LZ4_FLG_VERSION_MASK   0xC0
+#define FPGA_CTRL_LZ4_FLG_VERSION        0x40
+#define FPGA_CTRL_LZ4_FLG_BLOCK_INDEP    0x20
+#define FPGA_CTRL_LZ4_FLG_BLOCK_CHKSUM   0x10
+#define FPGA_CTRL_LZ4_FLG_CONTENT_SIZE   0x08
+#define FPGA_CTRL_LZ4_FLG_CONTENT_CHKSUM 0x04
+#define FPGA_CTRL_LZ4_FLG_DICT_ID        0x01
+#define FPGA_CTRL_LZ4_FLG_RESERVED       0x02
+
+// BD byte, bits 6-4 are the block maximum size id
+#define FPGA_CTRL_LZ4_BD_RESERVED 0x8F
+
+#define FPGA_CTRL_LZ4_BLOCK_UNCOMPRESSED 0x80000000u // Set in a block size when the block is stored as is
+
+#define FPGA_CTRL_XXH32_PRIME1 0x9E3779B1u
+#define FPGA_CTRL_XXH32_PRIME2 0x85EBCA77u
+#define FPGA_CTRL_XXH32_PRIME3 0xC2B2AE3Du
+#define FPGA_CTRL_XXH32_PRIME4 0x27D4EB2Fu
+#define FPGA_CTRL_XXH32_PRIME5 0x165667B1u
+
+// Receives decompressed data in order
+typedef int32 (*FPGA_CTRL_Lz4Sink_t)(void *ctx, void const *data, size_t len);
+
+// Incremental xxHash32
+typedef struct
+{
+    uint32 acc[4];
+    uint8  buf[16];
+    uint32 bufLen;
+    uint64 totalLen;
+    uint32 seed;
+} FPGA_CTRL_Xxh32_t;
+
+// Exported functions
+bool   FPGA_CTRL_Lz4IsFrame(uint8 const *data, size_t size);
+uint64 FPGA_CTRL_Lz4ContentSize(uint8 const *data, size_t size);
+int32  FPGA_CTRL_Lz4Decompress(uint8 const *data, size_t size, FPGA_CTRL_Lz4Sink_t sink, void *ctx, uint64 *rawSize);
+
+static int32  FPGA_CTRL_Lz4DecodeBlock(uint8 const *src, size_t srcLen, uint8 *window, size_t histLen,
+                                       size_t blockMax, size_t *outLen);
+static uint32 FPGA_CTRL_ReadLe32(uint8 const *p);
+static void   FPGA_CTRL_Xxh32Init(FPGA_CTRL_Xxh32_t *state, uint32 seed);
+static void   FPGA_CTRL_Xxh32Update(FPGA_CTRL_Xxh32_t *state, uint8 const *data, size_t len);
+static uint32 FPGA_CTRL_Xxh32Digest(FPGA_CTRL_Xxh32_t const *state);
+static uint32 FPGA_CTRL_Xxh32(uint8 const *data, size_t len);
+
+bool FPGA_CTRL_Lz4IsFrame(uint8 const *const data, size_t const size)
+{
+    return size >= 4 && FPGA_CTRL_ReadLe32(data) == FPGA_CTRL_LZ4_MAGIC;
+}
+
+// Decompressed size from the frame header, 0 if the frame doesn't record it
+uint64 FPGA_CTRL_Lz4ContentSize(uint8 const *const data, size_t const size)
+{
+    if (!FPGA_CTRL_Lz4IsFrame(data, size) || size < 15 || !(data[4] & FPGA_CTRL_LZ4_FLG_CONTENT_SIZE))
+        return 0;
+
+    return (uint64)FPGA_CTRL_ReadLe32(data + 6) | ((uint64)FPGA_CTRL_ReadLe32(data + 10) << 32);
+}
+
+// Decodes a single LZ4 frame from memory, passing each decoded block to sink. Every length and offset is checked
+// against the input and window, so a corrupt image fails cleanly rather than overrunning. A frame with reserved
+// descriptor bits set is from a format revision this decoder doesn't know and is refused. A sink failure ends the
+// decode with the sink's status, reported as such rather than as a corrupt frame.
+int32 FPGA_CTRL_Lz4Decompress(uint8 const *const data, size_t const size, FPGA_CTRL_Lz4Sink_t const sink,
+                              void *const ctx, uint64 *const rawSize)
+{
+    *rawSize = 0;
+
+    if (!FPGA_CTRL_Lz4IsFrame(data, size) || size < 7)
+        return CFE_STATUS_VALIDATION_FAILURE;
+
+    uint8 const flg = data[4];
+    uint8 const bd  = data[5];
+    if ((flg & FPGA_CTRL_LZ4_FLG_VERSION_MASK) != FPGA_CTRL_LZ4_FLG_VERSION || (flg & FPGA_CTRL_LZ4_FLG_DICT_ID))
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Unsupported LZ4 frame version or dictionary, FLG = 0x%02x", flg);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+    if ((flg & FPGA_CTRL_LZ4_FLG_RESERVED) || (bd & FPGA_CTRL_LZ4_BD_RESERVED))
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Reserved bits set in LZ4 frame descriptor, FLG = 0x%02x, BD = 0x%02x", flg, bd);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    uint32 const blockMaxId = (bd >> 4) & 0x7;
+    if (blockMaxId < 4)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Invalid LZ4 block size, BD = 0x%02x", bd);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+    size_t const blockMax = (size_t)1 << (8 + 2 * blockMaxId); // 64 KB, 256 KB, 1 MB or 4 MB
+
+    size_t const descLen = 2 + ((flg & FPGA_CTRL_LZ4_FLG_CONTENT_SIZE) ? 8 : 0);
+    if (size < 4 + descLen + 1 || data[4 + descLen] != ((FPGA_CTRL_Xxh32(data + 4, descLen) >> 8) & 0xFF))
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: LZ4 header checksum mismatch");
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    // Linked blocks can reach back into the previous 64 KB, independent ones can't
+    bool const   linked    = !(flg & FPGA_CTRL_LZ4_FLG_BLOCK_INDEP);
+    size_t const windowLen = (linked ? FPGA_CTRL_LZ4_WINDOW_SIZE : 0) + blockMax;
+    uint8 *const window    = malloc(windowLen);
+    if (window == NULL)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Can't allocate %u bytes for LZ4 decoding", (unsigned int)windowLen);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    FPGA_CTRL_Xxh32_t contentHash;
+    FPGA_CTRL_Xxh32Init(&contentHash, 0);
+
+    size_t pos        = 4 + descLen + 1;
+    size_t histLen    = 0;
+    int32  err        = CFE_STATUS_VALIDATION_FAILURE;
+    bool   sinkFailed = false;
+    for (;;)
+    {
+        if (size - pos < 4)
+            break;
+        uint32 const blockWord = FPGA_CTRL_ReadLe32(data + pos);
+        pos += 4;
+
+        if (blockWord == 0)
+        {
+            // End mark, optionally followed by the content checksum
+            if (flg & FPGA_CTRL_LZ4_FLG_CONTENT_CHKSUM)
+            {
+                if (size - pos < 4 || FPGA_CTRL_ReadLe32(data + pos) != FPGA_CTRL_Xxh32Digest(&contentHash))
+                    break;
+                pos += 4;
+            }
+            err = CFE_SUCCESS;
+            break;
+        }
+
+        size_t const blockLen = blockWord & ~FPGA_CTRL_LZ4_BLOCK_UNCOMPRESSED;
+        size_t const chkLen   = (flg & FPGA_CTRL_LZ4_FLG_BLOCK_CHKSUM) ? 4 : 0;
+        if (blockLen > blockMax || size - pos < blockLen + chkLen)
+            break;
+        if (chkLen != 0 && FPGA_CTRL_ReadLe32(data + pos + blockLen) != FPGA_CTRL_Xxh32(data + pos, blockLen))
+            break;
+
+        size_t outLen;
+        if (blockWord & FPGA_CTRL_LZ4_BLOCK_UNCOMPRESSED)
+        {
+            memcpy(window + histLen, data + pos, blockLen);
+            outLen = blockLen;
+        }
+        else if (FPGA_CTRL_Lz4DecodeBlock(data + pos, blockLen, window, histLen, blockMax, &outLen) != CFE_SUCCESS)
+        {
+            break;
+        }
+        pos += blockLen + chkLen;
+
+        if (flg & FPGA_CTRL_LZ4_FLG_CONTENT_CHKSUM)
+            FPGA_CTRL_Xxh32Update(&contentHash, window + histLen, outLen);
+        if ((err = sink(ctx, window + histLen, outLen)) != CFE_SUCCESS)
+        {
+            sinkFailed = true;
+            break;
+        }
+        err = CFE_STATUS_VALIDATION_FAILURE;
+        *rawSize += outLen;
+
+        // Keep the last 64 KB as history for the next block
+        if (linked)
+        {
+            size_t const total = histLen + outLen;
+            size_t const keep  = total < FPGA_CTRL_LZ4_WINDOW_SIZE ? total : FPGA_CTRL_LZ4_WINDOW_SIZE;
+            memmove(window, window + total - keep, keep);
+            histLen = keep;
+        }
+    }
+
+    free(window);
+
+    if (err == CFE_SUCCESS && (flg & FPGA_CTRL_LZ4_FLG_CONTENT_SIZE) &&
+        *rawSize != FPGA_CTRL_Lz4ContentSize(data, size))
+    {
+        err = CFE_STATUS_VALIDATION_FAILURE;
+    }
+    if (sinkFailed)
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: LZ4 output not taken after %u bytes: 0x%08x", (unsigned int)*rawSize,
+                          (unsigned int)err);
+    else if (err == CFE_STATUS_VALIDATION_FAILURE)
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Corrupt LZ4 frame near offset %u", (unsigned int)pos);
+
+    return err;
+}
+
+// Decodes one compressed block into window[histLen..histLen + blockMax), matches may reach back into the history
+static int32 FPGA_CTRL_Lz4DecodeBlock(uint8 const *src, size_t const srcLen, uint8 *const window, size_t const histLen,
+                                      size_t const blockMax, size_t *const outLen)
+{
+    uint8 const *const srcEnd = src + srcLen;
+    uint8 *const       outBeg = window + histLen;
+    uint8 *const       outEnd = outBeg + blockMax;
+    uint8             *out    = outBeg;
+
+    while (src < srcEnd)
+    {
+        uint8 const token  = *src++;
+        size_t      litLen = token >> 4;
+        if (litLen == 15)
+        {
+            uint8 b;
+            do
+            {
+                if (src >= srcEnd)
+                    return CFE_STATUS_VALIDATION_FAILURE;
+                b = *src++;
+                litLen += b;
+            } while (b == 255);
+        }
+
+        if ((size_t)(srcEnd - src) < litLen || (size_t)(outEnd - out) < litLen)
+            return CFE_STATUS_VALIDATION_FAILURE;
+        memcpy(out, src, litLen);
+        src += litLen;
+        out += litLen;
+
+        // The last sequence is literals only
+        if (src == srcEnd)
+            break;
+
+        if (srcEnd - src < 2)
+            return CFE_STATUS_VALIDATION_FAILURE;
+        size_t const offset = (size_t)src[0] | ((size_t)src[1] << 8);
+        src += 2;
+        if (offset == 0 || offset > (size_t)(out - window))
+            return CFE_STATUS_VALIDATION_FAILURE;
+
+        size_t matchLen = token & 0xF;
+        if (matchLen == 15)
+        {
+            uint8 b;
+            do
+            {
+                if (src >= srcEnd)
+                    return CFE_STATUS_VALIDATION_FAILURE;
+                b = *src++;
+                matchLen += b;
+            } while (b == 255);
+        }
+        matchLen += 4;
+
+        if ((size_t)(outEnd - out) < matchLen)
+            return CFE_STATUS_VALIDATION_FAILURE;
+
+        // Matches may overlap their own output (runs), so copy forwards a byte at a time when they do
+        uint8 const *match = out - offset;
+        if (offset >= matchLen)
+        {
+            memcpy(out, match, matchLen);
+            out += matchLen;
+        }
+        else
+        {
+            while (matchLen-- > 0)
+                *out++ = *match++;
+        }
+    }
+
+    *outLen = (size_t)(out - outBeg);
+    return CFE_SUCCESS;
+}
+
+static uint32 FPGA_CTRL_ReadLe32(uint8 const *const p)
+{
+    return (uint32)p[0] | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static uint32 FPGA_CTRL_Rotl32(uint32 const x, int const r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+static uint32 FPGA_CTRL_Xxh32Round(uint32 acc, uint32 const input)
+{
+    acc += input * FPGA_CTRL_XXH32_PRIME2;
+    acc = FPGA_CTRL_Rotl32(acc, 13);
+    return acc * FPGA_CTRL_XXH32_PRIME1;
+}
+
+static void FPGA_CTRL_Xxh32Init(FPGA_CTRL_Xxh32_t *const state, uint32 const seed)
+{
+    memset(state, 0, sizeof(*state));
+    state->seed   = seed;
+    state->acc[0] = seed + FPGA_CTRL_XXH32_PRIME1 + FPGA_CTRL_XXH32_PRIME2;
+    state->acc[1] = seed + FPGA_CTRL_XXH32_PRIME2;
+    state->acc[2] = seed;
+    state->acc[3] = seed - FPGA_CTRL_XXH32_PRIME1;
+}
+
+static void FPGA_CTRL_Xxh32Update(FPGA_CTRL_Xxh32_t *const state, uint8 const *data, size_t len)
+{
+    state->totalLen += len;
+
+    if (state->bufLen + len < 16)
+    {
+        memcpy(state->buf + state->bufLen, data, len);
+        state->bufLen += (uint32)len;
+        return;
+    }
+
+    if (state->bufLen > 0)
+    {
+        size_t const fill = 16 - state->bufLen;
+        memcpy(state->buf + state->bufLen, data, fill);
+        for (int i = 0; i < 4; ++i)
+            state->acc[i] = FPGA_CTRL_Xxh32Round(state->acc[i], FPGA_CTRL_ReadLe32(state->buf + 4 * i));
+        data += fill;
+        len -= fill;
+        state->bufLen = 0;
+    }
+
+    while (len >= 16)
+    {
+        for (int i = 0; i < 4; ++i)
+            state->acc[i] = FPGA_CTRL_Xxh32Round(state->acc[i], FPGA_CTRL_ReadLe32(data + 4 * i));
+        data += 16;
+        len -= 16;
+    }
+
+    memcpy(state->buf, data, len);
+    state->bufLen = (uint32)len;
+}
+
+static uint32 FPGA_CTRL_Xxh32Digest(FPGA_CTRL_Xxh32_t const *const state)
+{
+    uint32 h;
+    if (state->totalLen >= 16)
+        h = FPGA_CTRL_Rotl32(state->acc[0], 1) + FPGA_CTRL_Rotl32(state->acc[1], 7) +
+            FPGA_CTRL_Rotl32(state->acc[2], 12) + FPGA_CTRL_Rotl32(state->acc[3], 18);
+    else
+        h = state->seed + FPGA_CTRL_XXH32_PRIME5;
+
+    h += (uint32)state->totalLen;
+
+    uint8 const *p   = state->buf;
+    uint8 const *end = state->buf + state->bufLen;
+    for (; end - p >= 4; p += 4)
+        h = FPGA_CTRL_Rotl32(h + FPGA_CTRL_ReadLe32(p) * FPGA_CTRL_XXH32_PRIME3, 17) * FPGA_CTRL_XXH32_PRIME4;
+    for (; p < end; ++p)
+        h = FPGA_CTRL_Rotl32(h + *p * FPGA_CTRL_XXH32_PRIME5, 11) * FPGA_CTRL_XXH32_PRIME1;
+
+    h ^= h >> 15;
+    h *= FPGA_CTRL_XXH32_PRIME2;
+    h ^= h >> 13;
+    h *= FPGA_CTRL_XXH32_PRIME3;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint32 FPGA_CTRL_Xxh32(uint8 const *const data, size_t const len)
+{
+    FPGA_CTRL_Xxh32_t state;
+    FPGA_CTRL_Xxh32Init(&state, 0);
+    FPGA_CTRL_Xxh32Update(&state, data, len);
+    return FPGA_CTRL_Xxh32Digest(&state);
+}
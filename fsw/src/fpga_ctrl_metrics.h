@@ -0,0 +1,251 @@
+// Counters, gauges and histograms exported to a local file in the Prometheus text exposition format, for a sidecar
+// (node_exporter's textfile collector, or anything that reads the format) to scrape. A rate group item writes the
+// whole set every MetricsPeriodMs to <MetricsPath>.tmp and renames it over MetricsPath, so a reader always sees one
+// complete export and never a file being written. The temporary file sits next to the real one, the rename is only
+// atomic within a filesystem. An empty MetricsPath in the table turns exporting off, and is the default.
+// Exporting is a rate group item registered in fpga_ctrl.c, so it only runs when the scheduler sends
+// FPGA_CTRL_WAKEUP_MID. Without a scheduler table entry for that MID no file is ever written, whatever the period.
+// The hot paths only keep the counters and histograms they already have, everything is formatted here on the main
+// task's wakeup. Runs on the main task only.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+#include "fpga_ctrl_table.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_METRICS_BUCKETS  16 // Bucket n counts values under 2^n, the last everything from 2^14
+#define FPGA_CTRL_METRICS_LINE_LEN 256
+#define FPGA_CTRL_METRICS_BUF_LEN  4096 // Written out in chunks of this, not a write per line
+
+// Log2 histogram, kept by whatever measures and written out as a Prometheus histogram
+typedef struct
+{
+    uint32 buckets[FPGA_CTRL_METRICS_BUCKETS];
+    uint64 sum;
+} FPGA_CTRL_MetricsHist_t;
+
+// An export being written
+typedef struct
+{
+    osal_id_t fileId;
+    int32     status; // First write error, the export isn't published if set
+    uint32    used;   // Bytes in buf not yet written
+    char      buf[FPGA_CTRL_METRICS_BUF_LEN];
+    char      tmpPath[FPGA_CTRL_METRICS_PATH_LEN + 4];
+} FPGA_CTRL_MetricsFile_t;
+
+static struct
+{
+    char   path[FPGA_CTRL_METRICS_PATH_LEN]; // From the table, empty when exporting is off
+    uint32 periodMs;
+    int64  lastNs;   // When the last export was started
+    uint32 exports;
+    uint32 failures;
+    bool   failing;  // Reported the current run of failures already
+} metricsState;
+
+// Exported functions
+void  FPGA_CTRL_LoadMetricsConfig(void);
+void  FPGA_CTRL_MetricsObserve(FPGA_CTRL_MetricsHist_t *hist, uint32 value);
+bool  FPGA_CTRL_MetricsDue(void);
+int32 FPGA_CTRL_MetricsOpen(FPGA_CTRL_MetricsFile_t *file);
+void  FPGA_CTRL_MetricsFamily(FPGA_CTRL_MetricsFile_t *file, char const *name, char const *type, char const *help);
+void  FPGA_CTRL_MetricsSample(FPGA_CTRL_MetricsFile_t *file, char const *name, char const *labels, uint64 value);
+void  FPGA_CTRL_MetricsValue(FPGA_CTRL_MetricsFile_t *file, char const *name, char const *type, char const *help,
+                             uint64 value);
+void  FPGA_CTRL_MetricsHistogram(FPGA_CTRL_MetricsFile_t *file, char const *name, char const *labels,
+                                 uint32 const *buckets, uint32 bucketCount, uint64 sum);
+int32 FPGA_CTRL_MetricsPublish(FPGA_CTRL_MetricsFile_t *file);
+
+static void FPGA_CTRL_MetricsPrintf(FPGA_CTRL_MetricsFile_t *file, char const *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+static void FPGA_CTRL_MetricsFlush(FPGA_CTRL_MetricsFile_t *file);
+static void FPGA_CTRL_MetricsFailed(char const *what, int32 status);
+
+// Copies the export settings out of the table, at startup and after each table update. Moving or turning off the
+// export removes the old file, so nothing goes on scraping numbers that have stopped changing.
+void FPGA_CTRL_LoadMetricsConfig(void)
+{
+    FPGA_CTRL_Table_t *tblPtr;
+
+    if (CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0]) < CFE_SUCCESS)
+        return;
+
+    if (strncmp(metricsState.path, tblPtr->MetricsPath, sizeof(metricsState.path)) != 0)
+    {
+        if (metricsState.path[0] != '\0')
+            OS_remove(metricsState.path);
+
+        memcpy(metricsState.path, tblPtr->MetricsPath, sizeof(metricsState.path));
+        metricsState.path[sizeof(metricsState.path) - 1] = '\0';
+        metricsState.failing                             = false;
+    }
+    metricsState.periodMs = tblPtr->MetricsPeriodMs;
+
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+}
+
+// Counts a value into the histogram, the caller keeps it to a single task
+void FPGA_CTRL_MetricsObserve(FPGA_CTRL_MetricsHist_t *const hist, uint32 const value)
+{
+    uint32 const bucket = value == 0 ? 0 : 32 - __builtin_clz(value);
+
+    ++hist->buckets[bucket < FPGA_CTRL_METRICS_BUCKETS ? bucket : FPGA_CTRL_METRICS_BUCKETS - 1];
+    hist->sum += value;
+}
+
+// Whether exporting is on and a period has gone by since the last export, which is then taken to have started
+bool FPGA_CTRL_MetricsDue(void)
+{
+    int64 const nowNs = FPGA_CTRL_MonotonicNs();
+
+    if (metricsState.path[0] == '\0' ||
+        (metricsState.lastNs != 0 && nowNs - metricsState.lastNs < (int64)metricsState.periodMs * 1000000LL))
+    {
+        return false;
+    }
+
+    metricsState.lastNs = nowNs;
+    return true;
+}
+
+// Starts an export in the temporary file
+int32 FPGA_CTRL_MetricsOpen(FPGA_CTRL_MetricsFile_t *const file)
+{
+    snprintf(file->tmpPath, sizeof(file->tmpPath), "%s.tmp", metricsState.path);
+    file->used   = 0;
+    file->status = OS_OpenCreate(&file->fileId, file->tmpPath, OS_FILE_FLAG_CREATE | OS_FILE_FLAG_TRUNCATE,
+                                 OS_WRITE_ONLY);
+    if (file->status != OS_SUCCESS)
+    {
+        FPGA_CTRL_MetricsFailed("open", file->status);
+        return file->status;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// HELP and TYPE lines of a metric, ahead of its samples
+void FPGA_CTRL_MetricsFamily(FPGA_CTRL_MetricsFile_t *const file, char const *const name, char const *const type,
+                             char const *const help)
+{
+    FPGA_CTRL_MetricsPrintf(file, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// One sample, labels is the part between the braces or NULL
+void FPGA_CTRL_MetricsSample(FPGA_CTRL_MetricsFile_t *const file, char const *const name, char const *const labels,
+                             uint64 const value)
+{
+    if (labels != NULL)
+        FPGA_CTRL_MetricsPrintf(file, "%s{%s} %llu\n", name, labels, (unsigned long long)value);
+    else
+        FPGA_CTRL_MetricsPrintf(file, "%s %llu\n", name, (unsigned long long)value);
+}
+
+// A metric with a single unlabelled sample
+void FPGA_CTRL_MetricsValue(FPGA_CTRL_MetricsFile_t *const file, char const *const name, char const *const type,
+                            char const *const help, uint64 const value)
+{
+    FPGA_CTRL_MetricsFamily(file, name, type, help);
+    FPGA_CTRL_MetricsSample(file, name, NULL, value);
+}
+
+// The samples of one log2 histogram, bucket n counting integer values under 2^n and the last everything above.
+// Prometheus buckets are cumulative and inclusive, so bucket n becomes le="2^n - 1" and the last one le="+Inf".
+void FPGA_CTRL_MetricsHistogram(FPGA_CTRL_MetricsFile_t *const file, char const *const name, char const *const labels,
+                                uint32 const *const buckets, uint32 const bucketCount, uint64 const sum)
+{
+    char const *const sep   = labels != NULL ? "," : "";
+    char const *const extra = labels != NULL ? labels : "";
+    uint64            count = 0;
+
+    for (uint32 b = 0; b < bucketCount; ++b)
+    {
+        count += buckets[b];
+        if (b + 1 < bucketCount)
+            FPGA_CTRL_MetricsPrintf(file, "%s_bucket{%s%sle=\"%u\"} %llu\n", name, extra, sep, (1u << b) - 1,
+                                    (unsigned long long)count);
+        else
+            FPGA_CTRL_MetricsPrintf(file, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, extra, sep,
+                                    (unsigned long long)count);
+    }
+
+    if (labels != NULL)
+    {
+        FPGA_CTRL_MetricsPrintf(file, "%s_sum{%s} %llu\n%s_count{%s} %llu\n", name, labels, (unsigned long long)sum,
+                                name, labels, (unsigned long long)count);
+    }
+    else
+    {
+        FPGA_CTRL_MetricsPrintf(file, "%s_sum %llu\n%s_count %llu\n", name, (unsigned long long)sum, name,
+                                (unsigned long long)count);
+    }
+}
+
+// Closes the export and renames it over the published file, or drops it if anything went wrong writing it
+int32 FPGA_CTRL_MetricsPublish(FPGA_CTRL_MetricsFile_t *const file)
+{
+    FPGA_CTRL_MetricsValue(file, "fpga_ctrl_metrics_exports_total", "counter", "Metrics files published",
+                           metricsState.exports + 1);
+    FPGA_CTRL_MetricsValue(file, "fpga_ctrl_metrics_failures_total", "counter", "Metrics exports given up on",
+                           metricsState.failures);
+    FPGA_CTRL_MetricsFlush(file);
+    OS_close(file->fileId);
+
+    if (file->status == CFE_SUCCESS && (file->status = OS_rename(file->tmpPath, metricsState.path)) == OS_SUCCESS)
+    {
+        ++metricsState.exports;
+        metricsState.failing = false;
+        return CFE_SUCCESS;
+    }
+
+    OS_remove(file->tmpPath);
+    FPGA_CTRL_MetricsFailed("write", file->status);
+    return file->status;
+}
+
+// Formats a line into the export's buffer, nothing more is written after the first failure
+static void FPGA_CTRL_MetricsPrintf(FPGA_CTRL_MetricsFile_t *const file, char const *const fmt, ...)
+{
+    va_list args;
+
+    if (file->status != CFE_SUCCESS)
+        return;
+    if (sizeof(file->buf) - file->used < FPGA_CTRL_METRICS_LINE_LEN)
+        FPGA_CTRL_MetricsFlush(file);
+
+    va_start(args, fmt);
+    int const len = vsnprintf(file->buf + file->used, FPGA_CTRL_METRICS_LINE_LEN, fmt, args);
+    va_end(args);
+
+    if (len < 0 || len >= FPGA_CTRL_METRICS_LINE_LEN)
+        file->status = CFE_STATUS_VALIDATION_FAILURE;
+    else
+        file->used += len;
+}
+
+static void FPGA_CTRL_MetricsFlush(FPGA_CTRL_MetricsFile_t *const file)
+{
+    if (file->status == CFE_SUCCESS && file->used != 0 &&
+        OS_write(file->fileId, file->buf, file->used) != (int32)file->used)
+        file->status = CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    file->used = 0;
+}
+
+// Counts a failed export, with one event per run of them rather than one per period
+static void FPGA_CTRL_MetricsFailed(char const *const what, int32 const status)
+{
+    ++metricsState.failures;
+    if (metricsState.failing)
+        return;
+
+    metricsState.failing = true;
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to %s metrics file %s: %d", what,
+                      metricsState.path, (int)status);
+}
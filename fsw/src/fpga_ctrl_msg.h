@@ -32,12 +32,22 @@
 /*
 ** SAMPLE App command codes
 */
-#define FPGA_CTRL_NOOP_CC           0 // No-op (default)
-#define FPGA_CTRL_RESET_COUNTERS_CC 1 // Reset counters (default)
-#define FPGA_CTRL_PROCESS_CC        2 // Process data (default)
-#define FPGA_CTRL_ENCRYPT_CC        3 // Perform encryption on attached data
-#define FPGA_CTRL_INT_CTRL_CC       4 // Enable or disable interrupt task
-#define FPGA_CTRL_REPROGRAM_CC      5 // Reprogram FPGA with new bitstream
+#define FPGA_CTRL_NOOP_CC            0 // No-op (default)
+#define FPGA_CTRL_RESET_COUNTERS_CC  1 // Reset counters (default)
+#define FPGA_CTRL_PROCESS_CC         2 // Process data (default)
+#define FPGA_CTRL_ENCRYPT_CC         3 // Perform encryption on attached data
+#define FPGA_CTRL_INT_CTRL_CC        4 // Enable or disable interrupt task
+#define FPGA_CTRL_REPROGRAM_CC       5 // Reprogram FPGA with new bitstream
+#define FPGA_CTRL_SAMPLING_CC        6 // Start or stop GPIO sampling acquisition
+#define FPGA_CTRL_LOADGEN_CC         7 // Start or stop the synthetic interrupt load generator
+#define FPGA_CTRL_REPROGRAM_NAMED_CC 8 // Reprogram FPGA with a bitstream from the table, through the cache
+#define FPGA_CTRL_REGION_SCHED_CC    9 // Run the region scheduler now, also sent by the app when a load finishes
+#define FPGA_CTRL_BATCH_CC           10 // Run a sequence of packed sub-commands
+#define FPGA_CTRL_TIMED_CC           11 // Queue a command to run at a given time
+#define FPGA_CTRL_PROFILE_DUMP_CC    12 // Write the command profile to a CSV file
+#define FPGA_CTRL_TRACE_CC           13 // Set the trace level, subsystems and sinks, or dump the trace ring
+
+#define FPGA_CTRL_CC_COUNT 14 // One past the highest command code, sizes the dispatch table
 
 /*************************************************************************/
 
@@ -70,6 +80,73 @@ typedef struct
     char                    path[128];
 } FPGA_CTRL_ReprogramCmd_t;
 
+// Name of a bitstream in the table
+typedef struct
+{
+    CFE_MSG_CommandHeader_t CmdHeader;
+    char                    name[16]; // FPGA_CTRL_BITSTREAM_NAME_LEN
+} FPGA_CTRL_ReprogramNamedCmd_t;
+
+// Where sampled GPIO blocks go
+#define FPGA_CTRL_SAMPLE_OUTPUT_TLM  0 // Bulk telemetry on FPGA_CTRL_SAMPLE_TLM_MID
+#define FPGA_CTRL_SAMPLE_OUTPUT_FILE 1 // Appended to the file given in path
+
+// Start or stop sampling the switch/button GPIO data registers
+typedef struct
+{
+    CFE_MSG_CommandHeader_t CmdHeader;
+    uint8                   enable; // boolean, start or stop
+    uint8                   output; // FPGA_CTRL_SAMPLE_OUTPUT_*
+    uint8                   padding[2];
+    uint32                  rateHz; // Samples per second
+    char                    path[64];
+} FPGA_CTRL_SamplingCmd_t;
+
+// Write the command profile as CSV, for offline analysis
+typedef struct
+{
+    CFE_MSG_CommandHeader_t CmdHeader;
+    uint8                   reset; // boolean, start a new profile once it's written
+    uint8                   padding[3];
+    char                    path[64];
+} FPGA_CTRL_ProfileDumpCmd_t;
+
+// Trace levels, a message is kept when its level is at or below the one set
+#define FPGA_CTRL_TRACE_OFF   0
+#define FPGA_CTRL_TRACE_ERROR 1
+#define FPGA_CTRL_TRACE_WARN  2
+#define FPGA_CTRL_TRACE_INFO  3
+#define FPGA_CTRL_TRACE_DEBUG 4
+
+// Trace subsystems, as a mask
+#define FPGA_CTRL_TRACE_AES       0x01
+#define FPGA_CTRL_TRACE_IRQ       0x02
+#define FPGA_CTRL_TRACE_BITSTREAM 0x04
+#define FPGA_CTRL_TRACE_CMD       0x08
+
+// Trace sinks, as a mask
+#define FPGA_CTRL_TRACE_CONSOLE 0x01 // OS_printf, serializes on the console
+#define FPGA_CTRL_TRACE_RING    0x02 // In-memory ring, written out by FPGA_CTRL_TRACE_CC
+
+// Only accepted in builds with tracing compiled in (FPGA_CTRL_TRACE_LEVEL)
+typedef struct
+{
+    CFE_MSG_CommandHeader_t CmdHeader;
+    uint8                   level;      // FPGA_CTRL_TRACE_*, capped at the level compiled in
+    uint8                   sinks;      // FPGA_CTRL_TRACE_CONSOLE | FPGA_CTRL_TRACE_RING
+    uint16                  subsystems; // FPGA_CTRL_TRACE_AES | ...
+    char                    path[64];   // If set, the ring is written here as text and the settings are left alone
+} FPGA_CTRL_TraceCmd_t;
+
+// Drives the fake interrupt source, only accepted in FPGA_INTERRUPTS_TEST builds
+typedef struct
+{
+    CFE_MSG_CommandHeader_t CmdHeader;
+    uint32                  rateHz;     // Average events per second, 1 to 100000
+    uint32                  burstLen;   // Events raised back to back per burst, 1 spaces them evenly
+    uint32                  durationMs; // Length of the run, 0 stops a running generator
+} FPGA_CTRL_LoadGenCmd_t;
+
 // enum BitstreamCode
 // {
 //     AesEncryptCode = 0,
@@ -86,19 +163,110 @@ typedef struct
 typedef FPGA_CTRL_NoArgsCmd_t FPGA_CTRL_NoopCmd_t;
 typedef FPGA_CTRL_NoArgsCmd_t FPGA_CTRL_ResetCountersCmd_t;
 typedef FPGA_CTRL_NoArgsCmd_t FPGA_CTRL_ProcessCmd_t;
+typedef FPGA_CTRL_NoArgsCmd_t FPGA_CTRL_RegionSchedCmd_t;
+
+#define FPGA_CTRL_BATCH_MAX_ITEMS 32 // One bit each in the result bitmap
+#define FPGA_CTRL_BATCH_MAX_BYTES 1024
+
+// Sub-command in a batch, followed by its payload: the command without its CCSDS command header
+typedef struct
+{
+    uint8  fcnCode;
+    uint8  padding;
+    uint16 length; // Payload bytes, the next item starts at the following 4 byte boundary
+} FPGA_CTRL_BatchItemHeader_t;
+
+// Sub-commands run in order in one wakeup, each through the same checks as if it had been sent on its own. The
+// command is variable length, sent with only as many item bytes as it uses.
+typedef struct
+{
+    CFE_MSG_CommandHeader_t CmdHeader;
+    uint16                  sequence;    // Echoed in the result so scripts can match it
+    uint8                   itemCount;   // At most FPGA_CTRL_BATCH_MAX_ITEMS
+    uint8                   stopOnError; // boolean, skip the rest after the first failure
+    uint8                   items[FPGA_CTRL_BATCH_MAX_BYTES];
+} FPGA_CTRL_BatchCmd_t;
+
+#define FPGA_CTRL_TIMED_MAX_PAYLOAD 128
+
+// Command to run once the spacecraft time reaches the tag. The command is variable length, sent with only as many
+// payload bytes as it uses.
+typedef struct
+{
+    CFE_MSG_CommandHeader_t CmdHeader;
+    uint32                  seconds;    // CFE time tag
+    uint32                  subseconds; // 2^-32 seconds
+    uint8                   fcnCode;
+    uint8                   padding;
+    uint16                  length; // Payload bytes: the command without its CCSDS command header
+    uint8                   payload[FPGA_CTRL_TIMED_MAX_PAYLOAD];
+} FPGA_CTRL_TimedCmd_t;
 
 /*************************************************************************/
 /*
 ** Type definition (SAMPLE App housekeeping)
 */
 
+// Reprogramming states, reported in fabricState
+#define FPGA_CTRL_FABRIC_READY       0 // Programmed and usable
+#define FPGA_CTRL_FABRIC_STAGING     1 // Copying the bitstream into the firmware directory
+#define FPGA_CTRL_FABRIC_VERIFYING   2 // Checking the staged image
+#define FPGA_CTRL_FABRIC_PROGRAMMING 3 // FPGA manager writing the fabric, accelerators unavailable
+#define FPGA_CTRL_FABRIC_REMAPPING   4 // Reopening the interrupt device and GPIO mappings
+#define FPGA_CTRL_FABRIC_FAILED      5 // Last load failed, see fabricUp for whether the old design survived
+
+// Interrupt child task servicing modes, reported in irqMode
+#define FPGA_CTRL_IRQ_MODE_INTERRUPT 0 // Blocking on the UIO device for GPIO interrupts
+#define FPGA_CTRL_IRQ_MODE_POLL      1 // IER masked, busy-polling the GPIO data register
+
 typedef struct
 {
-    uint8 CommandCounter;
-    uint8 CommandErrorCounter;
-    char  cyphertextHexString[16 * 2 + 1];
-    uint8 childTaskRunning; // boolean
-    // uint8 padding[1];
+    uint8  CommandCounter;
+    uint8  CommandErrorCounter;
+    char   cyphertextHexString[16 * 2 + 1];
+    uint8  interruptsEnabled; // boolean
+    uint8  irqMode;          // FPGA_CTRL_IRQ_MODE_*
+    uint8  padding[3];
+    uint32 irqEventCount;       // GPIO events handled in either mode
+    uint32 irqModeTransitions;  // Interrupt <-> poll mode switches
+    uint32 irqInterruptModeMs;  // Time spent in interrupt mode
+    uint32 irqPollModeMs;       // Time spent in poll mode
+    uint8  samplingActive;      // boolean
+    uint8  fabricState;         // FPGA_CTRL_FABRIC_*
+    uint8  padding2[2];
+    uint32 samplesTaken;        // GPIO samples stored since sampling started
+    uint32 samplesDropped;      // Sample periods missed or with no free block
+    uint32 sampleBlocks;        // Sample blocks sent or written
+    uint32 bitstreamStageMs;    // Last successful load, copying into the firmware directory
+    uint32 bitstreamProgramMs;  // Last successful load, FPGA manager programming the fabric
+    uint32 bitstreamVerifyMs;   // Last successful load, checking the staged image
+    uint32 bitstreamRemapMs;    // Last successful load, reopening the interrupt device
+    uint32 fabricDowntimeMs;    // Last successful load, time accelerator commands were refused
+    uint32 bitstreamCacheHits;
+    uint32 bitstreamCacheMisses;
+    uint32 bitstreamCacheBytes;   // Memory held by cached bitstreams
+    uint32 bitstreamCacheEntries;
+    uint32 bitstreamRawBytes;        // Last successful load, size programmed
+    uint32 bitstreamCompressedBytes; // Last successful load, LZ4 source size, 0 if uncompressed
+    uint32 bitstreamRatioX100;       // Compression ratio * 100, 0 if uncompressed
+    uint32 bitstreamDecompressKBps;
+    uint32 bitstreamCrc32c;          // Last successful load, CRC-32C checked against the table, 0 if unchecked
+    uint32 bitstreamVerifyMBps;      // Last successful load, CRC-32C throughput
+    uint32 bitstreamVerifyFailures;  // CRC mismatches since startup
+    uint32 accelMask;                // Cores of the loaded design, bit n = FPGA_CTRL_ACCEL_* type n
+    char   loadedDesign[16];         // Table name of the loaded bitstream, "builtin" or empty if unknown
+    uint32 priorityMsgs;             // Read off the priority pipe, housekeeping requests, wakeups and control commands
+    uint32 commandMsgs;
+    uint16 priorityDepthHighWater;   // Most read off the pipe and not yet handled
+    uint16 commandDepthHighWater;
+    uint16 priorityBacklogs;         // Times messages were left waiting on the pipe, its queue full
+    uint16 commandBacklogs;
+    uint16 jobsActive;               // Long commands still running
+    uint16 jobMaxSlices;             // Most slices a long command has taken
+    uint32 jobsCompleted;
+    uint32 jobsFailed;               // Not including those cancelled
+    uint32 jobsCancelled;            // Fabric jobs ended by a reload
+    uint32 jobMaxRunMs;              // Longest a long command has taken, start to finish
 } FPGA_CTRL_HkTlm_Payload_t;
 
 typedef struct
@@ -114,4 +282,201 @@ typedef struct
     uint8                     switchPos; /**< \brief Switch position */
 } FPGA_CTRL_IntTlm_t;
 
+// One run of identical GPIO samples
+typedef struct
+{
+    uint16 value;  // Switches in the high byte, buttons in the low byte
+    uint16 length; // Number of consecutive samples with this value
+} FPGA_CTRL_SampleRun_t;
+
+// Describes one run-length encoded sample block, in telemetry and in sample files
+typedef struct
+{
+    uint32 blockSeq;    // Increments per block, gaps mean blocks were lost
+    uint32 rateHz;
+    uint16 sampleCount; // Samples in the block
+    uint16 runCount;    // Runs in the whole block, possibly across several packets
+} FPGA_CTRL_SampleBlockHeader_t;
+
+#define FPGA_CTRL_SAMPLE_RUNS_PER_TLM 256
+
+// Bulk telemetry packet carrying all or part of a sample block
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t     TlmHeader;
+    FPGA_CTRL_SampleBlockHeader_t header;
+    uint16                        firstRun;     // Index of runs[0] within the block
+    uint16                        runsInPacket; // Packet is truncated after this many runs
+    FPGA_CTRL_SampleRun_t         runs[FPGA_CTRL_SAMPLE_RUNS_PER_TLM];
+} FPGA_CTRL_SampleTlm_t;
+
+// Reprogramming progress, sent on every state change and periodically while staging
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t TlmHeader;
+    uint8                     fabricState; // FPGA_CTRL_FABRIC_*
+    uint8                     fabricUp;    // boolean, accelerator commands accepted
+    uint8                     padding[2];
+    uint32                    bytesTotal;
+    uint32                    bytesStaged;
+    uint32                    elapsedMs; // Since the reload started
+    char                      firmwareName[64];
+} FPGA_CTRL_ReprogramTlm_t;
+
+#define FPGA_CTRL_IRQ_LATENCY_BUCKETS 16 // Power of two microsecond buckets, the last one catches everything above
+
+// Load generator statistics, sent periodically during a run and once at the end. Counters cover the whole run.
+typedef struct
+{
+    uint32 rateHz;
+    uint32 burstLen;
+    uint32 elapsedMs;
+    uint32 raised;        // Events raised by the generator
+    uint32 delivered;     // Interrupts signalled through the fake UIO device
+    uint32 handled;        // Interrupts the interrupt task handled
+    uint32 coalesced;      // Events handled along with an earlier one, by the same interrupt
+    uint32 dropped;        // Raised but never handled, lost or still pending
+    uint32 handledPerSec;  // Throughput since the previous packet
+    uint32 latencySamples; // Interrupts whose latency was measured, all but those delivered again with nothing new
+    uint32 latencyAvgUs;   // Raise to handled, over the measured interrupts
+    uint32 latencyMaxUs;
+    uint32 latencyHist[FPGA_CTRL_IRQ_LATENCY_BUCKETS]; // Bucket n counts latencies below 2^(n+1) us
+    uint8  irqMode;                                    // FPGA_CTRL_IRQ_MODE_*
+    uint8  padding[3];
+} FPGA_CTRL_LoadGenTlm_Payload_t;
+
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t      TlmHeader;
+    FPGA_CTRL_LoadGenTlm_Payload_t Payload;
+} FPGA_CTRL_LoadGenTlm_t;
+
+// Reconfigurable region states
+#define FPGA_CTRL_REGION_EMPTY   0 // No module loaded
+#define FPGA_CTRL_REGION_LOADING 1 // Module being staged and its overlay applied
+#define FPGA_CTRL_REGION_LOADED  2
+
+typedef struct
+{
+    char   module[16];      // Table name of the loaded or loading module, empty if none
+    uint8  state;           // FPGA_CTRL_REGION_*
+    uint8  occupancyPct;    // Share of the app's lifetime a module has been loaded
+    uint8  overheadPct;     // Share of the app's lifetime spent reconfiguring
+    uint8  padding;
+    uint32 reconfigCount;
+    uint32 reconfigMsLast;  // Start of staging to the overlay being applied
+    uint32 reconfigMsTotal;
+    uint32 jobsServed;      // Jobs run on modules in this region
+    uint32 jobsPerReconfig; // jobsServed / reconfigCount, how well reconfiguration is being amortized
+} FPGA_CTRL_RegionStatus_t;
+
+// Region scheduler state, sent with housekeeping and whenever a region finishes loading
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t TlmHeader;
+    uint32                    jobsQueued;   // Waiting for their module to be loaded
+    uint32                    jobsDeferred; // Queued since startup instead of run immediately
+    uint32                    jobsDropped;  // Queue full, or their module failed to load
+    uint32                    maxWaitMs;    // Longest a job has waited for its module
+    FPGA_CTRL_RegionStatus_t  regions[2];   // FPGA_CTRL_MAX_REGIONS
+} FPGA_CTRL_RegionTlm_t;
+
+typedef struct
+{
+    uint32 count;   // Received, whether or not they were accepted
+    uint32 errors;  // Bad length, fabric down or the handler failed
+    uint32 totalUs; // Time spent in the handler, asynchronous commands only count handing the work off
+    uint32 maxUs;
+} FPGA_CTRL_CmdStats_t;
+
+// Outcome of a batch command, sent once it has run
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t TlmHeader;
+    uint16                    sequence;     // From the command
+    uint8                     itemCount;    // Items in the command
+    uint8                     itemsRun;     // Less than itemCount if it stopped on an error or was malformed
+    uint32                    resultBitmap; // Bit n set when item n succeeded
+    int32                     status;       // CFE_SUCCESS, or the status of the first item that failed
+    uint8                     firstFailed;  // Index of that item, 0xFF if none failed
+    uint8                     padding[3];
+} FPGA_CTRL_BatchTlm_t;
+
+typedef struct
+{
+    char   name[12];
+    uint16 divisor;  // Runs every divisor-th scheduler wakeup
+    uint16 budgetUs; // Runs longer than this are overruns
+    uint32 runs;
+    uint32 errors;
+    uint32 overruns;
+    uint32 skipped; // Due, but the wakeup's budget was already spent
+    uint32 maxUs;
+} FPGA_CTRL_RateItemStats_t;
+
+// Rate group statistics, sent with housekeeping
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t TlmHeader;
+    uint32                    wakeups;
+    uint32                    overruns; // Wakeups whose items took longer than budgetUs
+    uint32                    maxUs;    // Longest wakeup
+    uint32                    busyMs;   // Time spent running items
+    uint16                    budgetUs;
+    uint16                    itemCount;
+    FPGA_CTRL_RateItemStats_t items[8]; // FPGA_CTRL_RATE_MAX_ITEMS, in registration order
+} FPGA_CTRL_RateTlm_t;
+
+// Time-tagged command queue, sent with housekeeping
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t TlmHeader;
+    uint32                    queued; // Waiting for their tag
+    uint32                    peakQueued;
+    uint32                    accepted;
+    uint32                    rejected; // Tag already passed or the queue was full
+    uint32                    released;
+    uint32                    jitterUsLast; // Time the command was sent after its tag
+    uint32                    jitterUsMax;
+    uint32                    jitterUsAvg;
+} FPGA_CTRL_TimedTlm_t;
+
+#define FPGA_CTRL_DRAIN_HIST_BUCKETS 8
+
+// Dispatch statistics, sent with housekeeping
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t TlmHeader;
+    uint32                    wakeups;      // Times the main task woke up to messages
+    uint32                    drainHist[FPGA_CTRL_DRAIN_HIST_BUCKETS]; // Per wakeup: 1, 2, 3-4, 5-8, ... 65+ messages
+    uint32                    drainCountLimited; // Drains cut short by the table's message limit
+    uint32                    drainTimeLimited;  // Drains cut short by the table's time budget
+    uint32                    pipeWaitMs;        // Time spent pending on the pipe
+    uint32                    handlingMs;        // Time spent handling messages
+    uint32                    loadPct;           // Share of the last stats interval spent handling messages
+    FPGA_CTRL_CmdStats_t      cmds[FPGA_CTRL_CC_COUNT]; // Indexed by command code
+} FPGA_CTRL_CmdStatsTlm_t;
+
+// Profile rows, the command codes and then the main task's other work
+#define FPGA_CTRL_PROFILE_HK     (FPGA_CTRL_CC_COUNT + 0) // Housekeeping requests
+#define FPGA_CTRL_PROFILE_WAKEUP (FPGA_CTRL_CC_COUNT + 1) // Scheduler wakeups, the rate groups
+#define FPGA_CTRL_PROFILE_JOBS   (FPGA_CTRL_CC_COUNT + 2) // Slices of long commands
+#define FPGA_CTRL_PROFILE_ROWS   (FPGA_CTRL_CC_COUNT + 3)
+
+typedef struct
+{
+    uint32 calls;
+    uint32 wallUs; // Total
+    uint32 cpuUs;  // Total thread CPU time
+    uint32 wallMaxUs;
+} FPGA_CTRL_ProfileSummary_t;
+
+// Summary of the command profile, sent with housekeeping. The histograms are only in the CSV dump.
+typedef struct
+{
+    CFE_MSG_TelemetryHeader_t  TlmHeader;
+    uint32                     sinceMs; // Time since the profile was last reset
+    FPGA_CTRL_ProfileSummary_t rows[FPGA_CTRL_PROFILE_ROWS]; // FPGA_CTRL_PROFILE_*, command codes first
+} FPGA_CTRL_ProfileTlm_t;
+
 #endif /* FPGA_CTRL_MSG_H */
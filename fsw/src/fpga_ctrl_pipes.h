@@ -0,0 +1,263 @@
+// The app's two pipes, read by a relay child each. Housekeeping requests, wakeups and control commands come in on the
+// priority pipe and everything else on the command pipe, each with its own depth and subscriptions, so a flood of
+// commands fills and drops on its own pipe only.
+// SB can't pend on two pipes at once, so each relay pends on its pipe and copies what arrives into a queue as deep
+// as the pipe, signalling the main task. The main task sleeps on the queues rather than on a pipe, waking for the
+// first message on either and never on a timer, and takes from the priority queue first. The relays run just above
+// the main task, so a priority message is queued as it arrives and waits behind at most the message being handled.
+// A queue holds messages read and not yet handled, so its high-water mark is a real depth. Once a queue is full its
+// relay stops reading and the rest wait on the pipe, counted as a backlog.
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_PIPE_PRIORITY 0 // Queues in the order they're taken from
+#define FPGA_CTRL_PIPE_COMMAND  1
+#define FPGA_CTRL_PIPE_CLASSES  2
+
+// A message copied off a pipe. One longer than any command is cut short, its header still gives the real length so
+// it fails the length check as it would have straight off the pipe.
+typedef union
+{
+    CFE_SB_Buffer_t Buf;
+    uint8           Bytes[FPGA_CTRL_COMMAND_MAX_SIZE];
+} FPGA_CTRL_PipeMsg_t;
+
+typedef struct
+{
+    uint32 received;
+    uint32 highWater; // Most messages read and not yet handled
+    uint32 backlogs;  // Times the queue was full and messages were left on the pipe
+} FPGA_CTRL_PipeStats_t;
+
+typedef struct
+{
+    char const           *name;
+    FPGA_CTRL_PipeMsg_t  *msgs;
+    uint32                depth;
+    CFE_SB_PipeId_t       pipeId;
+    uint32                head;  // Oldest message
+    uint32                count; // Including the one the main task has taken, until it takes the next
+    bool                  taken; // The main task is handling msgs[head]
+    int32                 error; // Read error that stopped the relay, CFE_SUCCESS while it runs
+    CFE_ES_TaskId_t       taskId;
+    FPGA_CTRL_PipeStats_t stats;
+} FPGA_CTRL_PipeRelay_t;
+
+static FPGA_CTRL_PipeMsg_t priorityPipeMsgs[FPGA_CTRL_PRIORITY_PIPE_DEPTH];
+static FPGA_CTRL_PipeMsg_t commandPipeMsgs[FPGA_CTRL_PIPE_DEPTH];
+
+static struct
+{
+    FPGA_CTRL_PipeRelay_t relays[FPGA_CTRL_PIPE_CLASSES];
+    pthread_mutex_t       lock;  // Over the queues and their statistics
+    pthread_cond_t        ready; // Signalled when a message is queued or a relay stops
+    pthread_cond_t        space; // Broadcast when the main task frees a slot
+} pipeRelays = {
+    .relays =
+        {
+            [FPGA_CTRL_PIPE_PRIORITY] = {"priority", priorityPipeMsgs, FPGA_CTRL_PRIORITY_PIPE_DEPTH},
+            [FPGA_CTRL_PIPE_COMMAND]  = {"command", commandPipeMsgs, FPGA_CTRL_PIPE_DEPTH},
+        },
+};
+
+// Exported functions
+int32 FPGA_CTRL_StartPipeRelays(CFE_SB_PipeId_t priorityPipe, CFE_SB_PipeId_t commandPipe);
+int32 FPGA_CTRL_PipeReceive(CFE_SB_Buffer_t **SBBufPtr, int32 TimeOut);
+void  FPGA_CTRL_PipeStatsRead(FPGA_CTRL_PipeStats_t stats[FPGA_CTRL_PIPE_CLASSES]);
+
+static void FPGA_CTRL_PriorityRelayTask(void);
+static void FPGA_CTRL_CommandRelayTask(void);
+static void FPGA_CTRL_RelayPipe(FPGA_CTRL_PipeRelay_t *relay);
+
+// Starts a relay on each pipe, one priority step above the calling main task
+int32 FPGA_CTRL_StartPipeRelays(CFE_SB_PipeId_t const priorityPipe, CFE_SB_PipeId_t const commandPipe)
+{
+    static CFE_ES_ChildTaskMainFuncPtr_t const relayTasks[FPGA_CTRL_PIPE_CLASSES] = {
+        [FPGA_CTRL_PIPE_PRIORITY] = FPGA_CTRL_PriorityRelayTask,
+        [FPGA_CTRL_PIPE_COMMAND]  = FPGA_CTRL_CommandRelayTask,
+    };
+    pthread_condattr_t attr;
+    OS_task_prop_t     mainTask;
+    char               taskName[OS_MAX_API_NAME];
+    int32              err;
+
+    pipeRelays.relays[FPGA_CTRL_PIPE_PRIORITY].pipeId = priorityPipe;
+    pipeRelays.relays[FPGA_CTRL_PIPE_COMMAND].pipeId  = commandPipe;
+
+    // The main task's receive times out on the monotonic clock
+    if (pthread_mutex_init(&pipeRelays.lock, NULL) != 0 || pthread_condattr_init(&attr) != 0 ||
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) != 0 || pthread_cond_init(&pipeRelays.ready, &attr) != 0 ||
+        pthread_cond_init(&pipeRelays.space, NULL) != 0)
+    {
+        CFE_ES_WriteToSysLog("FPGA Ctrl: Error creating pipe relay lock\n");
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+    pthread_condattr_destroy(&attr);
+
+    // OSAL priorities count down, a relay has to be able to preempt the main task to queue a priority message
+    // while a command is being handled
+    CFE_ES_TaskPriority_Atom_t priority = CFE_PLATFORM_ES_PERF_CHILD_PRIORITY;
+    if (OS_TaskGetInfo(OS_TaskGetId(), &mainTask) == OS_SUCCESS)
+        priority = mainTask.priority > 1 ? mainTask.priority - 1 : 1;
+
+    for (int c = 0; c < FPGA_CTRL_PIPE_CLASSES; ++c)
+    {
+        FPGA_CTRL_PipeRelay_t *const relay = &pipeRelays.relays[c];
+
+        snprintf(taskName, sizeof(taskName), "FPGA_CTRL %s relay", relay->name);
+        if ((err = CFE_ES_CreateChildTask(&relay->taskId, taskName, relayTasks[c], CFE_ES_TASK_STACK_ALLOCATE,
+                                          CFE_PLATFORM_ES_DEFAULT_STACK_SIZE, priority, 0)) < CFE_SUCCESS)
+        {
+            CFE_ES_WriteToSysLog("FPGA Ctrl: Error creating %s pipe relay, RC = 0x%08lX\n", relay->name,
+                                 (unsigned long)err);
+            return err;
+        }
+    }
+
+    return CFE_SUCCESS;
+}
+
+// The next message, priority queue first, lasting until the next call like an SB buffer does. Waits up to TimeOut
+// ms for one, or forever with CFE_SB_PEND_FOREVER, or not at all with CFE_SB_POLL. Returns CFE_SB_NO_MESSAGE or
+// CFE_SB_TIME_OUT if nothing came, or the read error of a stopped relay once nothing is left queued.
+int32 FPGA_CTRL_PipeReceive(CFE_SB_Buffer_t **const SBBufPtr, int32 const TimeOut)
+{
+    struct timespec deadline;
+    int32           status = CFE_SB_NO_MESSAGE;
+
+    if (TimeOut > 0)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += TimeOut / 1000;
+        deadline.tv_nsec += (long)(TimeOut % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            ++deadline.tv_sec;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&pipeRelays.lock);
+
+    // Done with the message handed out last time
+    for (int c = 0; c < FPGA_CTRL_PIPE_CLASSES; ++c)
+    {
+        FPGA_CTRL_PipeRelay_t *const relay = &pipeRelays.relays[c];
+        if (relay->taken)
+        {
+            relay->taken = false;
+            relay->head  = (relay->head + 1) % relay->depth;
+            --relay->count;
+            pthread_cond_broadcast(&pipeRelays.space);
+        }
+    }
+
+    for (;;)
+    {
+        for (int c = 0; c < FPGA_CTRL_PIPE_CLASSES && status == CFE_SB_NO_MESSAGE; ++c)
+        {
+            FPGA_CTRL_PipeRelay_t *const relay = &pipeRelays.relays[c];
+            if (relay->count != 0)
+            {
+                relay->taken = true;
+                *SBBufPtr    = &relay->msgs[relay->head].Buf;
+                status       = CFE_SUCCESS;
+            }
+        }
+        for (int c = 0; c < FPGA_CTRL_PIPE_CLASSES && status == CFE_SB_NO_MESSAGE; ++c)
+        {
+            if (pipeRelays.relays[c].error != CFE_SUCCESS)
+                status = pipeRelays.relays[c].error;
+        }
+        if (status != CFE_SB_NO_MESSAGE || TimeOut == CFE_SB_POLL)
+            break;
+
+        if (TimeOut == CFE_SB_PEND_FOREVER)
+        {
+            pthread_cond_wait(&pipeRelays.ready, &pipeRelays.lock);
+        }
+        else if (pthread_cond_timedwait(&pipeRelays.ready, &pipeRelays.lock, &deadline) == ETIMEDOUT)
+        {
+            status = CFE_SB_TIME_OUT;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&pipeRelays.lock);
+    return status;
+}
+
+// Copies the queue statistics, indexed by FPGA_CTRL_PIPE_*
+void FPGA_CTRL_PipeStatsRead(FPGA_CTRL_PipeStats_t stats[FPGA_CTRL_PIPE_CLASSES])
+{
+    pthread_mutex_lock(&pipeRelays.lock);
+    for (int c = 0; c < FPGA_CTRL_PIPE_CLASSES; ++c)
+        stats[c] = pipeRelays.relays[c].stats;
+    pthread_mutex_unlock(&pipeRelays.lock);
+}
+
+static void FPGA_CTRL_PriorityRelayTask(void)
+{
+    FPGA_CTRL_RelayPipe(&pipeRelays.relays[FPGA_CTRL_PIPE_PRIORITY]);
+}
+
+static void FPGA_CTRL_CommandRelayTask(void)
+{
+    FPGA_CTRL_RelayPipe(&pipeRelays.relays[FPGA_CTRL_PIPE_COMMAND]);
+}
+
+// Moves messages from the pipe to the back of its queue until a read fails, which is left for the main task to
+// report. Only the relay writes past the end of the queue, so the copy is made outside the lock.
+static void FPGA_CTRL_RelayPipe(FPGA_CTRL_PipeRelay_t *const relay)
+{
+    CFE_SB_Buffer_t *SBBufPtr;
+    size_t           size;
+
+    // Runs on the main task's cores, it's part of the main task's path
+    FPGA_CTRL_ApplyChildSchedProfile(globalState.SchedProfile.MainCpuMask);
+
+    for (;;)
+    {
+        int32 const status = CFE_SB_ReceiveBuffer(&SBBufPtr, relay->pipeId, CFE_SB_PEND_FOREVER);
+        if (status != CFE_SUCCESS)
+        {
+            pthread_mutex_lock(&pipeRelays.lock);
+            relay->error = status;
+            pthread_cond_signal(&pipeRelays.ready);
+            pthread_mutex_unlock(&pipeRelays.lock);
+            break;
+        }
+
+        pthread_mutex_lock(&pipeRelays.lock);
+        if (relay->count == relay->depth)
+        {
+            ++relay->stats.backlogs;
+            while (relay->count == relay->depth)
+                pthread_cond_wait(&pipeRelays.space, &pipeRelays.lock);
+        }
+        FPGA_CTRL_PipeMsg_t *const slot = &relay->msgs[(relay->head + relay->count) % relay->depth];
+        pthread_mutex_unlock(&pipeRelays.lock);
+
+        size = 0;
+        CFE_MSG_GetSize(&SBBufPtr->Msg, &size);
+        memcpy(slot->Bytes, SBBufPtr, size < sizeof(slot->Bytes) ? size : sizeof(slot->Bytes));
+
+        pthread_mutex_lock(&pipeRelays.lock);
+        ++relay->stats.received;
+        if (++relay->count > relay->stats.highWater)
+            relay->stats.highWater = relay->count;
+        pthread_cond_signal(&pipeRelays.ready);
+        pthread_mutex_unlock(&pipeRelays.lock);
+    }
+
+    CFE_ES_ExitChildTask();
+}
@@ -0,0 +1,52 @@
+// Static tracepoints (USDT) on the app's hot paths, for perf and bpftrace attached to the running cFS process.
+// Each probe is a single nop in the code plus a note in the ELF file naming it and where its arguments live, so an
+// unattached probe costs next to nothing. List them with
+//     perf list 'sdt_fpga_ctrl:*'   or   bpftrace -l 'usdt:/path/to/core-cpu1:fpga_ctrl:*'
+// and attach with e.g.
+//     bpftrace -e 'usdt:core-cpu1:fpga_ctrl:cmd__done { @us[arg0] = hist(arg2); }'
+// Where <sys/sdt.h> (systemtap-sdt-dev) isn't installed, or with FPGA_CTRL_NO_PROBES defined, the probes compile
+// to nothing and their arguments aren't evaluated. Arguments are integers and pointers the code mostly has at hand
+// anyway, so an attached probe doesn't change the timing it's there to measure.
+//
+// Probes, provider fpga_ctrl:
+//     cmd__start(cc, priority)                   Ground command about to be dispatched
+//     cmd__done(cc, status, elapsed_us)          Its handler returned
+//     encrypt__submit(deferred)                  Encryption accepted, 1 if it waits for a module with an AES core
+//     encrypt__start(queued_us)                  Key and plaintext loaded and core started, time since the job began
+//     encrypt__done(status, elapsed_us, slices)  Core finished, timed out or went away
+//     irq__wake(poll_result, count)              Interrupt task back from poll(), 0 on timeout
+//     irq__clear(isr)                            Interrupt status register before it's cleared and re-armed
+//     irq__tx(switch_pos)                        Button telemetry sent
+//     map__create(type, phys, range, status)     Core's register window mapped
+//     map__delete(type, virt, range)             Core's register window unmapped
+//     bitstream__phase(state, elapsed_ms)        Reload moved to a fabric state, FPGA_CTRL_FABRIC_*
+//     bitstream__done(status, downtime_ms, raw_bytes)  Reload finished
+
+#ifndef FPGA_CTRL_PROBES_H
+#define FPGA_CTRL_PROBES_H
+
+#if !defined(FPGA_CTRL_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define FPGA_CTRL_HAVE_PROBES
+#endif
+#endif
+
+#ifdef FPGA_CTRL_HAVE_PROBES
+
+#include <sys/sdt.h>
+
+#define FPGA_CTRL_PROBE1(name, a)          STAP_PROBE1(fpga_ctrl, name, a)
+#define FPGA_CTRL_PROBE2(name, a, b)       STAP_PROBE2(fpga_ctrl, name, a, b)
+#define FPGA_CTRL_PROBE3(name, a, b, c)    STAP_PROBE3(fpga_ctrl, name, a, b, c)
+#define FPGA_CTRL_PROBE4(name, a, b, c, d) STAP_PROBE4(fpga_ctrl, name, a, b, c, d)
+
+#else
+
+#define FPGA_CTRL_PROBE1(name, a)          ((void)0)
+#define FPGA_CTRL_PROBE2(name, a, b)       ((void)0)
+#define FPGA_CTRL_PROBE3(name, a, b, c)    ((void)0)
+#define FPGA_CTRL_PROBE4(name, a, b, c, d) ((void)0)
+
+#endif /* FPGA_CTRL_HAVE_PROBES */
+
+#endif /* FPGA_CTRL_PROBES_H */
@@ -0,0 +1,201 @@
+// Profile of where the main task's time goes, by command code plus rows for housekeeping, scheduler wakeups and
+// slices of long commands. Each row counts calls and totals wall time and thread CPU time, with a log2 histogram of
+// each, so a command that blocks can be told from one that computes. Times are inclusive: a batch includes its
+// sub-commands, and an asynchronous command only its hand-off.
+// The full profile is written as CSV on command, a summary goes out with housekeeping.
+// Runs on the main task only.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+
+#define FPGA_CTRL_PROFILE_BUCKETS  16 // Bucket n counts times under 2^n us, the last everything from 2^14 us
+#define FPGA_CTRL_PROFILE_LINE_LEN 1024
+
+// Start of a profiled call
+typedef struct
+{
+    int64 wallNs;
+    int64 cpuNs;
+} FPGA_CTRL_ProfileMark_t;
+
+typedef struct
+{
+    char const *name; // Set when it is first called
+    uint32      calls;
+    uint64      wallNs;
+    uint64      cpuNs;
+    uint32      wallMaxUs;
+    uint32      cpuMaxUs;
+    uint32      wallHist[FPGA_CTRL_PROFILE_BUCKETS];
+    uint32      cpuHist[FPGA_CTRL_PROFILE_BUCKETS];
+} FPGA_CTRL_ProfileRow_t;
+
+static struct
+{
+    FPGA_CTRL_ProfileRow_t rows[FPGA_CTRL_PROFILE_ROWS];
+    int64                  sinceNs;
+} cmdProfile;
+
+// Exported functions
+void   FPGA_CTRL_ResetProfile(void);
+void   FPGA_CTRL_ProfileStart(FPGA_CTRL_ProfileMark_t *mark);
+uint32 FPGA_CTRL_ProfileStop(uint32 row, char const *name, FPGA_CTRL_ProfileMark_t const *mark);
+int32  FPGA_CTRL_DumpProfile(FPGA_CTRL_ProfileDumpCmd_t const *Msg);
+void   FPGA_CTRL_SendProfileTlm(void);
+
+static int64  FPGA_CTRL_ThreadCpuNs(void);
+static uint32 FPGA_CTRL_ProfileBucket(uint32 us);
+static int32  FPGA_CTRL_WriteProfileCsv(osal_id_t fileId);
+
+void FPGA_CTRL_ResetProfile(void)
+{
+    memset(&cmdProfile, 0, sizeof(cmdProfile));
+    cmdProfile.sinceNs = FPGA_CTRL_MonotonicNs();
+}
+
+void FPGA_CTRL_ProfileStart(FPGA_CTRL_ProfileMark_t *const mark)
+{
+    mark->wallNs = FPGA_CTRL_MonotonicNs();
+    mark->cpuNs  = FPGA_CTRL_ThreadCpuNs();
+}
+
+// Charges the time since the mark to the row, returns the wall time in us
+uint32 FPGA_CTRL_ProfileStop(uint32 const row, char const *const name, FPGA_CTRL_ProfileMark_t const *const mark)
+{
+    uint64 const wallNs = (uint64)(FPGA_CTRL_MonotonicNs() - mark->wallNs);
+    uint64 const cpuNs  = (uint64)(FPGA_CTRL_ThreadCpuNs() - mark->cpuNs);
+    uint32 const wallUs = (uint32)(wallNs / 1000);
+    uint32 const cpuUs  = (uint32)(cpuNs / 1000);
+
+    if (row >= FPGA_CTRL_PROFILE_ROWS)
+        return wallUs;
+
+    FPGA_CTRL_ProfileRow_t *const r = &cmdProfile.rows[row];
+    r->name                         = name;
+    ++r->calls;
+    r->wallNs += wallNs;
+    r->cpuNs += cpuNs;
+    if (wallUs > r->wallMaxUs)
+        r->wallMaxUs = wallUs;
+    if (cpuUs > r->cpuMaxUs)
+        r->cpuMaxUs = cpuUs;
+    ++r->wallHist[FPGA_CTRL_ProfileBucket(wallUs)];
+    ++r->cpuHist[FPGA_CTRL_ProfileBucket(cpuUs)];
+
+    return wallUs;
+}
+
+// Writes every row, one line each with its histograms, to the file named in the command
+int32 FPGA_CTRL_DumpProfile(FPGA_CTRL_ProfileDumpCmd_t const *const Msg)
+{
+    char      path[sizeof(Msg->path)];
+    osal_id_t fileId;
+    int32     err;
+
+    if (memchr(Msg->path, '\0', sizeof(Msg->path)) == NULL || Msg->path[0] == '\0')
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Profile path is empty or too long");
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+    memcpy(path, Msg->path, sizeof(path));
+
+    if ((err = OS_OpenCreate(&fileId, path, OS_FILE_FLAG_CREATE | OS_FILE_FLAG_TRUNCATE, OS_WRITE_ONLY)) !=
+        OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to open profile file %s: %d",
+                          path, (int)err);
+        return err;
+    }
+
+    err = FPGA_CTRL_WriteProfileCsv(fileId);
+    OS_close(fileId);
+    if (err != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to write profile file %s: %d",
+                          path, (int)err);
+        return err;
+    }
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "Profile of the last %u ms written to %s",
+                      (unsigned int)((FPGA_CTRL_MonotonicNs() - cmdProfile.sinceNs) / 1000000), path);
+
+    if (Msg->reset)
+        FPGA_CTRL_ResetProfile();
+    return CFE_SUCCESS;
+}
+
+void FPGA_CTRL_SendProfileTlm(void)
+{
+    static FPGA_CTRL_ProfileTlm_t packet;
+
+    CFE_MSG_Init(&packet.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_PROFILE_TLM_MID), sizeof(packet));
+
+    packet.sinceMs = (uint32)((FPGA_CTRL_MonotonicNs() - cmdProfile.sinceNs) / 1000000);
+    for (uint32 i = 0; i < FPGA_CTRL_PROFILE_ROWS; ++i)
+    {
+        FPGA_CTRL_ProfileRow_t const *const row = &cmdProfile.rows[i];
+        packet.rows[i].calls                    = row->calls;
+        packet.rows[i].wallUs                   = (uint32)(row->wallNs / 1000);
+        packet.rows[i].cpuUs                    = (uint32)(row->cpuNs / 1000);
+        packet.rows[i].wallMaxUs                = row->wallMaxUs;
+    }
+
+    CFE_SB_TimeStampMsg(&packet.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&packet.TlmHeader.Msg, true);
+}
+
+static int64 FPGA_CTRL_ThreadCpuNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint32 FPGA_CTRL_ProfileBucket(uint32 const us)
+{
+    uint32 const bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+    return bucket < FPGA_CTRL_PROFILE_BUCKETS ? bucket : FPGA_CTRL_PROFILE_BUCKETS - 1;
+}
+
+static int32 FPGA_CTRL_WriteProfileCsv(osal_id_t const fileId)
+{
+    static char const *const kinds[] = {"wall", "cpu"};
+    char                     line[FPGA_CTRL_PROFILE_LINE_LEN];
+    int                      len;
+
+    len = snprintf(line, sizeof(line), "row,name,calls,wall_total_us,wall_max_us,cpu_total_us,cpu_max_us");
+    for (int k = 0; k < 2; ++k)
+    {
+        for (int b = 0; b < FPGA_CTRL_PROFILE_BUCKETS - 1; ++b)
+            len += snprintf(line + len, sizeof(line) - len, ",%s_lt_%uus", kinds[k], 1u << b);
+        len += snprintf(line + len, sizeof(line) - len, ",%s_ge_%uus", kinds[k],
+                        1u << (FPGA_CTRL_PROFILE_BUCKETS - 2));
+    }
+    len += snprintf(line + len, sizeof(line) - len, "\n");
+    if (OS_write(fileId, line, len) != len)
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+
+    for (uint32 i = 0; i < FPGA_CTRL_PROFILE_ROWS; ++i)
+    {
+        FPGA_CTRL_ProfileRow_t const *const row = &cmdProfile.rows[i];
+
+        len = snprintf(line, sizeof(line), "%u,%s,%u,%llu,%u,%llu,%u", (unsigned int)i,
+                       row->name != NULL ? row->name : "", (unsigned int)row->calls,
+                       (unsigned long long)(row->wallNs / 1000), (unsigned int)row->wallMaxUs,
+                       (unsigned long long)(row->cpuNs / 1000), (unsigned int)row->cpuMaxUs);
+        for (int b = 0; b < FPGA_CTRL_PROFILE_BUCKETS; ++b)
+            len += snprintf(line + len, sizeof(line) - len, ",%u", (unsigned int)row->wallHist[b]);
+        for (int b = 0; b < FPGA_CTRL_PROFILE_BUCKETS; ++b)
+            len += snprintf(line + len, sizeof(line) - len, ",%u", (unsigned int)row->cpuHist[b]);
+        len += snprintf(line + len, sizeof(line) - len, "\n");
+
+        if (OS_write(fileId, line, len) != len)
+            return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    return CFE_SUCCESS;
+}
@@ -0,0 +1,176 @@
+// Rate groups driven by the scheduler's wakeup message. Periodic work registers with a divisor and runs on every
+// divisor-th wakeup, staggered so items with the same divisor don't all land in the same one. Each wakeup gets a time
+// budget from the table: items still due once it's spent are skipped until their next slot rather than run late, so
+// the app's load per wakeup stays bounded. The next wakeup starts from the first item skipped, so an item late in
+// the list isn't always the one left out. Item and wakeup overruns are counted and reported.
+// Runs on the main task only.
+
+#include <string.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+#include "fpga_ctrl_table.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_RATE_MAX_ITEMS 8
+
+typedef int32 (*FPGA_CTRL_RateFn_t)(void);
+
+typedef struct
+{
+    char const        *name;
+    FPGA_CTRL_RateFn_t fn;
+    uint16             divisor;  // Runs every divisor-th wakeup
+    uint16             phase;    // Wakeup within the divisor it runs in
+    uint16             budgetUs; // Longest it should take, longer counts as an overrun
+    uint32             runs;
+    uint32             errors;
+    uint32             overruns;
+    uint32             skipped; // Due, but the wakeup's budget was already spent
+    uint32             maxUs;
+} FPGA_CTRL_RateItem_t;
+
+typedef struct
+{
+    FPGA_CTRL_RateItem_t items[FPGA_CTRL_RATE_MAX_ITEMS];
+    uint32               itemCount;
+    uint32               first; // Item the wakeups start from, the first one skipped by the last wakeup to skip any
+    uint32               wakeups;
+    uint32               overruns; // Wakeups whose items took longer than the budget
+    uint32               maxUs;
+    uint64               busyNs;
+    uint16               budgetUs; // From the table, 0 = unlimited
+} FPGA_CTRL_RateGroups_t;
+
+static FPGA_CTRL_RateGroups_t rateGroups;
+
+// Exported functions
+int32 FPGA_CTRL_RegisterRateItem(char const *name, FPGA_CTRL_RateFn_t fn, uint16 divisor, uint16 budgetUs);
+void  FPGA_CTRL_LoadRateBudget(void);
+int32 FPGA_CTRL_RunRateGroups(void);
+void  FPGA_CTRL_SendRateTlm(void);
+
+// Adds periodic work, called during init. The phase spreads items sharing a divisor across its wakeups.
+int32 FPGA_CTRL_RegisterRateItem(char const *const name, FPGA_CTRL_RateFn_t const fn, uint16 const divisor,
+                                 uint16 const budgetUs)
+{
+    if (rateGroups.itemCount == FPGA_CTRL_RATE_MAX_ITEMS || fn == NULL || divisor == 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Can't register rate group item %s", name);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    uint16 phase = 0;
+    for (uint32 i = 0; i < rateGroups.itemCount; ++i)
+        phase += rateGroups.items[i].divisor == divisor;
+
+    FPGA_CTRL_RateItem_t *const item = &rateGroups.items[rateGroups.itemCount++];
+    memset(item, 0, sizeof(*item));
+    item->name     = name;
+    item->fn       = fn;
+    item->divisor  = divisor;
+    item->phase    = phase % divisor;
+    item->budgetUs = budgetUs;
+
+    return CFE_SUCCESS;
+}
+
+// Copies the wakeup budget out of the table, at startup and after each table update
+void FPGA_CTRL_LoadRateBudget(void)
+{
+    FPGA_CTRL_Table_t *tblPtr;
+
+    if (CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0]) < CFE_SUCCESS)
+        return;
+
+    rateGroups.budgetUs = tblPtr->RateBudgetUs;
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+}
+
+// Runs the items due in this wakeup in registration order, wrapping round from the first one, until the budget is
+// spent
+int32 FPGA_CTRL_RunRateGroups(void)
+{
+    int64 const  startNs      = FPGA_CTRL_MonotonicNs();
+    int64 const  budgetNs     = (int64)rateGroups.budgetUs * 1000;
+    uint32 const wakeup       = rateGroups.wakeups++;
+    uint32       firstSkipped = rateGroups.itemCount;
+
+    for (uint32 n = 0; n < rateGroups.itemCount; ++n)
+    {
+        uint32 const                i    = (rateGroups.first + n) % rateGroups.itemCount;
+        FPGA_CTRL_RateItem_t *const item = &rateGroups.items[i];
+        if (wakeup % item->divisor != item->phase)
+            continue;
+
+        int64 const itemStartNs = FPGA_CTRL_MonotonicNs();
+        if (budgetNs != 0 && itemStartNs - startNs >= budgetNs)
+        {
+            ++item->skipped;
+            if (firstSkipped == rateGroups.itemCount)
+                firstSkipped = i;
+            continue;
+        }
+
+        int32 const  err       = item->fn();
+        uint32 const elapsedUs = (uint32)((FPGA_CTRL_MonotonicNs() - itemStartNs) / 1000);
+
+        ++item->runs;
+        item->errors += err != CFE_SUCCESS;
+        item->overruns += item->budgetUs != 0 && elapsedUs > item->budgetUs;
+        if (elapsedUs > item->maxUs)
+            item->maxUs = elapsedUs;
+    }
+
+    if (firstSkipped != rateGroups.itemCount)
+        rateGroups.first = firstSkipped;
+
+    int64 const  busyNs = FPGA_CTRL_MonotonicNs() - startNs;
+    uint32 const busyUs = (uint32)(busyNs / 1000);
+
+    rateGroups.busyNs += busyNs;
+    if (busyUs > rateGroups.maxUs)
+        rateGroups.maxUs = busyUs;
+    if (budgetNs != 0 && busyNs > budgetNs)
+        ++rateGroups.overruns;
+
+    return CFE_SUCCESS;
+}
+
+void FPGA_CTRL_SendRateTlm(void)
+{
+    static FPGA_CTRL_RateTlm_t packet;
+
+    CFE_MSG_Init(&packet.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_RATE_TLM_MID), sizeof(packet));
+
+    packet.wakeups   = rateGroups.wakeups;
+    packet.overruns  = rateGroups.overruns;
+    packet.maxUs     = rateGroups.maxUs;
+    packet.busyMs    = (uint32)(rateGroups.busyNs / 1000000);
+    packet.budgetUs  = rateGroups.budgetUs;
+    packet.itemCount = (uint16)rateGroups.itemCount;
+
+    for (uint32 i = 0; i < FPGA_CTRL_RATE_MAX_ITEMS; ++i)
+    {
+        FPGA_CTRL_RateItemStats_t *const stats = &packet.items[i];
+        memset(stats, 0, sizeof(*stats));
+        if (i >= rateGroups.itemCount)
+            continue;
+
+        FPGA_CTRL_RateItem_t const *const item = &rateGroups.items[i];
+        strncpy(stats->name, item->name, sizeof(stats->name) - 1);
+        stats->divisor  = item->divisor;
+        stats->budgetUs = item->budgetUs;
+        stats->runs     = item->runs;
+        stats->errors   = item->errors;
+        stats->overruns = item->overruns;
+        stats->skipped  = item->skipped;
+        stats->maxUs    = item->maxUs;
+    }
+
+    CFE_SB_TimeStampMsg(&packet.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&packet.TlmHeader.Msg, true);
+}
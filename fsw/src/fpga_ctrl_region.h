@@ -0,0 +1,434 @@
+// Demand-driven scheduling of the partially reconfigurable regions. Accelerator jobs whose core isn't loaded are
+// queued instead of refused, and the scheduler loads the module with the most jobs waiting into its region once there
+// are enough of them to be worth the reconfiguration, or once one of them has waited too long. The jobs then run
+// back to back, so the reconfiguration is paid once per batch.
+// Runs on the main task: on every queued job, every scheduler wakeup, on housekeeping and whenever the reprogram task
+// finishes a load.
+
+#include <string.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+#include "fpga_ctrl_table.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_REGION_MAX_JOBS 32
+
+// An accelerator command waiting for its module, encrypt is the only one so far
+typedef struct
+{
+    FPGA_CTRL_EncryptCmd_t cmd;
+    int64                  queuedNs;
+    uint32                 coreType; // FPGA_CTRL_ACCEL_* the job runs on
+} FPGA_CTRL_RegionJob_t;
+
+typedef struct
+{
+    uint32                state;  // FPGA_CTRL_REGION_*
+    int                   module; // Table index of the loaded or loading module, -1 if empty
+    char                  moduleName[FPGA_CTRL_BITSTREAM_NAME_LEN];
+    FPGA_CTRL_AccelDesc_t accels[FPGA_CTRL_MAX_ACCELS]; // The module's cores, registered while it's loaded
+    int64                 loadStartNs;
+    int64                 loadedSinceNs;
+    uint64                occupiedNs; // Modules loaded before the current one
+    uint64                reconfigNs;
+    uint32                reconfigCount;
+    uint32                reconfigMsLast;
+    uint32                jobsServed;
+} FPGA_CTRL_Region_t;
+
+typedef struct
+{
+    FPGA_CTRL_Region_t    regions[FPGA_CTRL_MAX_REGIONS];
+    FPGA_CTRL_RegionJob_t jobs[FPGA_CTRL_REGION_MAX_JOBS]; // In arrival order
+    uint32                jobsQueued;
+    uint32                jobsDeferred;
+    uint32                jobsDropped;
+    uint32                maxWaitMs;
+    uint32                lastCompleted; // reprogramJob.completed when the last finished load was picked up
+    int64                 startNs;
+} FPGA_CTRL_RegionSched_t;
+
+static FPGA_CTRL_RegionSched_t regionSched;
+
+// Exported functions
+void  FPGA_CTRL_InitRegions(void);
+int32 FPGA_CTRL_SubmitEncrypt(FPGA_CTRL_EncryptCmd_t const *Msg);
+int32 FPGA_CTRL_LoadNamedModule(FPGA_CTRL_ReprogramNamedCmd_t const *Msg);
+int32 FPGA_CTRL_RegionSchedule(void);
+void  FPGA_CTRL_SendRegionTlm(void);
+
+static void  FPGA_CTRL_RegionReap(void);
+static void  FPGA_CTRL_RegionRunJobs(void);
+static void  FPGA_CTRL_RegionDropJobs(FPGA_CTRL_AccelDesc_t const *accels);
+static int   FPGA_CTRL_RegionPickModule(FPGA_CTRL_Table_t const *tbl, uint32 *demand, uint32 *oldestMs);
+static int32 FPGA_CTRL_RegionLoad(int module, FPGA_CTRL_BitstreamEntry_t const *entry);
+static void  FPGA_CTRL_RegionVacate(FPGA_CTRL_Region_t *region, int64 nowNs);
+static bool  FPGA_CTRL_AccelsProvide(FPGA_CTRL_AccelDesc_t const *accels, uint32 type);
+
+void FPGA_CTRL_InitRegions(void)
+{
+    memset(&regionSched, 0, sizeof(regionSched));
+    for (int i = 0; i < FPGA_CTRL_MAX_REGIONS; ++i)
+        regionSched.regions[i].module = -1;
+    regionSched.startNs = FPGA_CTRL_MonotonicNs();
+}
+
+// Runs the encryption now if the AES core is loaded, otherwise queues it for a module that has one
+int32 FPGA_CTRL_SubmitEncrypt(FPGA_CTRL_EncryptCmd_t const *const Msg)
+{
+    FPGA_CTRL_Table_t *tblPtr;
+    bool               provided = false;
+
+    FPGA_CTRL_RegionReap();
+    if (FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_AES_CTRL) != NULL)
+    {
+        FPGA_CTRL_PROBE1(encrypt__submit, 0);
+        return FPGA_CTRL_Encrypt(Msg);
+    }
+
+    if (CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0]) >= CFE_SUCCESS)
+    {
+        for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+        {
+            FPGA_CTRL_BitstreamEntry_t const *const entry = &tblPtr->Bitstreams[i];
+            provided |= entry->Name[0] != '\0' && entry->Region != 0 &&
+                        FPGA_CTRL_AccelsProvide(entry->Accels, FPGA_CTRL_ACCEL_AES_CTRL);
+        }
+        CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+    }
+
+    if (!provided)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "The loaded design has no AES core and no module provides one");
+        return CFE_STATUS_INCORRECT_STATE;
+    }
+
+    if (regionSched.jobsQueued == FPGA_CTRL_REGION_MAX_JOBS)
+    {
+        ++regionSched.jobsDropped;
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "Region job queue full, dropping encryption");
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    FPGA_CTRL_RegionJob_t *const job = &regionSched.jobs[regionSched.jobsQueued++];
+    job->cmd                         = *Msg;
+    job->queuedNs                    = FPGA_CTRL_MonotonicNs();
+    job->coreType                    = FPGA_CTRL_ACCEL_AES_CTRL;
+    ++regionSched.jobsDeferred;
+    FPGA_CTRL_PROBE1(encrypt__submit, 1);
+
+    return FPGA_CTRL_RegionSchedule();
+}
+
+// Loads a bitstream from the table by name, into its region if it's a partial one
+int32 FPGA_CTRL_LoadNamedModule(FPGA_CTRL_ReprogramNamedCmd_t const *const Msg)
+{
+    FPGA_CTRL_Table_t *tblPtr;
+    int32              err = CFE_STATUS_VALIDATION_FAILURE;
+
+    if (memchr(Msg->name, '\0', sizeof(Msg->name)) == NULL ||
+        CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0]) < CFE_SUCCESS)
+    {
+        return FPGA_CTRL_LoadNamedBitstream(Msg); // Reports the problem
+    }
+
+    for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+    {
+        FPGA_CTRL_BitstreamEntry_t const *const entry = &tblPtr->Bitstreams[i];
+        if (entry->Name[0] != '\0' && entry->Region != 0 && strcmp(entry->Name, Msg->name) == 0)
+        {
+            FPGA_CTRL_RegionReap();
+            err = FPGA_CTRL_RegionLoad(i, entry);
+            CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+            return err;
+        }
+    }
+
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+    return FPGA_CTRL_LoadNamedBitstream(Msg);
+}
+
+// Picks up a finished load, runs every queued job whose core is now loaded and starts loading the module the
+// remaining jobs want most, if they want it enough
+int32 FPGA_CTRL_RegionSchedule(void)
+{
+    FPGA_CTRL_Table_t *tblPtr;
+    int32              err = CFE_SUCCESS;
+
+    FPGA_CTRL_RegionReap();
+    FPGA_CTRL_RegionRunJobs();
+
+    if (regionSched.jobsQueued == 0 || reprogramJob.running)
+        return CFE_SUCCESS;
+
+    if ((err = CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0])) < CFE_SUCCESS)
+        return err;
+
+    uint32    demand, oldestMs;
+    int const module = FPGA_CTRL_RegionPickModule(tblPtr, &demand, &oldestMs);
+    if (module >= 0 && (demand >= tblPtr->RegionMinBatch || oldestMs >= tblPtr->RegionMaxWaitMs))
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                          "Loading module %s for %u queued jobs, oldest waited %u ms",
+                          tblPtr->Bitstreams[module].Name, (unsigned int)demand, (unsigned int)oldestMs);
+        err = FPGA_CTRL_RegionLoad(module, &tblPtr->Bitstreams[module]);
+    }
+
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+    return err;
+}
+
+void FPGA_CTRL_SendRegionTlm(void)
+{
+    static FPGA_CTRL_RegionTlm_t packet;
+
+    CFE_MSG_Init(&packet.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_REGION_TLM_MID), sizeof(packet));
+
+    int64 const  nowNs    = FPGA_CTRL_MonotonicNs();
+    uint64 const uptimeNs = nowNs > regionSched.startNs ? (uint64)(nowNs - regionSched.startNs) : 1;
+
+    packet.jobsQueued   = regionSched.jobsQueued;
+    packet.jobsDeferred = regionSched.jobsDeferred;
+    packet.jobsDropped  = regionSched.jobsDropped;
+    packet.maxWaitMs    = regionSched.maxWaitMs;
+
+    for (int i = 0; i < FPGA_CTRL_MAX_REGIONS; ++i)
+    {
+        FPGA_CTRL_Region_t const *const region = &regionSched.regions[i];
+        FPGA_CTRL_RegionStatus_t *const status = &packet.regions[i];
+        uint64 const                    occupiedNs =
+            region->occupiedNs + (region->state == FPGA_CTRL_REGION_LOADED ? nowNs - region->loadedSinceNs : 0);
+
+        memcpy(status->module, region->moduleName, sizeof(status->module));
+        status->state           = region->state;
+        status->occupancyPct    = (uint8)(occupiedNs * 100 / uptimeNs);
+        status->overheadPct     = (uint8)(region->reconfigNs * 100 / uptimeNs);
+        status->reconfigCount   = region->reconfigCount;
+        status->reconfigMsLast  = region->reconfigMsLast;
+        status->reconfigMsTotal = (uint32)(region->reconfigNs / 1000000);
+        status->jobsServed      = region->jobsServed;
+        status->jobsPerReconfig = region->reconfigCount != 0 ? region->jobsServed / region->reconfigCount : 0;
+    }
+
+    CFE_SB_TimeStampMsg(&packet.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&packet.TlmHeader.Msg, true);
+}
+
+// Takes over from the reprogram task once it's done: a partial load's cores are registered here, on the main task,
+// so the registry never changes under a running command
+static void FPGA_CTRL_RegionReap(void)
+{
+    if (reprogramJob.running || reprogramJob.completed == regionSched.lastCompleted)
+        return;
+    regionSched.lastCompleted = reprogramJob.completed;
+
+    int64 const nowNs = FPGA_CTRL_MonotonicNs();
+
+    if (reprogramJob.fabricReset)
+    {
+        // A full load replaced the design along with every module in it
+        for (int i = 0; i < FPGA_CTRL_MAX_REGIONS; ++i)
+        {
+            FPGA_CTRL_Region_t *const region = &regionSched.regions[i];
+            if (region->state == FPGA_CTRL_REGION_LOADED)
+                region->occupiedNs += nowNs - region->loadedSinceNs;
+            region->state         = FPGA_CTRL_REGION_EMPTY;
+            region->module        = -1;
+            region->moduleName[0] = '\0';
+        }
+        return;
+    }
+
+    if (reprogramJob.region == 0)
+        return;
+
+    FPGA_CTRL_Region_t *const region = &regionSched.regions[reprogramJob.region - 1];
+    region->reconfigMsLast           = (uint32)((nowNs - region->loadStartNs) / 1000000);
+    region->reconfigNs += nowNs - region->loadStartNs;
+    ++region->reconfigCount;
+
+    if (reprogramJob.result == CFE_SUCCESS)
+    {
+        FPGA_CTRL_AddAccels(region->accels);
+        region->state         = FPGA_CTRL_REGION_LOADED;
+        region->loadedSinceNs = nowNs;
+    }
+    else
+    {
+        // Retrying would most likely fail the same way, let the jobs go instead of reloading forever
+        FPGA_CTRL_RegionDropJobs(region->accels);
+        region->state         = FPGA_CTRL_REGION_EMPTY;
+        region->module        = -1;
+        region->moduleName[0] = '\0';
+    }
+
+    FPGA_CTRL_SendRegionTlm();
+}
+
+// Hands the queued jobs whose cores are loaded to FPGA_CTRL_Encrypt in the order they arrived, and keeps the rest in
+// order. Encrypt queues them for the one AES core, so the batch runs back to back, one job at a time. Those left
+// waiting for a free job slot are started on a later pass.
+static void FPGA_CTRL_RegionRunJobs(void)
+{
+    uint32 kept = 0;
+
+    for (uint32 i = 0; i < regionSched.jobsQueued; ++i)
+    {
+        FPGA_CTRL_RegionJob_t const *const job = &regionSched.jobs[i];
+        if (!globalState.fabricUp || FPGA_CTRL_GetAccel(job->coreType) == NULL || FPGA_CTRL_JobsFree() == 0)
+        {
+            regionSched.jobs[kept++] = *job;
+            continue;
+        }
+
+        uint32 const waitedMs = (uint32)((FPGA_CTRL_MonotonicNs() - job->queuedNs) / 1000000);
+        if (waitedMs > regionSched.maxWaitMs)
+            regionSched.maxWaitMs = waitedMs;
+
+        // Accepted when it was queued, so only a failure is counted now
+        if (FPGA_CTRL_Encrypt(&job->cmd) != CFE_SUCCESS)
+            ++globalState.ErrCounter;
+
+        for (int r = 0; r < FPGA_CTRL_MAX_REGIONS; ++r)
+        {
+            FPGA_CTRL_Region_t *const region = &regionSched.regions[r];
+            if (region->state == FPGA_CTRL_REGION_LOADED && FPGA_CTRL_AccelsProvide(region->accels, job->coreType))
+                ++region->jobsServed;
+        }
+    }
+
+    regionSched.jobsQueued = kept;
+}
+
+// Drops the queued jobs that run on any of the given cores
+static void FPGA_CTRL_RegionDropJobs(FPGA_CTRL_AccelDesc_t const *const accels)
+{
+    uint32 kept = 0;
+
+    for (uint32 i = 0; i < regionSched.jobsQueued; ++i)
+    {
+        if (FPGA_CTRL_AccelsProvide(accels, regionSched.jobs[i].coreType))
+            ++regionSched.jobsDropped;
+        else
+            regionSched.jobs[kept++] = regionSched.jobs[i];
+    }
+
+    if (kept != regionSched.jobsQueued)
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "Module failed to load, dropped %u queued jobs",
+                          (unsigned int)(regionSched.jobsQueued - kept));
+    regionSched.jobsQueued = kept;
+}
+
+// The module with the most queued jobs, ties going to the one whose oldest job has waited longest. Modules whose
+// region is busy loading, that are loaded already, or whose region's AES core is still working through a batch are
+// passed over. Returns its table index, or -1 if no module can run the queued jobs.
+static int FPGA_CTRL_RegionPickModule(FPGA_CTRL_Table_t const *const tbl, uint32 *const demand, uint32 *const oldestMs)
+{
+    int64 const nowNs = FPGA_CTRL_MonotonicNs();
+    int         best  = -1;
+
+    *demand   = 0;
+    *oldestMs = 0;
+
+    for (int i = 0; i < FPGA_CTRL_MAX_BITSTREAMS; ++i)
+    {
+        FPGA_CTRL_BitstreamEntry_t const *const entry = &tbl->Bitstreams[i];
+        if (entry->Name[0] == '\0' || entry->Region == 0 || entry->Region > FPGA_CTRL_MAX_REGIONS)
+            continue;
+
+        FPGA_CTRL_Region_t const *const region = &regionSched.regions[entry->Region - 1];
+        if (region->state == FPGA_CTRL_REGION_LOADING ||
+            (region->state == FPGA_CTRL_REGION_LOADED &&
+             (region->module == i ||
+              (FPGA_CTRL_AccelsProvide(region->accels, FPGA_CTRL_ACCEL_AES_CTRL) && FPGA_CTRL_EncryptsPending() != 0))))
+        {
+            continue;
+        }
+
+        uint32 count = 0, waitedMs = 0;
+        for (uint32 j = 0; j < regionSched.jobsQueued; ++j)
+        {
+            FPGA_CTRL_RegionJob_t const *const job = &regionSched.jobs[j];
+            if (!FPGA_CTRL_AccelsProvide(entry->Accels, job->coreType))
+                continue;
+
+            ++count;
+            uint32 const jobWaitedMs = (uint32)((nowNs - job->queuedNs) / 1000000);
+            if (jobWaitedMs > waitedMs)
+                waitedMs = jobWaitedMs;
+        }
+
+        if (count > *demand || (count == *demand && count != 0 && waitedMs > *oldestMs))
+        {
+            best      = i;
+            *demand   = count;
+            *oldestMs = waitedMs;
+        }
+    }
+
+    return best;
+}
+
+// Empties the module's region and hands the load to the reprogram task
+static int32 FPGA_CTRL_RegionLoad(int const module, FPGA_CTRL_BitstreamEntry_t const *const entry)
+{
+    FPGA_CTRL_Region_t *const region = &regionSched.regions[entry->Region - 1];
+    int32                     err;
+
+    if (reprogramJob.running)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "Reprogramming with %s already in progress",
+                          reprogramJob.name[0] != '\0' ? reprogramJob.name : reprogramJob.path);
+        return CFE_STATUS_INCORRECT_STATE;
+    }
+
+    int64 const nowNs = FPGA_CTRL_MonotonicNs();
+    FPGA_CTRL_RegionVacate(region, nowNs);
+
+    region->state       = FPGA_CTRL_REGION_LOADING;
+    region->module      = module;
+    region->loadStartNs = nowNs;
+    memcpy(region->moduleName, entry->Name, sizeof(region->moduleName));
+    memcpy(region->accels, entry->Accels, sizeof(region->accels));
+
+    memcpy(reprogramJob.name, entry->Name, sizeof(reprogramJob.name));
+    reprogramJob.path[0]         = '\0';
+    reprogramJob.firmwareName[0] = '\0';
+    reprogramJob.region          = entry->Region;
+    if ((err = FPGA_CTRL_StartReprogramJob(reprogramJob.name)) != CFE_SUCCESS)
+    {
+        region->state         = FPGA_CTRL_REGION_EMPTY;
+        region->module        = -1;
+        region->moduleName[0] = '\0';
+    }
+
+    return err;
+}
+
+// Drops the region's cores from the registry before its module is replaced
+static void FPGA_CTRL_RegionVacate(FPGA_CTRL_Region_t *const region, int64 const nowNs)
+{
+    if (region->state != FPGA_CTRL_REGION_LOADED)
+        return;
+
+    FPGA_CTRL_RemoveAccels(region->accels);
+    region->occupiedNs += nowNs - region->loadedSinceNs;
+    region->state = FPGA_CTRL_REGION_EMPTY;
+}
+
+static bool FPGA_CTRL_AccelsProvide(FPGA_CTRL_AccelDesc_t const *const accels, uint32 const type)
+{
+    for (int i = 0; i < FPGA_CTRL_MAX_ACCELS; ++i)
+    {
+        if (accels[i].Type == type)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,374 @@
+// GPIO sampling acquisition: samples the button and switch GPIO data registers at a fixed rate into double-buffered
+// blocks, run-length encodes them and sends them as bulk telemetry or appends them to a file.
+
+#include <string.h>
+#include <time.h>
+
+#include "cfe.h"
+#include "mmio_lib.h"
+#include "fpga_ctrl.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_SAMPLE_BLOCK_LEN   1024 // Samples per block
+#define FPGA_CTRL_SAMPLE_NUM_BLOCKS  2    // Double buffered
+#define FPGA_CTRL_SAMPLE_MAX_RATE_HZ 100000
+#define FPGA_CTRL_SAMPLE_WAIT_MS     500 // How often the writer checks whether it should exit
+
+// One block of raw samples. The sampler owns it while full is false, the writer while it is true.
+typedef struct
+{
+    uint16      samples[FPGA_CTRL_SAMPLE_BLOCK_LEN]; // Switches in the high byte, buttons in the low byte
+    uint32      count;
+    uint32      seq;
+    atomic_bool full;
+} FPGA_CTRL_SampleBlock_t;
+
+typedef struct
+{
+    FPGA_CTRL_SampleBlock_t blocks[FPGA_CTRL_SAMPLE_NUM_BLOCKS];
+    osal_id_t               blockReadySem; // Given by the sampler whenever a block is handed to the writer
+    bool                    semCreated;
+    uint32                  rateHz;
+    uint8                   output; // FPGA_CTRL_SAMPLE_OUTPUT_*
+    char                    path[sizeof(((FPGA_CTRL_SamplingCmd_t *)NULL)->path)];
+    osal_id_t               fileId;
+    atomic_bool             samplerRunning;
+    atomic_bool             writerRunning;
+    atomic_bool             shouldExit;
+} FPGA_CTRL_Sampler_t;
+
+static FPGA_CTRL_Sampler_t sampler;
+
+// Exported function
+int32 FPGA_CTRL_Sampling(FPGA_CTRL_SamplingCmd_t const *Msg);
+
+static void   FPGA_CTRL_SampleTask(void);
+static void   FPGA_CTRL_SampleWriterTask(void);
+static void   FPGA_CTRL_DrainSampleBlocks(void);
+static uint32 FPGA_CTRL_RleEncode(FPGA_CTRL_SampleRun_t *runs, uint16 const *samples, uint32 count);
+static void   FPGA_CTRL_EmitSampleBlock(FPGA_CTRL_SampleBlock_t const *block);
+
+int32 FPGA_CTRL_Sampling(FPGA_CTRL_SamplingCmd_t const *Msg)
+{
+    int32           err;
+    CFE_ES_TaskId_t taskId;
+
+    if (!Msg->enable)
+    {
+        if (!sampler.samplerRunning)
+        {
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Sampling already stopped");
+            return CFE_ES_ERR_CHILD_TASK_DELETE;
+        }
+
+        // Both tasks check this between samples/blocks and exit on their own
+        sampler.shouldExit = true;
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "FPGA_CTRL: Stopping sampling");
+        return CFE_SUCCESS;
+    }
+
+    if (sampler.samplerRunning || sampler.writerRunning)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Sampling already running");
+        return CFE_ES_ERR_CHILD_TASK_CREATE;
+    }
+
+    if (Msg->rateHz == 0 || Msg->rateHz > FPGA_CTRL_SAMPLE_MAX_RATE_HZ ||
+        (Msg->output != FPGA_CTRL_SAMPLE_OUTPUT_TLM && Msg->output != FPGA_CTRL_SAMPLE_OUTPUT_FILE))
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Invalid sampling parameters, rate = %u Hz, output = %u",
+                          (unsigned int)Msg->rateHz, (unsigned int)Msg->output);
+        return CFE_ES_BAD_ARGUMENT;
+    }
+
+    if (FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_GPIO_BTN) == NULL || FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_GPIO_SW) == NULL)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: The loaded design has no GPIO to sample");
+        return CFE_STATUS_INCORRECT_STATE;
+    }
+
+    if (!sampler.semCreated)
+    {
+        if ((err = OS_BinSemCreate(&sampler.blockReadySem, "FPGA_CTRL smp sem", OS_SEM_EMPTY, 0)) != OS_SUCCESS)
+        {
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                              "FPGA_CTRL: Failed to create sampling semaphore: %d", err);
+            return err;
+        }
+        sampler.semCreated = true;
+    }
+
+    sampler.rateHz = Msg->rateHz;
+    sampler.output = Msg->output;
+    strncpy(sampler.path, Msg->path, sizeof(sampler.path) - 1);
+    sampler.path[sizeof(sampler.path) - 1] = '\0';
+
+    if (sampler.output == FPGA_CTRL_SAMPLE_OUTPUT_FILE)
+    {
+        if ((err = OS_OpenCreate(&sampler.fileId, sampler.path, OS_FILE_FLAG_CREATE | OS_FILE_FLAG_TRUNCATE,
+                                 OS_WRITE_ONLY)) != OS_SUCCESS)
+        {
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                              "FPGA_CTRL: Failed to open sample file %s: %d", sampler.path, err);
+            return err;
+        }
+    }
+
+    for (int i = 0; i < FPGA_CTRL_SAMPLE_NUM_BLOCKS; ++i)
+    {
+        sampler.blocks[i].count = 0;
+        sampler.blocks[i].full  = false;
+    }
+    // Neither sampling task is running, the main task owns the blocks until they start
+    FPGA_CTRL_StatsBegin(&globalState.SampleStats.lock);
+    globalState.SampleStats.taken   = 0;
+    globalState.SampleStats.dropped = 0;
+    FPGA_CTRL_StatsEnd(&globalState.SampleStats.lock);
+    FPGA_CTRL_StatsBegin(&globalState.SampleWriterStats.lock);
+    globalState.SampleWriterStats.blocks = 0;
+    FPGA_CTRL_StatsEnd(&globalState.SampleWriterStats.lock);
+    sampler.shouldExit = false;
+
+    // Start the writer first so a block is never handed off with nobody to take it
+    sampler.writerRunning = true;
+    if ((err = CFE_ES_CreateChildTask(&taskId, "FPGA_CTRL smp write", FPGA_CTRL_SampleWriterTask,
+                                      CFE_ES_TASK_STACK_ALLOCATE, CFE_PLATFORM_ES_DEFAULT_STACK_SIZE,
+                                      CFE_PLATFORM_ES_PERF_CHILD_PRIORITY, 0)) < CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to create sample writer task: 0x%x", err);
+        sampler.writerRunning = false;
+        if (sampler.output == FPGA_CTRL_SAMPLE_OUTPUT_FILE)
+            OS_close(sampler.fileId);
+        return err;
+    }
+
+    sampler.samplerRunning = true;
+    if ((err = CFE_ES_CreateChildTask(&taskId, "FPGA_CTRL sampler", FPGA_CTRL_SampleTask, CFE_ES_TASK_STACK_ALLOCATE,
+                                      CFE_PLATFORM_ES_DEFAULT_STACK_SIZE, CFE_PLATFORM_ES_PERF_CHILD_PRIORITY, 0)) <
+        CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to create sampler task: 0x%x", err);
+        sampler.samplerRunning = false;
+        sampler.shouldExit     = true; // Writer closes the file on its way out
+        return err;
+    }
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "FPGA_CTRL: Sampling GPIO at %u Hz to %s", (unsigned int)sampler.rateHz,
+                      sampler.output == FPGA_CTRL_SAMPLE_OUTPUT_FILE ? sampler.path : "telemetry");
+
+    return CFE_SUCCESS;
+}
+
+// Samples the GPIO data registers on a fixed period, filling blocks and handing them to the writer
+static void FPGA_CTRL_SampleTask(void)
+{
+    FPGA_CTRL_ApplyChildSchedProfile(0);
+
+    // Checked when sampling was started, and reprogramming is refused while it runs
+    void volatile *const btnBase = FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_GPIO_BTN)->base;
+    void volatile *const swBase  = FPGA_CTRL_GetAccel(FPGA_CTRL_ACCEL_GPIO_SW)->base;
+
+    int64 const periodNs = 1000000000LL / sampler.rateHz;
+    uint32      fill     = 0; // Index of the block being filled
+    uint32      seq      = 0;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    while (!sampler.shouldExit)
+    {
+        deadline.tv_nsec += periodNs;
+        while (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_nsec -= 1000000000L;
+            ++deadline.tv_sec;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+
+        // Any whole periods we slept through are samples we never took
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64 const lateNs =
+            (int64)(now.tv_sec - deadline.tv_sec) * 1000000000LL + (int64)(now.tv_nsec - deadline.tv_nsec);
+        if (lateNs >= periodNs)
+        {
+            int64 const missed = lateNs / periodNs;
+            FPGA_CTRL_StatsBegin(&globalState.SampleStats.lock);
+            globalState.SampleStats.dropped += (uint32)missed;
+            FPGA_CTRL_StatsEnd(&globalState.SampleStats.lock);
+            deadline = now;
+        }
+
+        CFE_ES_PerfLogEntry(FPGA_CTRL_SAMPLE_PERF_ID);
+        uint16 const sample = (uint16)(*(uint8 volatile *)swBase << 8 | *(uint8 volatile *)btnBase);
+
+        FPGA_CTRL_SampleBlock_t *const block = &sampler.blocks[fill];
+        if (block->full)
+        {
+            // The writer still owns both blocks, nowhere to put this sample
+            FPGA_CTRL_StatsBegin(&globalState.SampleStats.lock);
+            ++globalState.SampleStats.dropped;
+            FPGA_CTRL_StatsEnd(&globalState.SampleStats.lock);
+            CFE_ES_PerfLogExit(FPGA_CTRL_SAMPLE_PERF_ID);
+            continue;
+        }
+
+        if (block->count == 0)
+            block->seq = seq++;
+        block->samples[block->count++] = sample;
+        FPGA_CTRL_StatsBegin(&globalState.SampleStats.lock);
+        ++globalState.SampleStats.taken;
+        FPGA_CTRL_StatsEnd(&globalState.SampleStats.lock);
+
+        if (block->count == FPGA_CTRL_SAMPLE_BLOCK_LEN)
+        {
+            block->full = true;
+            OS_BinSemGive(sampler.blockReadySem);
+            fill = (fill + 1) % FPGA_CTRL_SAMPLE_NUM_BLOCKS;
+        }
+        CFE_ES_PerfLogExit(FPGA_CTRL_SAMPLE_PERF_ID);
+    }
+
+    // Flush the partial block so a stop doesn't lose the tail of the capture
+    if (sampler.blocks[fill].count > 0 && !sampler.blocks[fill].full)
+    {
+        sampler.blocks[fill].full = true;
+        OS_BinSemGive(sampler.blockReadySem);
+    }
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                      "FPGA_CTRL: Sampling stopped, %u samples taken, %u dropped",
+                      (unsigned int)globalState.SampleStats.taken, (unsigned int)globalState.SampleStats.dropped);
+    sampler.samplerRunning = false;
+    CFE_ES_ExitChildTask();
+}
+
+// Takes full blocks off the sampler, encodes and emits them in sequence order
+static void FPGA_CTRL_SampleWriterTask(void)
+{
+    FPGA_CTRL_ApplyChildSchedProfile(0);
+
+    do
+    {
+        OS_BinSemTimedWait(sampler.blockReadySem, FPGA_CTRL_SAMPLE_WAIT_MS);
+        CFE_ES_PerfLogEntry(FPGA_CTRL_SAMPLE_WRITE_PERF_ID);
+        FPGA_CTRL_DrainSampleBlocks();
+        CFE_ES_PerfLogExit(FPGA_CTRL_SAMPLE_WRITE_PERF_ID);
+    } while (sampler.samplerRunning || !sampler.shouldExit);
+
+    // The sampler may have flushed its last partial block after the final drain above
+    FPGA_CTRL_DrainSampleBlocks();
+
+    if (sampler.output == FPGA_CTRL_SAMPLE_OUTPUT_FILE)
+        OS_close(sampler.fileId);
+
+    sampler.writerRunning = false;
+    CFE_ES_ExitChildTask();
+}
+
+// Emits every full block, oldest first, and hands each back to the sampler
+static void FPGA_CTRL_DrainSampleBlocks(void)
+{
+    FPGA_CTRL_SampleBlock_t *oldest;
+
+    do
+    {
+        oldest = NULL;
+        for (int i = 0; i < FPGA_CTRL_SAMPLE_NUM_BLOCKS; ++i)
+        {
+            FPGA_CTRL_SampleBlock_t *const block = &sampler.blocks[i];
+            if (block->full && (oldest == NULL || block->seq < oldest->seq))
+                oldest = block;
+        }
+
+        if (oldest != NULL)
+        {
+            FPGA_CTRL_EmitSampleBlock(oldest);
+            FPGA_CTRL_StatsBegin(&globalState.SampleWriterStats.lock);
+            ++globalState.SampleWriterStats.blocks;
+            FPGA_CTRL_StatsEnd(&globalState.SampleWriterStats.lock);
+            oldest->count = 0;
+            oldest->full  = false;
+        }
+    } while (oldest != NULL);
+}
+
+// Collapses consecutive identical samples into runs, returns the number of runs written
+static uint32 FPGA_CTRL_RleEncode(FPGA_CTRL_SampleRun_t *const runs, uint16 const *const samples, uint32 const count)
+{
+    uint32 numRuns = 0;
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        if (numRuns > 0 && runs[numRuns - 1].value == samples[i] && runs[numRuns - 1].length < UINT16_MAX)
+        {
+            ++runs[numRuns - 1].length;
+        }
+        else
+        {
+            runs[numRuns].value  = samples[i];
+            runs[numRuns].length = 1;
+            ++numRuns;
+        }
+    }
+
+    return numRuns;
+}
+
+static void FPGA_CTRL_EmitSampleBlock(FPGA_CTRL_SampleBlock_t const *const block)
+{
+    int32 err;
+
+    static FPGA_CTRL_SampleRun_t runs[FPGA_CTRL_SAMPLE_BLOCK_LEN]; // Worst case is one run per sample
+    uint32 const                 numRuns = FPGA_CTRL_RleEncode(runs, block->samples, block->count);
+
+    if (sampler.output == FPGA_CTRL_SAMPLE_OUTPUT_FILE)
+    {
+        FPGA_CTRL_SampleBlockHeader_t const header = {
+            .blockSeq    = block->seq,
+            .rateHz      = sampler.rateHz,
+            .sampleCount = (uint16)block->count,
+            .runCount    = (uint16)numRuns,
+        };
+        if ((err = OS_write(sampler.fileId, &header, sizeof(header))) != sizeof(header) ||
+            (err = OS_write(sampler.fileId, runs, numRuns * sizeof(runs[0]))) != (int32)(numRuns * sizeof(runs[0])))
+        {
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                              "FPGA_CTRL: Failed to write sample block %u: %d", (unsigned int)block->seq, err);
+        }
+        return;
+    }
+
+    // Telemetry: split the runs across as many packets as needed
+    static FPGA_CTRL_SampleTlm_t packet;
+    for (uint32 first = 0; first < numRuns; first += FPGA_CTRL_SAMPLE_RUNS_PER_TLM)
+    {
+        uint32 const inPacket =
+            numRuns - first < FPGA_CTRL_SAMPLE_RUNS_PER_TLM ? numRuns - first : FPGA_CTRL_SAMPLE_RUNS_PER_TLM;
+
+        CFE_MSG_Init(&packet.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_SAMPLE_TLM_MID),
+                     offsetof(FPGA_CTRL_SampleTlm_t, runs) + inPacket * sizeof(packet.runs[0]));
+        packet.header.blockSeq    = block->seq;
+        packet.header.rateHz      = sampler.rateHz;
+        packet.header.sampleCount = (uint16)block->count;
+        packet.header.runCount    = (uint16)numRuns;
+        packet.firstRun           = (uint16)first;
+        packet.runsInPacket       = (uint16)inPacket;
+        memcpy(packet.runs, &runs[first], inPacket * sizeof(runs[0]));
+
+        CFE_SB_TimeStampMsg(&packet.TlmHeader.Msg);
+        if ((err = CFE_SB_TransmitMsg(&packet.TlmHeader.Msg, true)) < CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                              "FPGA_CTRL: Failed to send sample block %u: 0x%08x", (unsigned int)block->seq, err);
+            return;
+        }
+    }
+}
@@ -0,0 +1,155 @@
+// Real-time scheduling profile for the main and interrupt tasks: priority, CPU affinity, memory locking, stack
+// prefaulting and steering the UIO IRQ to the interrupt task's cores. Linux specific.
+// Child tasks inherit the creating task's CPU affinity, so every child applies its own mask first thing. The helper
+// children (reprogram, sampling, timed, load generator) take 0, which lets them run on any core rather than sharing
+// the main task's cores at a lower priority.
+
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+#include "fpga_ctrl_table.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_SCHED_MAX_PREFAULT_BYTES (64 * 1024) // Upper bound on how much stack is touched up front
+#define FPGA_CTRL_SCHED_ANY_CPU            0xFFFFFFFFu  // Every core a mask can name
+
+// Exported functions
+void FPGA_CTRL_LoadSchedProfile(void);
+void FPGA_CTRL_ApplyMainSchedProfile(void);
+void FPGA_CTRL_ApplyChildSchedProfile(uint32 cpuMask);
+
+static int32 FPGA_CTRL_SetCpuAffinity(uint32 cpuMask);
+static void  FPGA_CTRL_PrefaultStack(uint32 bytes);
+static int32 FPGA_CTRL_SteerIrq(uint16 irq, uint32 cpuMask);
+
+// Copies the scheduling profile out of the table into globalState so the child can read it without the table
+void FPGA_CTRL_LoadSchedProfile(void)
+{
+    FPGA_CTRL_Table_t *tblPtr;
+
+    memset(&globalState.SchedProfile, 0, sizeof(globalState.SchedProfile));
+
+    if (CFE_TBL_GetAddress((void **)&tblPtr, globalState.TblHandles[0]) < CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Couldn't read table, using default scheduling");
+        return;
+    }
+
+    globalState.SchedProfile = tblPtr->Sched;
+
+    CFE_TBL_ReleaseAddress(globalState.TblHandles[0]);
+}
+
+// Applies the process-wide and main task parts of the profile, called once from the main task during init.
+// Failures are reported but not fatal, the app still works with default scheduling.
+void FPGA_CTRL_ApplyMainSchedProfile(void)
+{
+    int32                          err;
+    FPGA_CTRL_SchedProfile_t const *profile = &globalState.SchedProfile;
+
+    if (profile->LockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: mlockall() failed, memory isn't locked");
+    }
+
+    if (profile->MainPriority != 0 &&
+        (err = OS_TaskSetPriority(OS_TaskGetId(), (osal_priority_t)profile->MainPriority)) != OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to set main task priority %u: %d", (unsigned int)profile->MainPriority,
+                          err);
+    }
+
+    FPGA_CTRL_SetCpuAffinity(profile->MainCpuMask);
+
+    if (profile->PrefaultStack)
+        FPGA_CTRL_PrefaultStack(profile->StackPrefaultBytes);
+
+    // Deliver the GPIO interrupt on the same cores the child that services it runs on
+    if (profile->UioIrqNumber != 0 && profile->IrqTaskCpuMask != 0)
+        FPGA_CTRL_SteerIrq(profile->UioIrqNumber, profile->IrqTaskCpuMask);
+}
+
+// Applies the per-task parts of the profile, called by a child task on itself before its main loop. A cpuMask of 0
+// undoes the main task's pinning, the child may then run on any core.
+void FPGA_CTRL_ApplyChildSchedProfile(uint32 const cpuMask)
+{
+    if (cpuMask != 0)
+        FPGA_CTRL_SetCpuAffinity(cpuMask);
+    else if (globalState.SchedProfile.MainCpuMask != 0)
+        FPGA_CTRL_SetCpuAffinity(FPGA_CTRL_SCHED_ANY_CPU);
+
+    if (globalState.SchedProfile.PrefaultStack)
+        FPGA_CTRL_PrefaultStack(globalState.SchedProfile.StackPrefaultBytes);
+}
+
+// Pins the calling task to the cores in cpuMask, 0 leaves it free to run anywhere
+static int32 FPGA_CTRL_SetCpuAffinity(uint32 const cpuMask)
+{
+    if (cpuMask == 0)
+        return CFE_SUCCESS;
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu = 0; cpu < 32; ++cpu)
+    {
+        if (cpuMask & (1u << cpu))
+            CPU_SET(cpu, &cpuSet);
+    }
+
+    // pid 0 is the calling thread
+    if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to set CPU affinity 0x%x", (unsigned int)cpuMask);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Touches the top of the stack so the first deep call on the hot path doesn't take page faults.
+// The table validation keeps bytes well inside the smallest task stack.
+static void FPGA_CTRL_PrefaultStack(uint32 const bytes)
+{
+    uint32 const   len = bytes < FPGA_CTRL_SCHED_MAX_PREFAULT_BYTES ? bytes : FPGA_CTRL_SCHED_MAX_PREFAULT_BYTES;
+    uint8 volatile stackBuf[len > 0 ? len : 1];
+
+    for (uint32 i = 0; i < len; i += 256)
+        stackBuf[i] = 0;
+    (void)stackBuf[0];
+}
+
+// Writes cpuMask to /proc/irq/<irq>/smp_affinity
+static int32 FPGA_CTRL_SteerIrq(uint16 const irq, uint32 const cpuMask)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/irq/%u/smp_affinity", (unsigned int)irq);
+
+    FILE *const affinityFile = fopen(path, "w");
+    if (affinityFile == NULL)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "FPGA_CTRL: Failed to open %s", path);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    int const written = fprintf(affinityFile, "%x\n", (unsigned int)cpuMask);
+    if (fclose(affinityFile) != 0 || written < 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to steer IRQ %u to CPUs 0x%x", (unsigned int)irq, (unsigned int)cpuMask);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "FPGA_CTRL: Steered IRQ %u to CPUs 0x%x",
+                      (unsigned int)irq, (unsigned int)cpuMask);
+    return CFE_SUCCESS;
+}
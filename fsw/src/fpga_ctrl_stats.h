@@ -0,0 +1,69 @@
+// Seqlocks over the statistics blocks the child tasks share with housekeeping. The task that owns a block brackets
+// every update with FPGA_CTRL_StatsBegin and FPGA_CTRL_StatsEnd, leaving the block's sequence odd while it changes.
+// A reader copies the whole block and takes the copy only if the sequence was even and the same before and after, so
+// it always sees one consistent update. The owner never waits on a reader. A reader only retries a bounded number
+// of times: a child task preempted mid-update by housekeeping on the same CPU, at a higher priority, can't finish
+// the update while the reader spins, so after that the reader keeps the last consistent copy it took instead.
+// Since only the owner stores to a block its counters are plain integers, the owner reads them back directly.
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+
+#define FPGA_CTRL_STATS_READ_TRIES 64 // Looks at the sequence this often before settling for the last copy
+#define FPGA_CTRL_STATS_MAX_SIZE   (2 * FPGA_CTRL_CACHE_LINE) // Largest block, the blocks are a cache line or two
+
+// Exported functions
+void FPGA_CTRL_StatsBegin(FPGA_CTRL_SeqLock_t *lock);
+void FPGA_CTRL_StatsEnd(FPGA_CTRL_SeqLock_t *lock);
+bool FPGA_CTRL_StatsRead(void *snapshot, void const *block, size_t size);
+
+// Called by the block's owner before it changes any counter
+void FPGA_CTRL_StatsBegin(FPGA_CTRL_SeqLock_t *const lock)
+{
+    unsigned int const seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_relaxed);
+
+    // The odd sequence is visible before any of the counter stores
+    atomic_thread_fence(memory_order_release);
+}
+
+// Publishes the changes made since FPGA_CTRL_StatsBegin
+void FPGA_CTRL_StatsEnd(FPGA_CTRL_SeqLock_t *const lock)
+{
+    unsigned int const seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_release);
+}
+
+// Copies a block, starting with its FPGA_CTRL_SeqLock_t, as of the end of one update. The copy is taken into a
+// scratch buffer, so if the owner stays mid-update for every try the snapshot is left as the last consistent copy
+// and false is returned. Callers keep their snapshots from one read to the next for that.
+bool FPGA_CTRL_StatsRead(void *const snapshot, void const *const block, size_t const size)
+{
+    FPGA_CTRL_SeqLock_t *const lock = (FPGA_CTRL_SeqLock_t *)block;
+    _Alignas(FPGA_CTRL_CACHE_LINE) uint8 copy[FPGA_CTRL_STATS_MAX_SIZE];
+
+    if (size > sizeof(copy))
+        return false;
+
+    for (uint32 tries = 0; tries < FPGA_CTRL_STATS_READ_TRIES; ++tries)
+    {
+        unsigned int const before = atomic_load_explicit(&lock->seq, memory_order_acquire);
+        if (before & 1)
+            continue; // Updates are a few stores, not worth yielding for
+
+        memcpy(copy, block, size);
+
+        // The copy is complete before the sequence is checked again
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&lock->seq, memory_order_relaxed) == before)
+        {
+            memcpy(snapshot, copy, size);
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,414 @@
+// Time-tagged commands. Each is held in a hierarchical timer wheel until its tag comes round, then a child task sends
+// it back to the app on its command MID so it runs through the normal dispatch, checks and statistics included.
+// The wheel has 4 levels of 64 slots over 1 ms ticks, each slot of a level spanning a full turn of the level below,
+// so queueing and expiring a command are constant time. Commands further out than the top level's turn (about
+// 4.6 hours) park in its last slot and are placed again when it comes round.
+// Tags are converted to CLOCK_MONOTONIC when queued and the child waits for them with absolute timeouts, sleeping to
+// the earliest deadline in the next occupied tick so commands go out at their tag rather than on a tick boundary.
+
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+
+// Defined in fpga_ctrl.c
+extern FPGA_CTRL_Data_t globalState;
+
+#define FPGA_CTRL_TIMED_MAX_ENTRIES 64
+#define FPGA_CTRL_TIMED_IDLE_WAIT_MS 500 // How often the child checks whether it should exit while nothing is queued
+#define FPGA_CTRL_WHEEL_LEVELS      4
+#define FPGA_CTRL_WHEEL_BITS        6
+#define FPGA_CTRL_WHEEL_SLOTS       (1u << FPGA_CTRL_WHEEL_BITS)
+#define FPGA_CTRL_WHEEL_MASK        (FPGA_CTRL_WHEEL_SLOTS - 1)
+#define FPGA_CTRL_WHEEL_TICK_NS     1000000
+
+typedef struct FPGA_CTRL_TimedEntry
+{
+    struct FPGA_CTRL_TimedEntry *next;
+    int64                        deadlineNs;  // CLOCK_MONOTONIC
+    uint64                       expiresTick; // Wheel tick holding the deadline
+    CFE_SB_MsgId_Atom_t          msgId;       // Where the command is sent when it's due
+    uint8                        fcnCode;
+    uint16                       length;
+    uint8                        payload[FPGA_CTRL_TIMED_MAX_PAYLOAD];
+} FPGA_CTRL_TimedEntry_t;
+
+typedef struct
+{
+    FPGA_CTRL_TimedEntry_t  entries[FPGA_CTRL_TIMED_MAX_ENTRIES];
+    FPGA_CTRL_TimedEntry_t *freeList;
+    FPGA_CTRL_TimedEntry_t *slots[FPGA_CTRL_WHEEL_LEVELS][FPGA_CTRL_WHEEL_SLOTS]; // Unordered lists
+    uint64                  tick;   // Next tick to expire
+    int64                   baseNs; // Start of tick 0
+    uint32                  inWheel;
+
+    // Statistics, under the lock like the wheel
+    uint32 queued; // In the wheel or being sent
+    uint32 peakQueued;
+    uint32 accepted;
+    uint32 rejected;
+    uint32 released;
+    uint32 jitterUsLast; // Send time against the tag
+    uint32 jitterUsMax;
+    uint64 jitterUsTotal;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  wake; // Signalled when a command is queued or the child should exit
+    bool            syncCreated;
+    CFE_ES_TaskId_t taskId;
+    atomic_bool     taskRunning;
+    atomic_bool     shouldExit;
+} FPGA_CTRL_TimedQueue_t;
+
+static FPGA_CTRL_TimedQueue_t timedQueue;
+
+// Exported functions
+int32 FPGA_CTRL_InitTimedQueue(void);
+void  FPGA_CTRL_CleanupTimedQueue(void);
+int32 FPGA_CTRL_ScheduleTimedCmd(FPGA_CTRL_TimedCmd_t const *Msg, size_t size, bool priority);
+void  FPGA_CTRL_SendTimedTlm(void);
+
+static void  FPGA_CTRL_TimedTask(void);
+static void  FPGA_CTRL_TimedRelease(FPGA_CTRL_TimedEntry_t *expired);
+static void  FPGA_CTRL_WheelInsert(FPGA_CTRL_TimedEntry_t *entry);
+static void  FPGA_CTRL_WheelAdvance(int64 nowNs, FPGA_CTRL_TimedEntry_t **expired);
+static int64 FPGA_CTRL_WheelNextWakeNs(void);
+
+// Sets up the wheel and starts the child that releases the commands
+int32 FPGA_CTRL_InitTimedQueue(void)
+{
+    pthread_condattr_t attr;
+    int32              err;
+
+    memset(&timedQueue, 0, sizeof(timedQueue));
+    for (int i = FPGA_CTRL_TIMED_MAX_ENTRIES - 1; i >= 0; --i)
+    {
+        timedQueue.entries[i].next = timedQueue.freeList;
+        timedQueue.freeList        = &timedQueue.entries[i];
+    }
+    timedQueue.baseNs = FPGA_CTRL_MonotonicNs();
+
+    // Deadlines are on the monotonic clock, so the waits have to be too
+    if (pthread_mutex_init(&timedQueue.lock, NULL) != 0 || pthread_condattr_init(&attr) != 0 ||
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) != 0 || pthread_cond_init(&timedQueue.wake, &attr) != 0)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to create time-tagged command queue lock");
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+    pthread_condattr_destroy(&attr);
+    timedQueue.syncCreated = true;
+
+    timedQueue.taskRunning = true;
+    if ((err = CFE_ES_CreateChildTask(&timedQueue.taskId, "FPGA_CTRL timed", FPGA_CTRL_TimedTask,
+                                      CFE_ES_TASK_STACK_ALLOCATE, CFE_PLATFORM_ES_DEFAULT_STACK_SIZE,
+                                      CFE_PLATFORM_ES_PERF_CHILD_PRIORITY, 0)) < CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                          "FPGA_CTRL: Failed to create time-tagged command task: 0x%x", err);
+        timedQueue.taskRunning = false;
+        return err;
+    }
+
+    return CFE_SUCCESS;
+}
+
+// Asks the child to exit, commands still queued are dropped with the app
+void FPGA_CTRL_CleanupTimedQueue(void)
+{
+    if (!timedQueue.syncCreated)
+        return;
+
+    pthread_mutex_lock(&timedQueue.lock);
+    timedQueue.shouldExit = true;
+    pthread_cond_signal(&timedQueue.wake);
+    pthread_mutex_unlock(&timedQueue.lock);
+}
+
+// Queues the command wrapped in Msg for its tag. Commands the app serves on its priority MID are released there.
+int32 FPGA_CTRL_ScheduleTimedCmd(FPGA_CTRL_TimedCmd_t const *const Msg, size_t const size, bool const priority)
+{
+    size_t const payloadStart = offsetof(FPGA_CTRL_TimedCmd_t, payload);
+
+    if (size < payloadStart || Msg->length > size - payloadStart)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "Time-tagged command runs past the end of the message");
+        return CFE_STATUS_WRONG_MSG_LENGTH;
+    }
+
+    // A tagged command that tags another could keep itself queued forever
+    if (Msg->fcnCode == FPGA_CTRL_TIMED_CC)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR, "Time-tagged commands don't nest");
+        return CFE_STATUS_BAD_COMMAND_CODE;
+    }
+
+    if (!timedQueue.taskRunning)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "Time-tagged command task isn't running");
+        return CFE_STATUS_INCORRECT_STATE;
+    }
+
+    CFE_TIME_SysTime_t const tag = {.Seconds = Msg->seconds, .Subseconds = Msg->subseconds};
+    CFE_TIME_SysTime_t const now = CFE_TIME_GetTime();
+    if (CFE_TIME_Compare(tag, now) != CFE_TIME_A_GT_B)
+    {
+        pthread_mutex_lock(&timedQueue.lock);
+        ++timedQueue.rejected;
+        pthread_mutex_unlock(&timedQueue.lock);
+        CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "Tag %u.%06u of CC %u is in the past", (unsigned int)tag.Seconds,
+                          (unsigned int)CFE_TIME_Sub2MicroSecs(tag.Subseconds), (unsigned int)Msg->fcnCode);
+        return CFE_STATUS_VALIDATION_FAILURE;
+    }
+
+    CFE_TIME_SysTime_t const delta      = CFE_TIME_Subtract(tag, now);
+    int64 const              deadlineNs = FPGA_CTRL_MonotonicNs() + (int64)delta.Seconds * 1000000000LL +
+                             (int64)CFE_TIME_Sub2MicroSecs(delta.Subseconds) * 1000;
+
+    pthread_mutex_lock(&timedQueue.lock);
+
+    FPGA_CTRL_TimedEntry_t *const entry = timedQueue.freeList;
+    if (entry == NULL)
+    {
+        ++timedQueue.rejected;
+        pthread_mutex_unlock(&timedQueue.lock);
+        CFE_EVS_SendEvent(FPGA_CTRL_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR,
+                          "Time-tagged command queue full, %u queued", (unsigned int)FPGA_CTRL_TIMED_MAX_ENTRIES);
+        return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    }
+    timedQueue.freeList = entry->next;
+
+    entry->deadlineNs  = deadlineNs;
+    entry->expiresTick = (uint64)(deadlineNs - timedQueue.baseNs) / FPGA_CTRL_WHEEL_TICK_NS;
+    entry->msgId       = priority ? FPGA_CTRL_PRIORITY_CMD_MID : FPGA_CTRL_CMD_MID;
+    entry->fcnCode     = Msg->fcnCode;
+    entry->length      = Msg->length;
+    memcpy(entry->payload, Msg->payload, Msg->length);
+
+    FPGA_CTRL_WheelInsert(entry);
+    ++timedQueue.inWheel;
+    ++timedQueue.accepted;
+    if (++timedQueue.queued > timedQueue.peakQueued)
+        timedQueue.peakQueued = timedQueue.queued;
+    uint32 const queued = timedQueue.queued;
+
+    // The child may be asleep until a later deadline
+    pthread_cond_signal(&timedQueue.wake);
+    pthread_mutex_unlock(&timedQueue.lock);
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "CC %u tagged for %u.%06u, %u queued",
+                      (unsigned int)Msg->fcnCode, (unsigned int)tag.Seconds,
+                      (unsigned int)CFE_TIME_Sub2MicroSecs(tag.Subseconds), (unsigned int)queued);
+    return CFE_SUCCESS;
+}
+
+void FPGA_CTRL_SendTimedTlm(void)
+{
+    static FPGA_CTRL_TimedTlm_t packet;
+
+    CFE_MSG_Init(&packet.TlmHeader.Msg, CFE_SB_ValueToMsgId(FPGA_CTRL_TIMED_TLM_MID), sizeof(packet));
+
+    if (timedQueue.syncCreated)
+    {
+        pthread_mutex_lock(&timedQueue.lock);
+        packet.queued       = timedQueue.queued;
+        packet.peakQueued   = timedQueue.peakQueued;
+        packet.accepted     = timedQueue.accepted;
+        packet.rejected     = timedQueue.rejected;
+        packet.released     = timedQueue.released;
+        packet.jitterUsLast = timedQueue.jitterUsLast;
+        packet.jitterUsMax  = timedQueue.jitterUsMax;
+        packet.jitterUsAvg  = timedQueue.released != 0 ? (uint32)(timedQueue.jitterUsTotal / timedQueue.released) : 0;
+        pthread_mutex_unlock(&timedQueue.lock);
+    }
+
+    CFE_SB_TimeStampMsg(&packet.TlmHeader.Msg);
+    CFE_SB_TransmitMsg(&packet.TlmHeader.Msg, true);
+}
+
+// Sleeps until the next deadline, or until a command is queued, and sends whatever has come due
+static void FPGA_CTRL_TimedTask(void)
+{
+    FPGA_CTRL_ApplyChildSchedProfile(0);
+
+    pthread_mutex_lock(&timedQueue.lock);
+
+    while (!timedQueue.shouldExit)
+    {
+        FPGA_CTRL_TimedEntry_t *expired = NULL;
+        int64 const             nowNs   = FPGA_CTRL_MonotonicNs();
+
+        FPGA_CTRL_WheelAdvance(nowNs, &expired);
+        if (expired != NULL)
+        {
+            // Sending can block on the SB, so new commands can be queued meanwhile
+            pthread_mutex_unlock(&timedQueue.lock);
+            CFE_ES_PerfLogEntry(FPGA_CTRL_TIMED_PERF_ID);
+            FPGA_CTRL_TimedRelease(expired);
+            CFE_ES_PerfLogExit(FPGA_CTRL_TIMED_PERF_ID);
+            pthread_mutex_lock(&timedQueue.lock);
+            continue;
+        }
+
+        int64 wakeNs = FPGA_CTRL_WheelNextWakeNs();
+        if (wakeNs < 0)
+            wakeNs = nowNs + FPGA_CTRL_TIMED_IDLE_WAIT_MS * 1000000LL;
+
+        struct timespec const wakeTime = {.tv_sec = wakeNs / 1000000000LL, .tv_nsec = wakeNs % 1000000000LL};
+        pthread_cond_timedwait(&timedQueue.wake, &timedQueue.lock, &wakeTime);
+    }
+
+    timedQueue.taskRunning = false;
+    pthread_mutex_unlock(&timedQueue.lock);
+
+    CFE_ES_ExitChildTask();
+}
+
+// Sends the due commands, earliest first, and returns their entries to the free list
+static void FPGA_CTRL_TimedRelease(FPGA_CTRL_TimedEntry_t *expired)
+{
+    static union
+    {
+        CFE_SB_Buffer_t Buf;
+        uint8           Bytes[sizeof(CFE_MSG_CommandHeader_t) + FPGA_CTRL_TIMED_MAX_PAYLOAD];
+    } cmd;
+
+    while (expired != NULL)
+    {
+        FPGA_CTRL_TimedEntry_t *const entry = expired;
+        expired                             = entry->next;
+
+        CFE_MSG_Init(&cmd.Buf.Msg, CFE_SB_ValueToMsgId(entry->msgId),
+                     sizeof(CFE_MSG_CommandHeader_t) + entry->length);
+        CFE_MSG_SetFcnCode(&cmd.Buf.Msg, entry->fcnCode);
+        memcpy(&cmd.Bytes[sizeof(CFE_MSG_CommandHeader_t)], entry->payload, entry->length);
+
+        uint32 const jitterUs = (uint32)((FPGA_CTRL_MonotonicNs() - entry->deadlineNs) / 1000);
+        CFE_SB_TransmitMsg(&cmd.Buf.Msg, true);
+
+        pthread_mutex_lock(&timedQueue.lock);
+        ++timedQueue.released;
+        --timedQueue.queued;
+        timedQueue.jitterUsLast = jitterUs;
+        timedQueue.jitterUsTotal += jitterUs;
+        if (jitterUs > timedQueue.jitterUsMax)
+            timedQueue.jitterUsMax = jitterUs;
+        entry->next         = timedQueue.freeList;
+        timedQueue.freeList = entry;
+        pthread_mutex_unlock(&timedQueue.lock);
+    }
+}
+
+// Files the entry in the lowest level whose turn reaches its tick: level n holds ticks 64^n to 64^(n+1) away, in the
+// slot that the level below cascades from just before they come due. The lock must be held.
+static void FPGA_CTRL_WheelInsert(FPGA_CTRL_TimedEntry_t *const entry)
+{
+    uint64 const span    = 1ULL << (FPGA_CTRL_WHEEL_BITS * FPGA_CTRL_WHEEL_LEVELS);
+    uint64 const expires = entry->expiresTick > timedQueue.tick ? entry->expiresTick : timedQueue.tick;
+    uint64 const delta   = expires - timedQueue.tick;
+    uint64       slotTick = expires;
+    int          level    = 0;
+
+    while (level < FPGA_CTRL_WHEEL_LEVELS - 1 && delta >= 1ULL << (FPGA_CTRL_WHEEL_BITS * (level + 1)))
+        ++level;
+
+    // Beyond the top level's turn, parked in its last slot until that comes round
+    if (delta >= span)
+        slotTick = timedQueue.tick + span - 1;
+
+    FPGA_CTRL_TimedEntry_t **const slot =
+        &timedQueue.slots[level][(slotTick >> (FPGA_CTRL_WHEEL_BITS * level)) & FPGA_CTRL_WHEEL_MASK];
+    entry->next = *slot;
+    *slot       = entry;
+}
+
+// Expires every entry due by nowNs onto the expired list, earliest first, cascading the upper levels as their slots
+// come round. Ticks already passed are walked one at a time, the child never sleeps past more than a turn of level 0.
+// The lock must be held.
+static void FPGA_CTRL_WheelAdvance(int64 const nowNs, FPGA_CTRL_TimedEntry_t **const expired)
+{
+    uint64 const nowTick = (uint64)(nowNs - timedQueue.baseNs) / FPGA_CTRL_WHEEL_TICK_NS;
+
+    if (timedQueue.inWheel == 0)
+    {
+        if (timedQueue.tick < nowTick)
+            timedQueue.tick = nowTick;
+        return;
+    }
+
+    for (;;)
+    {
+        FPGA_CTRL_TimedEntry_t **link = &timedQueue.slots[0][timedQueue.tick & FPGA_CTRL_WHEEL_MASK];
+        while (*link != NULL)
+        {
+            FPGA_CTRL_TimedEntry_t *const entry = *link;
+            if (entry->deadlineNs > nowNs)
+            {
+                link = &entry->next;
+                continue;
+            }
+
+            *link = entry->next;
+            --timedQueue.inWheel;
+
+            FPGA_CTRL_TimedEntry_t **pos = expired;
+            while (*pos != NULL && (*pos)->deadlineNs <= entry->deadlineNs)
+                pos = &(*pos)->next;
+            entry->next = *pos;
+            *pos        = entry;
+        }
+
+        if (timedQueue.tick >= nowTick)
+            break;
+        ++timedQueue.tick;
+
+        for (int level = 1; level < FPGA_CTRL_WHEEL_LEVELS; ++level)
+        {
+            if ((timedQueue.tick & ((1ULL << (FPGA_CTRL_WHEEL_BITS * level)) - 1)) != 0)
+                break;
+
+            FPGA_CTRL_TimedEntry_t **const slot =
+                &timedQueue.slots[level][(timedQueue.tick >> (FPGA_CTRL_WHEEL_BITS * level)) & FPGA_CTRL_WHEEL_MASK];
+            FPGA_CTRL_TimedEntry_t *entry = *slot;
+            *slot                         = NULL;
+            while (entry != NULL)
+            {
+                FPGA_CTRL_TimedEntry_t *const next = entry->next;
+                FPGA_CTRL_WheelInsert(entry);
+                entry = next;
+            }
+        }
+    }
+}
+
+// Earliest deadline in the next occupied level 0 slot of this turn, the end of the turn if there isn't one so the
+// upper levels can cascade, or -1 if the wheel is empty. The lock must be held.
+static int64 FPGA_CTRL_WheelNextWakeNs(void)
+{
+    if (timedQueue.inWheel == 0)
+        return -1;
+
+    uint64 const turnEnd = (timedQueue.tick | FPGA_CTRL_WHEEL_MASK) + 1;
+    for (uint64 tick = timedQueue.tick; tick < turnEnd; ++tick)
+    {
+        FPGA_CTRL_TimedEntry_t const *entry = timedQueue.slots[0][tick & FPGA_CTRL_WHEEL_MASK];
+        if (entry == NULL)
+            continue;
+
+        int64 earliest = entry->deadlineNs;
+        for (; entry != NULL; entry = entry->next)
+        {
+            if (entry->deadlineNs < earliest)
+                earliest = entry->deadlineNs;
+        }
+        return earliest;
+    }
+
+    return timedQueue.baseNs + (int64)(turnEnd * FPGA_CTRL_WHEEL_TICK_NS);
+}
@@ -0,0 +1,244 @@
+// Leveled diagnostic tracing. FPGA_CTRL_TRACE(DEBUG, AES, "fmt", ...) keeps a message when its level is at or below
+// FPGA_CTRL_TRACE_LEVEL and its subsystem is in FPGA_CTRL_TRACE_MASK, both fixed at compile time. Flight builds
+// leave FPGA_CTRL_TRACE_LEVEL at FPGA_CTRL_TRACE_OFF and every trace compiles away, arguments included.
+// Debug builds (CMAKE_BUILD_TYPE Debug) compile everything in. What's kept at runtime is narrowed further by the
+// level, subsystems and sinks FPGA_CTRL_TRACE_CC sets: the ring by default, which any task can write without
+// locking or touching the console, and which the same command writes out to a file. The console sink prints each
+// message as it happens, at the cost of serializing on it.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cfe.h"
+#include "fpga_ctrl.h"
+
+#ifndef FPGA_CTRL_TRACE_LEVEL
+#define FPGA_CTRL_TRACE_LEVEL FPGA_CTRL_TRACE_OFF
+#endif
+#ifndef FPGA_CTRL_TRACE_MASK
+#define FPGA_CTRL_TRACE_MASK \
+    (FPGA_CTRL_TRACE_AES | FPGA_CTRL_TRACE_IRQ | FPGA_CTRL_TRACE_BITSTREAM | FPGA_CTRL_TRACE_CMD)
+#endif
+
+#define FPGA_CTRL_TRACE_RING_LEN 256 // Messages kept, a power of 2
+#define FPGA_CTRL_TRACE_TEXT_LEN 112 // Longer messages are cut short
+#define FPGA_CTRL_TRACE_LINE_LEN (FPGA_CTRL_TRACE_TEXT_LEN + 48)
+
+#if FPGA_CTRL_TRACE_LEVEL > FPGA_CTRL_TRACE_OFF
+
+// Kept by the build, and by the runtime settings. Those are checked in line, so a message filtered out at runtime
+// costs two loads and no call.
+#define FPGA_CTRL_TRACE_ENABLED(lvl, sub)                                      \
+    ((lvl) <= FPGA_CTRL_TRACE_LEVEL && ((sub)&FPGA_CTRL_TRACE_MASK) &&          \
+     (lvl) <= atomic_load_explicit(&traceState.level, memory_order_relaxed) && \
+     ((sub)&atomic_load_explicit(&traceState.subsystems, memory_order_relaxed)))
+
+#define FPGA_CTRL_TRACE(level, subsystem, ...)                                                       \
+    do                                                                                               \
+    {                                                                                                \
+        if (FPGA_CTRL_TRACE_ENABLED(FPGA_CTRL_TRACE_##level, FPGA_CTRL_TRACE_##subsystem))           \
+            FPGA_CTRL_TraceWrite(FPGA_CTRL_TRACE_##level, FPGA_CTRL_TRACE_##subsystem, __VA_ARGS__); \
+    } while (0)
+
+typedef struct
+{
+    int64 ns;
+    uint8 level;
+    uint8 subsystem;
+    char  text[FPGA_CTRL_TRACE_TEXT_LEN];
+} FPGA_CTRL_TraceRecord_t;
+
+// Sequence 2n + 1 while the nth message is written into the slot, 2n + 2 once it's complete
+typedef struct
+{
+    atomic_uint             seq;
+    FPGA_CTRL_TraceRecord_t rec;
+} FPGA_CTRL_TraceSlot_t;
+
+static struct
+{
+    atomic_uint           level;
+    atomic_uint           subsystems;
+    atomic_uint           sinks;
+    atomic_uint           head; // Messages ever written, the next one goes in slot head % FPGA_CTRL_TRACE_RING_LEN
+    FPGA_CTRL_TraceSlot_t ring[FPGA_CTRL_TRACE_RING_LEN];
+} traceState = {
+    .level      = FPGA_CTRL_TRACE_LEVEL,
+    .subsystems = FPGA_CTRL_TRACE_MASK,
+    .sinks      = FPGA_CTRL_TRACE_RING,
+};
+
+void FPGA_CTRL_TraceWrite(uint32 level, uint32 subsystem, char const *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+static int32       FPGA_CTRL_WriteTraceRing(osal_id_t fileId);
+static char const *FPGA_CTRL_TraceLevelName(uint32 level);
+static char const *FPGA_CTRL_TraceSubsystemName(uint32 subsystem);
+
+#else
+
+#define FPGA_CTRL_TRACE(level, subsystem, ...) ((void)0)
+
+#endif /* FPGA_CTRL_TRACE_LEVEL */
+
+// Exported functions
+int32 FPGA_CTRL_TraceCtrl(FPGA_CTRL_TraceCmd_t const *Msg);
+
+#if FPGA_CTRL_TRACE_LEVEL > FPGA_CTRL_TRACE_OFF
+
+// Formats the message into the next ring slot and/or onto the console. Safe from any task.
+void FPGA_CTRL_TraceWrite(uint32 const level, uint32 const subsystem, char const *const fmt, ...)
+{
+    unsigned int const sinks = atomic_load_explicit(&traceState.sinks, memory_order_relaxed);
+    struct timespec    now;
+    va_list            args;
+
+    if (sinks & FPGA_CTRL_TRACE_RING)
+    {
+        unsigned int const           n    = atomic_fetch_add_explicit(&traceState.head, 1, memory_order_relaxed);
+        FPGA_CTRL_TraceSlot_t *const slot = &traceState.ring[n % FPGA_CTRL_TRACE_RING_LEN];
+
+        atomic_store_explicit(&slot->seq, 2 * n + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        slot->rec.ns        = (int64)now.tv_sec * 1000000000LL + now.tv_nsec;
+        slot->rec.level     = (uint8)level;
+        slot->rec.subsystem = (uint8)subsystem;
+        va_start(args, fmt);
+        vsnprintf(slot->rec.text, sizeof(slot->rec.text), fmt, args);
+        va_end(args);
+
+        atomic_store_explicit(&slot->seq, 2 * n + 2, memory_order_release);
+    }
+
+    if (sinks & FPGA_CTRL_TRACE_CONSOLE)
+    {
+        char text[FPGA_CTRL_TRACE_TEXT_LEN];
+
+        va_start(args, fmt);
+        vsnprintf(text, sizeof(text), fmt, args);
+        va_end(args);
+        OS_printf("FPGA_CTRL %s %s: %s\n", FPGA_CTRL_TraceLevelName(level), FPGA_CTRL_TraceSubsystemName(subsystem),
+                  text);
+    }
+}
+
+#endif /* FPGA_CTRL_TRACE_LEVEL */
+
+// Applies the command's settings, or writes the ring out if it names a file
+int32 FPGA_CTRL_TraceCtrl(FPGA_CTRL_TraceCmd_t const *const Msg)
+{
+#if FPGA_CTRL_TRACE_LEVEL > FPGA_CTRL_TRACE_OFF
+    char      path[sizeof(Msg->path)];
+    osal_id_t fileId;
+    int32     err;
+
+    if (Msg->path[0] == '\0')
+    {
+        uint32 const level = Msg->level < FPGA_CTRL_TRACE_LEVEL ? Msg->level : FPGA_CTRL_TRACE_LEVEL;
+
+        atomic_store_explicit(&traceState.level, level, memory_order_relaxed);
+        atomic_store_explicit(&traceState.subsystems, Msg->subsystems & FPGA_CTRL_TRACE_MASK, memory_order_relaxed);
+        atomic_store_explicit(&traceState.sinks, Msg->sinks, memory_order_relaxed);
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION,
+                          "Tracing at level %u, subsystems 0x%02x, sinks 0x%x", (unsigned int)level,
+                          (unsigned int)(Msg->subsystems & FPGA_CTRL_TRACE_MASK), (unsigned int)Msg->sinks);
+        return CFE_SUCCESS;
+    }
+
+    if (memchr(Msg->path, '\0', sizeof(Msg->path)) == NULL)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Trace path isn't terminated");
+        return CFE_FS_FNAME_TOO_LONG;
+    }
+    memcpy(path, Msg->path, sizeof(path));
+
+    if ((err = OS_OpenCreate(&fileId, path, OS_FILE_FLAG_CREATE | OS_FILE_FLAG_TRUNCATE, OS_WRITE_ONLY)) !=
+        OS_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to open trace file %s: %d",
+                          path, (int)err);
+        return err;
+    }
+
+    err = FPGA_CTRL_WriteTraceRing(fileId);
+    OS_close(fileId);
+    if (err < CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR, "Failed to write trace file %s: %d",
+                          path, (int)err);
+        return err;
+    }
+
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_INFORMATION, "%u trace messages written to %s",
+                      (unsigned int)err, path);
+    return CFE_SUCCESS;
+#else
+    CFE_EVS_SendEvent(FPGA_CTRL_DEBUG_INF_EID, CFE_EVS_EventType_ERROR,
+                      "Tracing isn't compiled into this build, see FPGA_CTRL_TRACE_LEVEL");
+    return CFE_STATUS_NOT_IMPLEMENTED;
+#endif
+}
+
+#if FPGA_CTRL_TRACE_LEVEL > FPGA_CTRL_TRACE_OFF
+
+// Writes the messages still in the ring, oldest first, and returns how many. A slot that's being rewritten while
+// it's read is skipped, the message in it is gone anyway.
+static int32 FPGA_CTRL_WriteTraceRing(osal_id_t const fileId)
+{
+    unsigned int const head    = atomic_load_explicit(&traceState.head, memory_order_acquire);
+    unsigned int const first   = head > FPGA_CTRL_TRACE_RING_LEN ? head - FPGA_CTRL_TRACE_RING_LEN : 0;
+    int32              written = 0;
+    char               line[FPGA_CTRL_TRACE_LINE_LEN];
+
+    for (unsigned int n = first; n != head; ++n)
+    {
+        FPGA_CTRL_TraceSlot_t *const slot = &traceState.ring[n % FPGA_CTRL_TRACE_RING_LEN];
+        FPGA_CTRL_TraceRecord_t      rec;
+
+        unsigned int const seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq != 2 * n + 2)
+            continue;
+        memcpy(&rec, &slot->rec, sizeof(rec));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq)
+            continue;
+
+        rec.text[sizeof(rec.text) - 1] = '\0';
+        int const len = snprintf(line, sizeof(line), "%lld.%09lld %s %s %s\n", (long long)(rec.ns / 1000000000LL),
+                                 (long long)(rec.ns % 1000000000LL), FPGA_CTRL_TraceLevelName(rec.level),
+                                 FPGA_CTRL_TraceSubsystemName(rec.subsystem), rec.text);
+        if (OS_write(fileId, line, len) != len)
+            return CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+        ++written;
+    }
+
+    return written;
+}
+
+static char const *FPGA_CTRL_TraceLevelName(uint32 const level)
+{
+    static char const *const names[] = {"OFF", "ERROR", "WARN", "INFO", "DEBUG"};
+    return level <= FPGA_CTRL_TRACE_DEBUG ? names[level] : "?";
+}
+
+static char const *FPGA_CTRL_TraceSubsystemName(uint32 const subsystem)
+{
+    switch (subsystem)
+    {
+        case FPGA_CTRL_TRACE_AES:
+            return "AES";
+        case FPGA_CTRL_TRACE_IRQ:
+            return "IRQ";
+        case FPGA_CTRL_TRACE_BITSTREAM:
+            return "BITSTREAM";
+        case FPGA_CTRL_TRACE_CMD:
+            return "CMD";
+        default:
+            return "?";
+    }
+}
+
+#endif /* FPGA_CTRL_TRACE_LEVEL */
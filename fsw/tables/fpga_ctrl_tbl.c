@@ -27,7 +27,91 @@
 ** The following is an example of the declaration statement that defines the desired
 ** contents of the table image.
 */
-FPGA_CTRL_Table_t FpgaCtrlTable = {1, 2};
+FPGA_CTRL_Table_t FpgaCtrlTable = {
+    .Int1 = 1,
+    .Int2 = 2,
+
+    .IrqPollEnterRate  = 2000,
+    .IrqPollBudget     = 256,
+    .IrqPollIdleExitMs = 50,
+
+    /*
+    ** Default scheduling: OSAL priorities and stack, no pinning, locking or prefaulting. To enable it on a target,
+    ** copy this table into the target's table set and fill in what the target has, e.g. for a dual core Zynq:
+    **   .IrqTaskPriority = 40, .IrqTaskStackSize = 32768, .MainCpuMask = 0x1, .IrqTaskCpuMask = 0x2,
+    **   .UioIrqNumber = <IRQ from /proc/interrupts>, .LockMemory = 1, .PrefaultStack = 1, .StackPrefaultBytes = 8192
+    ** The masks must name cores the target has. The other child tasks aren't pinned, they run on any core.
+    */
+    .Sched =
+        {
+            .MainPriority       = 0,
+            .IrqTaskPriority    = 0,
+            .IrqTaskStackSize   = 0,
+            .MainCpuMask        = 0,
+            .IrqTaskCpuMask     = 0,
+            .UioIrqNumber       = 0,
+            .LockMemory         = 0,
+            .PrefaultStack      = 0,
+            .StackPrefaultBytes = 0,
+        },
+
+    .BitstreamCacheLimit = 32 * 1024 * 1024,
+    .RequireBitstreamCrc = 0,
+
+    /* Empty keeps the built-in AES + GPIO layout for whatever was loaded at boot */
+    .BootBitstream = "",
+
+    /* Reconfigure a region once 4 jobs want its module, or once one has waited half a second */
+    .RegionMinBatch  = 4,
+    .RegionMaxWaitMs = 500,
+
+    /* Handle up to 16 queued messages per wakeup, giving up the CPU after 5 ms */
+    .DrainMaxMsgs  = 16,
+    .DrainBudgetUs = 5000,
+
+    /* Periodic work gets 2 ms of each scheduler wakeup */
+    .RateBudgetUs = 2000,
+
+    /* Long commands run in slices of up to 200 us between pipe reads */
+    .JobSliceUs = 200,
+
+    /*
+    ** Prometheus metrics are off. To export them every 5 s, set the path to a file a textfile collector or other
+    ** sidecar reads, e.g. "/var/lib/node_exporter/fpga_ctrl.prom", on a filesystem the app can rename within.
+    */
+    .MetricsPeriodMs = 5000,
+    .MetricsPath     = "",
+
+    /* Give each image its Crc32c to have it checked before it's programmed */
+    .Bitstreams =
+        {
+            {
+                .Name    = "aes",
+                .Path    = "/home/ubuntu/bitstreams/aes_encrypt.bit.bin",
+                .Preload = 1,
+                .Accels =
+                    {
+                        {.Type = FPGA_CTRL_ACCEL_AES_CTRL, .UioIndex = FPGA_CTRL_ACCEL_NO_UIO, .Base = 0x43c00000,
+                         .Range = 0x10000},
+                        {.Type = FPGA_CTRL_ACCEL_AES_IN, .UioIndex = FPGA_CTRL_ACCEL_NO_UIO, .Base = 0x43c10000,
+                         .Range = 0x10000},
+                        {.Type = FPGA_CTRL_ACCEL_AES_OUT, .UioIndex = FPGA_CTRL_ACCEL_NO_UIO, .Base = 0x43c20000,
+                         .Range = 0x10000},
+                    },
+            },
+            {
+                .Name    = "interrupts",
+                .Path    = "/home/ubuntu/bitstreams/interrupt_demo.bit.bin",
+                .Preload = 1,
+                .Accels =
+                    {
+                        {.Type = FPGA_CTRL_ACCEL_GPIO_BTN, .UioIndex = 0, .Base = 0x41200000, .Range = 0x10000},
+                        {.Type = FPGA_CTRL_ACCEL_GPIO_SW, .UioIndex = FPGA_CTRL_ACCEL_NO_UIO, .Base = 0x41210000,
+                         .Range = 0x10000},
+                    },
+            },
+        },
+};
 
 /*
 ** The macro below identifies:
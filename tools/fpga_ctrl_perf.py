@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""Turns a cFE ES performance log dump into per-phase latencies and timelines for FPGA Ctrl.
+
+Dump the log on the target with ES's "write perf data" command (cfe_es_perf.dat by default), copy it over and run
+
+    tools/fpga_ctrl_perf.py cfe_es_perf.dat
+
+for a latency summary and log2 histogram of every phase. --timeline draws the phases against time, --csv writes
+every interval out for plotting elsewhere. Phase names come from fsw/mission_inc/fpga_ctrl_perfids.h, IDs that
+aren't in it show up by number.
+
+Each phase is an entry marker followed by an exit marker with the same ID. Markers of one ID are paired innermost
+first, so nested commands in a batch come out as separate intervals. An exit with no entry (the log started
+mid-phase) or an entry with no exit (still running, or a job cancelled mid-phase) is counted but left out.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+FS_HEADER_SIZE = 64  # CFE_FS_Header_t
+META_WORDS = 12  # CFE_ES_PerfMetaData_t up to its filter and trigger masks
+ENTRY_SIZE = 12  # CFE_ES_PerfDataEntry_t
+EXIT_BIT = 1 << 31  # CFE_MISSION_ES_PERF_EXIT_BIT
+ENDIAN_MARK = 0x01020304
+HIST_BUCKETS = 20  # Bucket n holds durations under 2^n us, the last everything longer
+
+DEFAULT_PERFIDS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "fsw", "mission_inc",
+                               "fpga_ctrl_perfids.h")
+
+
+def load_names(path):
+    """Maps perf IDs to names from the #defines in the perf ID header"""
+    names = {}
+    try:
+        with open(path) as f:
+            for line in f:
+                m = re.match(r"\s*#define\s+(FPGA_CTRL_(\w*?)_?PERF_ID)\s+(\d+)", line)
+                if m:
+                    names[int(m.group(3))] = m.group(2).lower() or "main"
+    except OSError as err:
+        print("warning: no phase names, %s" % err, file=sys.stderr)
+    return names
+
+
+def read_log(path):
+    """Returns the ticks per second and the (time in ticks, id, is_exit) markers in the dump, oldest first"""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < FS_HEADER_SIZE + META_WORDS * 4:
+        raise ValueError("%s is too short for a perf log dump" % path)
+
+    # The metadata is in the target's byte order, its Endian word tells which
+    meta_off = FS_HEADER_SIZE
+    for order in ("<", ">"):
+        meta = struct.unpack_from(order + "%dI" % META_WORDS, data, meta_off)
+        if meta[1] == ENDIAN_MARK:
+            break
+    else:
+        raise ValueError("%s has no perf metadata after the file header" % path)
+
+    ticks_per_sec, low_rollover, data_count, mask_words = meta[2], meta[3], meta[9], meta[11]
+    offset = meta_off + META_WORDS * 4 + 2 * mask_words * 4
+    count = min(data_count, (len(data) - offset) // ENTRY_SIZE)
+
+    markers = []
+    for i in range(count):
+        word, upper, lower = struct.unpack_from(order + "3I", data, offset + i * ENTRY_SIZE)
+        ticks = upper * low_rollover + lower if low_rollover else upper << 32 | lower
+        markers.append((ticks, word & ~EXIT_BIT, bool(word & EXIT_BIT)))
+
+    return (ticks_per_sec or 1000000), markers
+
+
+def pair_markers(markers, ticks_per_sec):
+    """Returns the intervals as (start us, end us, id, depth) and the unmatched exit and entry counts by ID"""
+    t0 = markers[0][0] if markers else 0
+    open_by_id = {}
+    intervals = []
+    orphan_exits = {}
+
+    for ticks, perf_id, is_exit in markers:
+        us = (ticks - t0) * 1000000.0 / ticks_per_sec
+        stack = open_by_id.setdefault(perf_id, [])
+        if not is_exit:
+            stack.append(us)
+        elif stack:
+            start = stack.pop()
+            intervals.append((start, us, perf_id, len(stack)))
+        else:
+            orphan_exits[perf_id] = orphan_exits.get(perf_id, 0) + 1
+
+    orphan_entries = {perf_id: len(stack) for perf_id, stack in open_by_id.items() if stack}
+    intervals.sort()
+    return intervals, orphan_exits, orphan_entries
+
+
+def percentile(sorted_values, fraction):
+    if not sorted_values:
+        return 0.0
+    return sorted_values[min(len(sorted_values) - 1, int(fraction * len(sorted_values)))]
+
+
+def bucket(us):
+    n = 0
+    while n < HIST_BUCKETS - 1 and us >= (1 << n):
+        n += 1
+    return n
+
+
+def phase_name(names, perf_id):
+    return names.get(perf_id, "id%d" % perf_id)
+
+
+def print_summary(intervals, names, orphan_exits, orphan_entries, span_us):
+    by_id = {}
+    for start, end, perf_id, _ in intervals:
+        by_id.setdefault(perf_id, []).append(end - start)
+
+    print("%-14s %4s %8s %12s %7s %10s %10s %10s %10s %10s" %
+          ("phase", "id", "count", "total_us", "busy%", "mean_us", "p50_us", "p90_us", "p99_us", "max_us"))
+    for perf_id in sorted(by_id):
+        d = sorted(by_id[perf_id])
+        total = sum(d)
+        print("%-14s %4d %8d %12.0f %7.2f %10.1f %10.1f %10.1f %10.1f %10.1f" %
+              (phase_name(names, perf_id), perf_id, len(d), total, 100.0 * total / span_us if span_us else 0.0,
+               total / len(d), percentile(d, 0.5), percentile(d, 0.9), percentile(d, 0.99), d[-1]))
+
+    for label, counts in (("exits with no entry", orphan_exits), ("entries never exited", orphan_entries)):
+        if counts:
+            listed = ", ".join("%s %d" % (phase_name(names, i), n) for i, n in sorted(counts.items()))
+            print("%s: %s" % (label, listed))
+
+
+def print_histograms(intervals, names):
+    by_id = {}
+    for start, end, perf_id, _ in intervals:
+        hist = by_id.setdefault(perf_id, [0] * HIST_BUCKETS)
+        hist[bucket(end - start)] += 1
+
+    for perf_id in sorted(by_id):
+        hist = by_id[perf_id]
+        peak = max(hist)
+        print("\n%s (id %d)" % (phase_name(names, perf_id), perf_id))
+        first = next(i for i, n in enumerate(hist) if n)
+        last = max(i for i, n in enumerate(hist) if n)
+        for n in range(first, last + 1):
+            label = "< %dus" % (1 << n) if n < HIST_BUCKETS - 1 else ">= %dus" % (1 << (n - 1))
+            print("  %12s %8d %s" % (label, hist[n], "#" * (hist[n] * 50 // peak if peak else 0)))
+
+
+def print_timeline(intervals, names, span_us, width):
+    """One row per phase, a column per slice of the log, marked where the phase ran"""
+    if not intervals or span_us <= 0:
+        return
+
+    rows = {}
+    for start, end, perf_id, _ in intervals:
+        row = rows.setdefault(perf_id, [0.0] * width)
+        first = int(start * width / span_us)
+        last = min(width - 1, int(end * width / span_us))
+        for col in range(first, last + 1):
+            col_start = col * span_us / width
+            col_end = (col + 1) * span_us / width
+            row[col] += max(0.0, min(end, col_end) - max(start, col_start))
+
+    col_us = span_us / width
+    print("\ntimeline, %.0f us per column, ' ' idle '.' under 10%% '+' under 50%% '#' busier" % col_us)
+    for perf_id in sorted(rows):
+        marks = "".join(" " if b == 0 else "." if b < col_us * 0.1 else "+" if b < col_us * 0.5 else "#"
+                        for b in rows[perf_id])
+        print("%-14s |%s|" % (phase_name(names, perf_id), marks))
+
+
+def write_csv(path, intervals, names):
+    with open(path, "w") as f:
+        f.write("start_us,end_us,duration_us,id,phase,depth\n")
+        for start, end, perf_id, depth in intervals:
+            f.write("%.3f,%.3f,%.3f,%d,%s,%d\n" %
+                    (start, end, end - start, perf_id, phase_name(names, perf_id), depth))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dump", help="perf log written by ES, cfe_es_perf.dat")
+    parser.add_argument("--perfids", default=DEFAULT_PERFIDS, help="header to take phase names from")
+    parser.add_argument("--ids", help="comma separated IDs to report, all of them by default")
+    parser.add_argument("--histograms", action="store_true", help="print a latency histogram per phase")
+    parser.add_argument("--timeline", action="store_true", help="draw when each phase ran")
+    parser.add_argument("--width", type=int, default=100, help="timeline columns")
+    parser.add_argument("--csv", help="write every interval to this file")
+    args = parser.parse_args()
+
+    names = load_names(args.perfids)
+    ticks_per_sec, markers = read_log(args.dump)
+    if args.ids:
+        wanted = {int(i) for i in args.ids.split(",")}
+        markers = [m for m in markers if m[1] in wanted]
+    if not markers:
+        print("no markers in %s" % args.dump)
+        return
+
+    intervals, orphan_exits, orphan_entries = pair_markers(markers, ticks_per_sec)
+    span_us = (markers[-1][0] - markers[0][0]) * 1000000.0 / ticks_per_sec
+
+    print("%d markers over %.6f s, %d ticks/s" % (len(markers), span_us / 1e6, ticks_per_sec))
+    print_summary(intervals, names, orphan_exits, orphan_entries, span_us)
+    if args.histograms:
+        print_histograms(intervals, names)
+    if args.timeline:
+        print_timeline(intervals, names, span_us, args.width)
+    if args.csv:
+        write_csv(args.csv, intervals, names)
+
+
+if __name__ == "__main__":
+    main()
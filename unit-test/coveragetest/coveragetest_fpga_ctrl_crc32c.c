@@ -0,0 +1,221 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_fpga_ctrl_crc32c.c
+**
+** Purpose:
+** Coverage Unit Test cases for CRC-32C (fpga_ctrl_crc32c.h)
+**
+** Notes:
+** The check values are the standard ones for CRC-32C: "123456789"
+** from the CRC catalogue and the 32 byte vectors of RFC 3720 B.4.
+** The software path is compared against whichever path the host
+** picked, so on a host with the CRC instructions both are checked
+** against each other as well as against the fixed values.
+*/
+
+/*
+ * Includes
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fpga_ctrl_coveragetest_common.h"
+#include "fpga_ctrl_crc32c.h"
+
+#define UT_CRC32C_CHECK 0xE3069283u // CRC-32C of "123456789"
+
+static char const UT_Crc32cCheckText[] = "123456789";
+
+/*
+ * Fills buf with a repeatable pseudo-random pattern
+ */
+static void UT_Crc32cFill(uint8 *buf, size_t len)
+{
+    uint32 state = 0x12345678;
+
+    for (size_t i = 0; i < len; ++i)
+    {
+        state  = state * 1103515245u + 12345u;
+        buf[i] = (uint8)(state >> 16);
+    }
+}
+
+/*
+ * CRC of buf one byte at a time through the software path, the simplest way there is of getting it
+ */
+static uint32 UT_Crc32cBytewise(uint8 const *buf, size_t len)
+{
+    uint32 crc = ~0u;
+
+    for (size_t i = 0; i < len; ++i)
+        crc = FPGA_CTRL_Crc32cSoftware(crc, buf + i, 1);
+    return ~crc;
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_FPGA_CTRL_Crc32c(void)
+{
+    /*
+     * Test Case For:
+     * uint32 FPGA_CTRL_Crc32c(uint32 crc, void const *data, size_t len)
+     */
+    uint8  vector[32];
+    uint32 crc;
+
+    crc = FPGA_CTRL_Crc32c(0, UT_Crc32cCheckText, strlen(UT_Crc32cCheckText));
+    UtAssert_True(crc == UT_CRC32C_CHECK, "CRC-32C(\"123456789\") = 0x%08lx", (unsigned long)crc);
+
+    crc = FPGA_CTRL_Crc32c(FPGA_CTRL_Crc32c(0, UT_Crc32cCheckText, 4), UT_Crc32cCheckText + 4, 5);
+    UtAssert_True(crc == UT_CRC32C_CHECK, "CRC-32C continued across calls = 0x%08lx", (unsigned long)crc);
+
+    crc = FPGA_CTRL_Crc32c(0, UT_Crc32cCheckText, 0);
+    UtAssert_True(crc == 0, "CRC-32C of nothing = 0x%08lx", (unsigned long)crc);
+
+    memset(vector, 0x00, sizeof(vector));
+    crc = FPGA_CTRL_Crc32c(0, vector, sizeof(vector));
+    UtAssert_True(crc == 0x8A9136AAu, "CRC-32C of 32 zeros = 0x%08lx", (unsigned long)crc);
+
+    memset(vector, 0xFF, sizeof(vector));
+    crc = FPGA_CTRL_Crc32c(0, vector, sizeof(vector));
+    UtAssert_True(crc == 0x62A8AB43u, "CRC-32C of 32 ones = 0x%08lx", (unsigned long)crc);
+
+    for (size_t i = 0; i < sizeof(vector); ++i)
+        vector[i] = (uint8)i;
+    crc = FPGA_CTRL_Crc32c(0, vector, sizeof(vector));
+    UtAssert_True(crc == 0x46DD794Eu, "CRC-32C of 0 to 31 = 0x%08lx", (unsigned long)crc);
+}
+
+void Test_FPGA_CTRL_Crc32cImplementations(void)
+{
+    /*
+     * Test Case For:
+     * static uint32 FPGA_CTRL_Crc32cSoftware(uint32 crc, uint8 const *data, size_t len)
+     * static uint32 FPGA_CTRL_Crc32cHardware(uint32 crc, uint8 const *data, size_t len)
+     * char const *FPGA_CTRL_Crc32cImplName(void)
+     */
+    static uint8 buf[256 + 8];
+    uint32       crc;
+    uint32       mismatches = 0;
+
+    char const *const implName = FPGA_CTRL_Crc32cImplName();
+    bool const        software = crc32c.update == FPGA_CTRL_Crc32cSoftware;
+    UtAssert_True(implName != NULL && (strcmp(implName, "software") == 0) == software,
+                  "Implementation in use is \"%s\"", implName != NULL ? implName : "(null)");
+    if (software)
+        UtPrintf("No CRC instructions on this host, only the software path is checked");
+
+    crc = ~FPGA_CTRL_Crc32cSoftware(~0u, (uint8 const *)UT_Crc32cCheckText, strlen(UT_Crc32cCheckText));
+    UtAssert_True(crc == UT_CRC32C_CHECK, "Software CRC-32C(\"123456789\") = 0x%08lx", (unsigned long)crc);
+    crc = ~crc32c.update(~0u, (uint8 const *)UT_Crc32cCheckText, strlen(UT_Crc32cCheckText));
+    UtAssert_True(crc == UT_CRC32C_CHECK, "%s CRC-32C(\"123456789\") = 0x%08lx", implName, (unsigned long)crc);
+
+    /* Every alignment and every length around the 8 byte steps, against a byte at a time */
+    UT_Crc32cFill(buf, sizeof(buf));
+    for (size_t offset = 0; offset < 8; ++offset)
+    {
+        for (size_t len = 0; len <= 256; ++len)
+        {
+            uint32 const expected = UT_Crc32cBytewise(buf + offset, len);
+            if (~FPGA_CTRL_Crc32cSoftware(~0u, buf + offset, len) != expected ||
+                ~crc32c.update(~0u, buf + offset, len) != expected)
+            {
+                ++mismatches;
+            }
+        }
+    }
+    UtAssert_True(mismatches == 0, "Software and %s paths agree at every alignment and length (%lu mismatches)",
+                  implName, (unsigned long)mismatches);
+}
+
+void Test_FPGA_CTRL_Crc32cCombine(void)
+{
+    /*
+     * Test Case For:
+     * static uint32 FPGA_CTRL_Crc32cCombine(uint32 crc1, uint32 crc2, size_t len2)
+     */
+    static size_t const splits[] = {0, 1, 7, 8, 9, 255, 256, 1000, 4095, 4096};
+    static uint8        buf[4096];
+    uint32              crc;
+
+    crc = FPGA_CTRL_Crc32cCombine(FPGA_CTRL_Crc32c(0, UT_Crc32cCheckText, 4),
+                                  FPGA_CTRL_Crc32c(0, UT_Crc32cCheckText + 4, 5), 5);
+    UtAssert_True(crc == UT_CRC32C_CHECK, "Combined CRC-32C(\"1234\", \"56789\") = 0x%08lx", (unsigned long)crc);
+
+    UT_Crc32cFill(buf, sizeof(buf));
+    uint32 const whole = FPGA_CTRL_Crc32c(0, buf, sizeof(buf));
+    for (size_t i = 0; i < sizeof(splits) / sizeof(splits[0]); ++i)
+    {
+        size_t const split = splits[i];
+        crc                = FPGA_CTRL_Crc32cCombine(FPGA_CTRL_Crc32c(0, buf, split),
+                                                     FPGA_CTRL_Crc32c(0, buf + split, sizeof(buf) - split),
+                                                     sizeof(buf) - split);
+        UtAssert_True(crc == whole, "Split at %lu combined to 0x%08lx, whole buffer 0x%08lx", (unsigned long)split,
+                      (unsigned long)crc, (unsigned long)whole);
+    }
+}
+
+void Test_FPGA_CTRL_Crc32cParallel(void)
+{
+    /*
+     * Test Case For:
+     * uint32 FPGA_CTRL_Crc32cParallel(void const *data, size_t len, uint32 *threadsUsed)
+     */
+    size_t const len = FPGA_CTRL_CRC32C_MAX_THREADS * FPGA_CTRL_CRC32C_SPLIT_BYTES + 3; // Last piece the longest
+    uint32       threadsUsed;
+    uint32       crc;
+
+    crc = FPGA_CTRL_Crc32cParallel(UT_Crc32cCheckText, strlen(UT_Crc32cCheckText), &threadsUsed);
+    UtAssert_True(crc == UT_CRC32C_CHECK, "Parallel CRC-32C(\"123456789\") = 0x%08lx", (unsigned long)crc);
+    UtAssert_True(threadsUsed == 1, "Small buffer not split (%lu threads)", (unsigned long)threadsUsed);
+
+    uint8 *const buf = malloc(len);
+    UtAssert_True(buf != NULL, "Allocated %lu bytes", (unsigned long)len);
+    if (buf == NULL)
+        return;
+
+    UT_Crc32cFill(buf, len);
+    uint32 const whole = FPGA_CTRL_Crc32c(0, buf, len);
+    crc                = FPGA_CTRL_Crc32cParallel(buf, len, &threadsUsed);
+    UtAssert_True(crc == whole, "Parallel CRC-32C of %lu bytes = 0x%08lx, serial 0x%08lx", (unsigned long)len,
+                  (unsigned long)crc, (unsigned long)whole);
+    UtAssert_True(threadsUsed >= 1 && threadsUsed <= FPGA_CTRL_CRC32C_MAX_THREADS, "Split across %lu threads",
+                  (unsigned long)threadsUsed);
+
+    free(buf);
+}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(FPGA_CTRL_Crc32c);
+    ADD_TEST(FPGA_CTRL_Crc32cImplementations);
+    ADD_TEST(FPGA_CTRL_Crc32cCombine);
+    ADD_TEST(FPGA_CTRL_Crc32cParallel);
+}
@@ -0,0 +1,327 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_fpga_ctrl_lz4.c
+**
+** Purpose:
+** Coverage Unit Test cases for the LZ4 frame decoder (fpga_ctrl_lz4.h)
+**
+** Notes:
+** The frames below were written by the lz4 command line tool (v1.9),
+** so the decoder is checked against the reference encoder rather than
+** against itself:
+**
+**   lz4 -9 -BX --content-size text.bin text.lz4
+**     independent blocks, block and content checksums, content size
+**
+**   lz4 -9 -B4 -BD --content-size pattern.bin pattern.lz4
+**     linked 64 KB blocks, content checksum, content size, where
+**     pattern.bin is 150000 bytes of (offset % 251)
+*/
+
+/*
+ * Includes
+ */
+
+#include <string.h>
+
+#include "fpga_ctrl_coveragetest_common.h"
+#include "fpga_ctrl_lz4.h"
+
+#define UT_LZ4_PATTERN_SIZE 150000
+
+static char const UT_Lz4Text[] = "FPGA_CTRL bitstream bitstream bitstream bitstream, one frame from the lz4 tool.\n";
+
+static uint8 const UT_Lz4TextFrame[] = {
+    0x04, 0x22, 0x4d, 0x18, 0x7c, 0x40, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x54, 0x38,
+    0x00, 0x00, 0x00, 0xff, 0x04, 0x46, 0x50, 0x47, 0x41, 0x5f, 0x43, 0x54, 0x52, 0x4c, 0x20, 0x62,
+    0x69, 0x74, 0x73, 0x74, 0x72, 0x65, 0x61, 0x6d, 0x0a, 0x00, 0x0b, 0xa0, 0x2c, 0x20, 0x6f, 0x6e,
+    0x65, 0x20, 0x66, 0x72, 0x61, 0x6d, 0x06, 0x00, 0xf0, 0x02, 0x6f, 0x6d, 0x20, 0x74, 0x68, 0x65,
+    0x20, 0x6c, 0x7a, 0x34, 0x20, 0x74, 0x6f, 0x6f, 0x6c, 0x2e, 0x0a, 0x5d, 0x63, 0x0d, 0x5e, 0x00,
+    0x00, 0x00, 0x00, 0xeb, 0x8f, 0x46, 0xab,
+};
+
+static uint8 const UT_Lz4PatternFrame[] = {
+    0x04, 0x22, 0x4d, 0x18, 0x4c, 0x40, 0xf0, 0x49, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1a, 0x05,
+    0x02, 0x00, 0x00, 0xff, 0xec, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+    0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a,
+    0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a,
+    0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a,
+    0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a,
+    0x4b, 0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a,
+    0x5b, 0x5c, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+    0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a,
+    0x7b, 0x7c, 0x7d, 0x7e, 0x7f, 0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a,
+    0x8b, 0x8c, 0x8d, 0x8e, 0x8f, 0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0x9b, 0x9c, 0x9d, 0x9e, 0x9f, 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa,
+    0xab, 0xac, 0xad, 0xae, 0xaf, 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+    0xbb, 0xbc, 0xbd, 0xbe, 0xbf, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca,
+    0xcb, 0xcc, 0xcd, 0xce, 0xcf, 0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xdb, 0xdc, 0xdd, 0xde, 0xdf, 0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea,
+    0xeb, 0xec, 0xed, 0xee, 0xef, 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+    0xfb, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xec, 0x50, 0x14, 0x15, 0x16, 0x17, 0x18, 0x0a, 0x01, 0x00, 0x00, 0x0f, 0xfb, 0x00, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe8,
+    0x50, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x54, 0x00, 0x00, 0x00, 0x0f, 0xfb, 0x00, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x22, 0x50, 0x94, 0x95, 0x96, 0x97, 0x98, 0x00, 0x00,
+    0x00, 0x00, 0x42, 0x4c, 0x5f, 0x3d,
+};
+
+/*
+ * Collects what the decoder passes to its sink
+ */
+typedef struct
+{
+    uint8  out[UT_LZ4_PATTERN_SIZE];
+    size_t outLen;
+    uint32 calls;
+    int32  status; // Returned from every call
+} UT_Lz4Sink_t;
+
+static UT_Lz4Sink_t UT_Lz4Output;
+
+static int32 UT_Lz4Sink(void *ctx, void const *data, size_t len)
+{
+    UT_Lz4Sink_t *const sink = ctx;
+
+    ++sink->calls;
+    if (sink->status != CFE_SUCCESS)
+        return sink->status;
+
+    UtAssert_True(len <= sizeof(sink->out) - sink->outLen, "Sink given %lu bytes after %lu", (unsigned long)len,
+                  (unsigned long)sink->outLen);
+    if (len <= sizeof(sink->out) - sink->outLen)
+    {
+        memcpy(sink->out + sink->outLen, data, len);
+        sink->outLen += len;
+    }
+    return CFE_SUCCESS;
+}
+
+/*
+ * Decodes a corrupted copy of frame, expecting status and a single event
+ */
+static void UT_Lz4DecodeCorrupt(uint8 const *frame, size_t size, size_t offset, uint8 xorMask, int32 status)
+{
+    static uint8 copy[sizeof(UT_Lz4PatternFrame)];
+    uint64       rawSize;
+
+    memcpy(copy, frame, size);
+    copy[offset] ^= xorMask;
+
+    UT_ResetState(UT_KEY(CFE_EVS_SendEvent));
+    memset(&UT_Lz4Output, 0, sizeof(UT_Lz4Output));
+    UT_TEST_FUNCTION_RC(FPGA_CTRL_Lz4Decompress(copy, size, UT_Lz4Sink, &UT_Lz4Output, &rawSize), status);
+    UT_CHECK_EVENT_COUNT(1);
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_FPGA_CTRL_Lz4IsFrame(void)
+{
+    /*
+     * Test Case For:
+     * bool FPGA_CTRL_Lz4IsFrame(uint8 const *data, size_t size)
+     * uint64 FPGA_CTRL_Lz4ContentSize(uint8 const *data, size_t size)
+     */
+    static uint8 const notFrame[] = {'B', 'I', 'T', 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                     0x00};
+
+    UtAssert_True(FPGA_CTRL_Lz4IsFrame(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame)), "Text frame recognised");
+    UtAssert_True(!FPGA_CTRL_Lz4IsFrame(UT_Lz4TextFrame, 3), "Frame shorter than its magic refused");
+    UtAssert_True(!FPGA_CTRL_Lz4IsFrame(notFrame, sizeof(notFrame)), "Raw bitstream not taken for a frame");
+
+    UtAssert_True(FPGA_CTRL_Lz4ContentSize(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame)) == sizeof(UT_Lz4Text) - 1,
+                  "Text frame content size");
+    UtAssert_True(FPGA_CTRL_Lz4ContentSize(UT_Lz4PatternFrame, sizeof(UT_Lz4PatternFrame)) == UT_LZ4_PATTERN_SIZE,
+                  "Pattern frame content size");
+    UtAssert_True(FPGA_CTRL_Lz4ContentSize(notFrame, sizeof(notFrame)) == 0, "No content size outside a frame");
+}
+
+void Test_FPGA_CTRL_Lz4Decompress(void)
+{
+    /*
+     * Test Case For:
+     * int32 FPGA_CTRL_Lz4Decompress(uint8 const *data, size_t size, FPGA_CTRL_Lz4Sink_t sink, void *ctx,
+     *                               uint64 *rawSize)
+     */
+    uint64 rawSize;
+    bool   matches = true;
+
+    /* Independent blocks with block checksums */
+    memset(&UT_Lz4Output, 0, sizeof(UT_Lz4Output));
+    UT_TEST_FUNCTION_RC(
+        FPGA_CTRL_Lz4Decompress(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), UT_Lz4Sink, &UT_Lz4Output, &rawSize),
+        CFE_SUCCESS);
+    UtAssert_True(rawSize == sizeof(UT_Lz4Text) - 1, "Text frame decoded to %lu bytes", (unsigned long)rawSize);
+    UtAssert_True(UT_Lz4Output.outLen == sizeof(UT_Lz4Text) - 1 &&
+                      memcmp(UT_Lz4Output.out, UT_Lz4Text, sizeof(UT_Lz4Text) - 1) == 0,
+                  "Text frame decoded to the original");
+
+    /* Linked blocks, matches reaching back into the previous block */
+    memset(&UT_Lz4Output, 0, sizeof(UT_Lz4Output));
+    UT_TEST_FUNCTION_RC(FPGA_CTRL_Lz4Decompress(UT_Lz4PatternFrame, sizeof(UT_Lz4PatternFrame), UT_Lz4Sink,
+                                                &UT_Lz4Output, &rawSize),
+                        CFE_SUCCESS);
+    UtAssert_True(rawSize == UT_LZ4_PATTERN_SIZE, "Pattern frame decoded to %lu bytes", (unsigned long)rawSize);
+    UtAssert_True(UT_Lz4Output.calls == 3, "Pattern frame delivered as its 3 blocks (%lu)",
+                  (unsigned long)UT_Lz4Output.calls);
+    for (size_t i = 0; i < UT_Lz4Output.outLen; ++i)
+    {
+        if (UT_Lz4Output.out[i] != (uint8)(i % 251))
+        {
+            matches = false;
+            break;
+        }
+    }
+    UtAssert_True(matches && UT_Lz4Output.outLen == UT_LZ4_PATTERN_SIZE, "Pattern frame decoded to the original");
+
+    UT_CHECK_EVENT_COUNT(0);
+}
+
+void Test_FPGA_CTRL_Lz4DecompressCorrupt(void)
+{
+    /*
+     * Test Case For:
+     * int32 FPGA_CTRL_Lz4Decompress(uint8 const *data, size_t size, FPGA_CTRL_Lz4Sink_t sink, void *ctx,
+     *                               uint64 *rawSize)
+     */
+    uint64 rawSize;
+
+    /* Truncated, before and after the end mark */
+    memset(&UT_Lz4Output, 0, sizeof(UT_Lz4Output));
+    UT_TEST_FUNCTION_RC(FPGA_CTRL_Lz4Decompress(UT_Lz4TextFrame, 6, UT_Lz4Sink, &UT_Lz4Output, &rawSize),
+                        CFE_STATUS_VALIDATION_FAILURE);
+    UT_ResetState(UT_KEY(CFE_EVS_SendEvent));
+    UT_TEST_FUNCTION_RC(
+        FPGA_CTRL_Lz4Decompress(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame) - 1, UT_Lz4Sink, &UT_Lz4Output, &rawSize),
+        CFE_STATUS_VALIDATION_FAILURE);
+    UT_CHECK_EVENT_COUNT(1);
+
+    /* Header checksum, first block's size, block checksum and content checksum */
+    UT_Lz4DecodeCorrupt(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), 14, 0x01, CFE_STATUS_VALIDATION_FAILURE);
+    UT_Lz4DecodeCorrupt(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), 15, 0x40, CFE_STATUS_VALIDATION_FAILURE);
+    UT_Lz4DecodeCorrupt(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), 30, 0x01, CFE_STATUS_VALIDATION_FAILURE);
+    UT_Lz4DecodeCorrupt(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), sizeof(UT_Lz4TextFrame) - 1, 0x01,
+                        CFE_STATUS_VALIDATION_FAILURE);
+    UT_Lz4DecodeCorrupt(UT_Lz4PatternFrame, sizeof(UT_Lz4PatternFrame), sizeof(UT_Lz4PatternFrame) - 1, 0x01,
+                        CFE_STATUS_VALIDATION_FAILURE);
+
+    /* Content size in the header not matching the content, with the header checksum redone to suit */
+    static uint8 badSize[sizeof(UT_Lz4TextFrame)];
+    memcpy(badSize, UT_Lz4TextFrame, sizeof(badSize));
+    badSize[6] += 1;
+    badSize[14] = (FPGA_CTRL_Xxh32(badSize + 4, 10) >> 8) & 0xFF;
+    UT_ResetState(UT_KEY(CFE_EVS_SendEvent));
+    memset(&UT_Lz4Output, 0, sizeof(UT_Lz4Output));
+    UT_TEST_FUNCTION_RC(FPGA_CTRL_Lz4Decompress(badSize, sizeof(badSize), UT_Lz4Sink, &UT_Lz4Output, &rawSize),
+                        CFE_STATUS_VALIDATION_FAILURE);
+    UT_CHECK_EVENT_COUNT(1);
+}
+
+void Test_FPGA_CTRL_Lz4DecompressReserved(void)
+{
+    /*
+     * Test Case For:
+     * int32 FPGA_CTRL_Lz4Decompress(uint8 const *data, size_t size, FPGA_CTRL_Lz4Sink_t sink, void *ctx,
+     *                               uint64 *rawSize)
+     */
+
+    /* Refused on the descriptor alone, whatever the header checksum says */
+    UT_Lz4DecodeCorrupt(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), 4, FPGA_CTRL_LZ4_FLG_RESERVED,
+                        CFE_STATUS_VALIDATION_FAILURE);
+    UT_Lz4DecodeCorrupt(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), 5, 0x80, CFE_STATUS_VALIDATION_FAILURE);
+    UT_Lz4DecodeCorrupt(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), 5, 0x01, CFE_STATUS_VALIDATION_FAILURE);
+    UT_Lz4DecodeCorrupt(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), 4, FPGA_CTRL_LZ4_FLG_DICT_ID,
+                        CFE_STATUS_VALIDATION_FAILURE);
+    UT_Lz4DecodeCorrupt(UT_Lz4TextFrame, sizeof(UT_Lz4TextFrame), 4, 0x80, CFE_STATUS_VALIDATION_FAILURE);
+    UtAssert_True(UT_Lz4Output.calls == 0, "Nothing decoded from a refused frame");
+}
+
+void Test_FPGA_CTRL_Lz4DecompressSinkFailure(void)
+{
+    /*
+     * Test Case For:
+     * int32 FPGA_CTRL_Lz4Decompress(uint8 const *data, size_t size, FPGA_CTRL_Lz4Sink_t sink, void *ctx,
+     *                               uint64 *rawSize)
+     */
+    uint64 rawSize;
+
+    /* The sink's own status comes back, not a validation failure */
+    memset(&UT_Lz4Output, 0, sizeof(UT_Lz4Output));
+    UT_Lz4Output.status = CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+    UT_TEST_FUNCTION_RC(FPGA_CTRL_Lz4Decompress(UT_Lz4PatternFrame, sizeof(UT_Lz4PatternFrame), UT_Lz4Sink,
+                                                &UT_Lz4Output, &rawSize),
+                        CFE_STATUS_EXTERNAL_RESOURCE_FAIL);
+    UtAssert_True(UT_Lz4Output.calls == 1, "Decoding stopped at the first refused block");
+    UtAssert_True(rawSize == 0, "Refused block not counted as output");
+    UT_CHECK_EVENT_COUNT(1);
+}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(FPGA_CTRL_Lz4IsFrame);
+    ADD_TEST(FPGA_CTRL_Lz4Decompress);
+    ADD_TEST(FPGA_CTRL_Lz4DecompressCorrupt);
+    ADD_TEST(FPGA_CTRL_Lz4DecompressReserved);
+    ADD_TEST(FPGA_CTRL_Lz4DecompressSinkFailure);
+}
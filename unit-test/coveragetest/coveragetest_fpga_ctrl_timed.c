@@ -0,0 +1,258 @@
+/*
+**  GSC-18128-1, "Core Flight Executive Version 6.7"
+**
+**  Copyright (c) 2006-2019 United States Government as represented by
+**  the Administrator of the National Aeronautics and Space Administration.
+**  All Rights Reserved.
+**
+**  Licensed under the Apache License, Version 2.0 (the "License");
+**  you may not use this file except in compliance with the License.
+**  You may obtain a copy of the License at
+**
+**    http://www.apache.org/licenses/LICENSE-2.0
+**
+**  Unless required by applicable law or agreed to in writing, software
+**  distributed under the License is distributed on an "AS IS" BASIS,
+**  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**  See the License for the specific language governing permissions and
+**  limitations under the License.
+*/
+
+/*
+** File: coveragetest_fpga_ctrl_timed.c
+**
+** Purpose:
+** Coverage Unit Test cases for the timer wheel of the time-tagged
+** command queue (fpga_ctrl_timed.h)
+**
+** Notes:
+** The wheel is driven directly with made up times, the child task
+** that normally advances it is never started. The wheel starts at
+** tick 1000, which isn't on a slot boundary of any level, so entries
+** go into upper level slots part way through their turn and cascade
+** from them early.
+*/
+
+/*
+ * Includes
+ */
+
+#include <string.h>
+
+#include "fpga_ctrl_coveragetest_common.h"
+
+/*
+ * Provided to fpga_ctrl_timed.h by fpga_ctrl_irq_source.h and fpga_ctrl_sched.h in the app
+ */
+static int64 FPGA_CTRL_MonotonicNs(void)
+{
+    return 0;
+}
+
+void FPGA_CTRL_ApplyChildSchedProfile(uint32 cpuMask) {}
+
+#include "fpga_ctrl_timed.h"
+
+#define UT_WHEEL_START_TICK 1000
+#define UT_WHEEL_BASE_NS    5000000000LL                                           // An arbitrary start of tick 0
+#define UT_WHEEL_SPAN       (1ULL << (FPGA_CTRL_WHEEL_BITS * FPGA_CTRL_WHEEL_LEVELS)) // Ticks in a top level turn
+
+/*
+ * Where an entry queued delta ticks after UT_WHEEL_START_TICK is expected to be filed
+ */
+typedef struct
+{
+    uint64 delta;
+    int    level;
+    uint32 slot;
+} UT_WheelPlace_t;
+
+static FPGA_CTRL_TimedEntry_t UT_WheelEntries[8];
+
+/*
+ * Empties the wheel and sets it to start at tick
+ */
+static void UT_WheelReset(uint64 tick)
+{
+    memset(&timedQueue, 0, sizeof(timedQueue));
+    memset(UT_WheelEntries, 0, sizeof(UT_WheelEntries));
+    timedQueue.tick   = tick;
+    timedQueue.baseNs = UT_WHEEL_BASE_NS;
+}
+
+/*
+ * Deadline half way through the tick delta ticks on from the wheel's current one
+ */
+static int64 UT_WheelDeadlineNs(uint64 delta)
+{
+    return timedQueue.baseNs + (int64)((timedQueue.tick + delta) * FPGA_CTRL_WHEEL_TICK_NS) +
+           FPGA_CTRL_WHEEL_TICK_NS / 2;
+}
+
+/*
+ * Queues entry for deadlineNs the way FPGA_CTRL_ScheduleTimedCmd() does
+ */
+static void UT_WheelQueue(FPGA_CTRL_TimedEntry_t *entry, int64 deadlineNs)
+{
+    entry->deadlineNs  = deadlineNs;
+    entry->expiresTick = (uint64)(deadlineNs - timedQueue.baseNs) / FPGA_CTRL_WHEEL_TICK_NS;
+    FPGA_CTRL_WheelInsert(entry);
+    ++timedQueue.inWheel;
+}
+
+/*
+ * Whether entry is on the list of the given slot
+ */
+static bool UT_WheelHolds(int level, uint32 slot, FPGA_CTRL_TimedEntry_t const *entry)
+{
+    for (FPGA_CTRL_TimedEntry_t const *e = timedQueue.slots[level][slot]; e != NULL; e = e->next)
+    {
+        if (e == entry)
+            return true;
+    }
+    return false;
+}
+
+/*
+**********************************************************************************
+**          TEST CASE FUNCTIONS
+**********************************************************************************
+*/
+
+void Test_FPGA_CTRL_WheelInsert(void)
+{
+    /*
+     * Test Case For:
+     * static void FPGA_CTRL_WheelInsert(FPGA_CTRL_TimedEntry_t *entry)
+     */
+    static UT_WheelPlace_t const places[] = {
+        {0, 0, 40},                   /* Due in the current tick */
+        {63, 0, 39},                  /* Last tick level 0 reaches */
+        {64, 1, 16},                  /* First tick past level 0 */
+        {4095, 1, 15},                /* Last tick level 1 reaches, in the slot the wheel is part way through */
+        {4096, 2, 1},                 /* First tick past level 1 */
+        {UT_WHEEL_SPAN - 1, 3, 0},    /* Last tick the wheel reaches */
+        {UT_WHEEL_SPAN, 3, 0},        /* Beyond the wheel, parked in the last slot of its turn */
+        {UT_WHEEL_SPAN + 5000, 3, 0}, /* Further beyond, parked in the same slot */
+    };
+
+    for (size_t i = 0; i < sizeof(places) / sizeof(places[0]); ++i)
+    {
+        UT_WheelReset(UT_WHEEL_START_TICK);
+        UT_WheelQueue(&UT_WheelEntries[0], UT_WheelDeadlineNs(places[i].delta));
+
+        UtAssert_True(UT_WheelHolds(places[i].level, places[i].slot, &UT_WheelEntries[0]),
+                      "Delta %llu filed at level %d slot %lu", (unsigned long long)places[i].delta, places[i].level,
+                      (unsigned long)places[i].slot);
+    }
+
+    /* A tag already passed goes in the current tick's slot rather than a turn ahead */
+    UT_WheelReset(UT_WHEEL_START_TICK);
+    UT_WheelQueue(&UT_WheelEntries[0], UT_WheelDeadlineNs(0) - 5 * FPGA_CTRL_WHEEL_TICK_NS);
+    UtAssert_True(UT_WheelHolds(0, UT_WHEEL_START_TICK & FPGA_CTRL_WHEEL_MASK, &UT_WheelEntries[0]),
+                  "Passed tag filed in the current slot");
+}
+
+void Test_FPGA_CTRL_WheelAdvance(void)
+{
+    /*
+     * Test Case For:
+     * static void FPGA_CTRL_WheelAdvance(int64 nowNs, FPGA_CTRL_TimedEntry_t **expired)
+     */
+    static uint64 const deltas[] = {0, 1, 63, 64, 65, 4095, 4096, 4097, UT_WHEEL_SPAN - 1, UT_WHEEL_SPAN,
+                                    UT_WHEEL_SPAN + 5000};
+
+    for (size_t i = 0; i < sizeof(deltas) / sizeof(deltas[0]); ++i)
+    {
+        FPGA_CTRL_TimedEntry_t *expired = NULL;
+
+        UT_WheelReset(UT_WHEEL_START_TICK);
+        int64 const deadlineNs = UT_WheelDeadlineNs(deltas[i]);
+        UT_WheelQueue(&UT_WheelEntries[0], deadlineNs);
+
+        /* Cascaded down through the levels but not yet due, the deadline being part way through its tick */
+        FPGA_CTRL_WheelAdvance(deadlineNs - 1, &expired);
+        UtAssert_True(expired == NULL && timedQueue.inWheel == 1, "Delta %llu still queued 1 ns before its deadline",
+                      (unsigned long long)deltas[i]);
+        UtAssert_True(UT_WheelHolds(0, UT_WheelEntries[0].expiresTick & FPGA_CTRL_WHEEL_MASK, &UT_WheelEntries[0]),
+                      "Delta %llu cascaded to its level 0 slot", (unsigned long long)deltas[i]);
+
+        FPGA_CTRL_WheelAdvance(deadlineNs, &expired);
+        UtAssert_True(expired == &UT_WheelEntries[0] && expired->next == NULL && timedQueue.inWheel == 0,
+                      "Delta %llu expired at its deadline", (unsigned long long)deltas[i]);
+        UtAssert_True(timedQueue.tick == UT_WHEEL_START_TICK + deltas[i], "Wheel at tick %llu",
+                      (unsigned long long)timedQueue.tick);
+    }
+
+    /* Passed tags expire on the next advance */
+    FPGA_CTRL_TimedEntry_t *expired = NULL;
+    UT_WheelReset(UT_WHEEL_START_TICK);
+    UT_WheelQueue(&UT_WheelEntries[0], UT_WheelDeadlineNs(0) - 5 * FPGA_CTRL_WHEEL_TICK_NS);
+    FPGA_CTRL_WheelAdvance(UT_WheelDeadlineNs(0) - FPGA_CTRL_WHEEL_TICK_NS / 2, &expired);
+    UtAssert_True(expired == &UT_WheelEntries[0] && timedQueue.inWheel == 0, "Passed tag expired straight away");
+}
+
+void Test_FPGA_CTRL_WheelAdvanceOrder(void)
+{
+    /*
+     * Test Case For:
+     * static void FPGA_CTRL_WheelAdvance(int64 nowNs, FPGA_CTRL_TimedEntry_t **expired)
+     */
+    static uint64 const deltas[] = {4096, 63, 64, 4095, 0, 63, UT_WHEEL_SPAN};
+    FPGA_CTRL_TimedEntry_t *expired = NULL;
+    uint32                  count   = 0;
+    bool                    ordered = true;
+
+    /* Queued out of order, two in the same tick a few ns apart */
+    UT_WheelReset(UT_WHEEL_START_TICK);
+    for (size_t i = 0; i < sizeof(deltas) / sizeof(deltas[0]); ++i)
+        UT_WheelQueue(&UT_WheelEntries[i], UT_WheelDeadlineNs(deltas[i]) - (int64)i);
+
+    FPGA_CTRL_WheelAdvance(UT_WheelDeadlineNs(UT_WHEEL_SPAN), &expired);
+    for (FPGA_CTRL_TimedEntry_t const *e = expired; e != NULL; e = e->next)
+    {
+        if (e->next != NULL && e->next->deadlineNs < e->deadlineNs)
+            ordered = false;
+        ++count;
+    }
+    UtAssert_True(count == sizeof(deltas) / sizeof(deltas[0]) && timedQueue.inWheel == 0, "All %lu expired",
+                  (unsigned long)count);
+    UtAssert_True(ordered, "Expired earliest first");
+}
+
+void Test_FPGA_CTRL_WheelNextWakeNs(void)
+{
+    /*
+     * Test Case For:
+     * static int64 FPGA_CTRL_WheelNextWakeNs(void)
+     */
+    int64 wakeNs;
+
+    UT_WheelReset(UT_WHEEL_START_TICK);
+    UtAssert_True(FPGA_CTRL_WheelNextWakeNs() == -1, "Empty wheel has nothing to wake for");
+
+    /* Only upper levels occupied, wakes at the end of the turn to cascade them */
+    UT_WheelQueue(&UT_WheelEntries[0], UT_WheelDeadlineNs(64));
+    wakeNs = FPGA_CTRL_WheelNextWakeNs();
+    UtAssert_True(wakeNs == UT_WHEEL_BASE_NS + (int64)((UT_WHEEL_START_TICK | FPGA_CTRL_WHEEL_MASK) + 1) *
+                                                   FPGA_CTRL_WHEEL_TICK_NS,
+                  "Wakes at the end of the level 0 turn");
+
+    /* The earliest deadline of the next occupied tick, not the start of the tick */
+    UT_WheelQueue(&UT_WheelEntries[1], UT_WheelDeadlineNs(10));
+    UT_WheelQueue(&UT_WheelEntries[2], UT_WheelDeadlineNs(10) - 100);
+    UT_WheelQueue(&UT_WheelEntries[3], UT_WheelDeadlineNs(20));
+    wakeNs = FPGA_CTRL_WheelNextWakeNs();
+    UtAssert_True(wakeNs == UT_WheelDeadlineNs(10) - 100, "Wakes at the earliest deadline");
+}
+
+/*
+ * Register the test cases to execute with the unit test tool
+ */
+void UtTest_Setup(void)
+{
+    ADD_TEST(FPGA_CTRL_WheelInsert);
+    ADD_TEST(FPGA_CTRL_WheelAdvance);
+    ADD_TEST(FPGA_CTRL_WheelAdvanceOrder);
+    ADD_TEST(FPGA_CTRL_WheelNextWakeNs);
+}
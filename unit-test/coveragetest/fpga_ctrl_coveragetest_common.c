@@ -18,35 +18,28 @@
 **  limitations under the License.
 */
 
-/**
- * @file
- *
- *
- * Purpose:
- * Extra scaffolding functions for the sample_app unit test
- *
- * Notes:
- * This is an extra UT-specific extern declaration
- * to obtain access to an internal data structure
- *
- * UT often needs to modify internal data structures in ways that
- * actual applications never would (bypassing the normal API) in
- * order to exercise or set up for off-nominal cases.
+/*
+** File: fpga_ctrl_coveragetest_common.c
+**
+** Purpose:
+** Setup and teardown shared by the coverage tests of every fpga_ctrl module
+*/
+
+/*
+ * Includes
  */
 
-#ifndef UT_SAMPLE_APP_H
-#define UT_SAMPLE_APP_H
+#include "fpga_ctrl_coveragetest_common.h"
 
 /*
- * Necessary to include these here to get the definition of the
- * "SAMPLE_APP_Data_t" typedef.
+ * Setup function prior to every test
  */
-#include "sample_app_events.h"
-#include "sample_app.h"
+void FPGA_CTRL_UT_Setup(void)
+{
+    UT_ResetState(0);
+}
 
 /*
- * Allow UT access to the global "SAMPLE_APP_Data" object.
+ * Teardown function after every test
  */
-extern SAMPLE_APP_Data_t SAMPLE_APP_Data;
-
-#endif /* UT_SAMPLE_APP_H */
+void FPGA_CTRL_UT_TearDown(void) {}
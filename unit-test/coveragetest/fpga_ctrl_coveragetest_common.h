@@ -21,11 +21,11 @@
 /**
  * @file
  *
- * Common definitions for all sample_app coverage tests
+ * Common definitions for all fpga_ctrl coverage tests
  */
 
-#ifndef SAMPLE_APP_COVERAGETEST_COMMON_H
-#define SAMPLE_APP_COVERAGETEST_COMMON_H
+#ifndef FPGA_CTRL_COVERAGETEST_COMMON_H
+#define FPGA_CTRL_COVERAGETEST_COMMON_H
 
 /*
  * Includes
@@ -36,9 +36,7 @@
 #include "utstubs.h"
 
 #include "cfe.h"
-#include "sample_app_events.h"
-#include "sample_app.h"
-#include "sample_app_table.h"
+#include "fpga_ctrl.h"
 
 /*
  * Macro to call a function and check its int32 return code
@@ -50,19 +48,30 @@
         UtAssert_True(rcact == rcexp, "%s (%ld) == %s (%ld)", #func, (long)rcact, #exp, (long)rcexp); \
     }
 
+/*
+ * Macro to check how many events the unit under test has sent since the last reset
+ */
+#define UT_CHECK_EVENT_COUNT(exp)                                                                     \
+    {                                                                                                 \
+        uint32 cntexp = exp;                                                                          \
+        uint32 cntact = UT_GetStubCount(UT_KEY(CFE_EVS_SendEvent));                                   \
+        UtAssert_True(cntact == cntexp, "CFE_EVS_SendEvent() called %lu times, expected %lu",         \
+                      (unsigned long)cntact, (unsigned long)cntexp);                                  \
+    }
+
 /*
  * Macro to add a test case to the list of tests to execute
  */
-#define ADD_TEST(test) UtTest_Add((Test_##test), Sample_UT_Setup, Sample_UT_TearDown, #test)
+#define ADD_TEST(test) UtTest_Add((Test_##test), FPGA_CTRL_UT_Setup, FPGA_CTRL_UT_TearDown, #test)
 
 /*
  * Setup function prior to every test
  */
-void Sample_UT_Setup(void);
+void FPGA_CTRL_UT_Setup(void);
 
 /*
  * Teardown function after every test
  */
-void Sample_UT_TearDown(void);
+void FPGA_CTRL_UT_TearDown(void);
 
-#endif /* SAMPLE_APP_COVERAGETEST_COMMON_H */
+#endif /* FPGA_CTRL_COVERAGETEST_COMMON_H */